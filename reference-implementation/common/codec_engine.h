@@ -0,0 +1,4353 @@
+// The codec engine shared by all safeXX codecs.
+//
+// Each codec's library.c defines its parameters and then includes this file
+// once, at the end. The parameters are:
+//
+//   CODEC_PREFIX, CODEC_L_PREFIX, CODEC_CONSTANT_PREFIX
+//       The prefixes of the codec's public names (e.g. safe64_, safe64l_,
+//       SAFE64_).
+//   codec_accumulator
+//       An unsigned integer type that can hold a full group.
+//   g_bytes_per_group, g_chunks_per_group, g_chunk_radix,
+//   g_bits_per_length_chunk
+//       The codec geometry, as static const ints.
+//   g_encode_char_to_chunk, g_chunk_to_encode_char
+//       The decode table (including whitespace and substitutions) and the
+//       alphabet.
+//   g_chunk_to_byte_count, g_byte_to_chunk_count
+//       The sizes of partial groups.
+//   CODEC_CHUNKS_PER_WORD, CODEC_WORD_CHUNK_DIVISOR (optional)
+//       For accumulators wider than 64 bits: the number of chunks that fit in
+//       a uint64_t, and the radix raised to that power.
+//   CHUNK_CODE_ERROR, CHUNK_CODE_WHITESPACE
+//       The special values in the decode table.
+//   CODEC_NO_CONTENT_NAMES (optional)
+//       Leaves out content names, for codecs whose alphabet isn't safe for
+//       use in file names.
+//
+// Since the parameters are compile-time constants, every codec gets its own
+// fully specialized copy of the code below, with the per-group loops
+// unrolled.
+
+#define CODEC_PASTE_(A, B) A##B
+#define CODEC_PASTE(A, B) CODEC_PASTE_(A, B)
+#define CODEC_NAME(NAME) CODEC_PASTE(CODEC_PREFIX, NAME)
+#define CODEC_L_NAME(NAME) CODEC_PASTE(CODEC_L_PREFIX, NAME)
+#define CODEC_CONSTANT(NAME) CODEC_PASTE(CODEC_CONSTANT_PREFIX, NAME)
+
+#define QUOTE(str) #str
+#define EXPAND_AND_QUOTE(str) QUOTE(str)
+
+typedef CODEC_NAME(status)            codec_status;
+typedef CODEC_NAME(stream_state)      codec_stream_state;
+typedef CODEC_NAME(allocate_function) codec_allocate_function;
+typedef CODEC_NAME(arena)             codec_arena;
+typedef CODEC_NAME(layout)            codec_layout;
+typedef CODEC_NAME(container)         codec_container;
+typedef CODEC_NAME(alphabet)          codec_alphabet;
+typedef CODEC_NAME(standard_format)   codec_standard_format;
+typedef CODEC_NAME(encode_function)   codec_encode_function;
+typedef CODEC_NAME(transcoder)        codec_transcoder;
+typedef CODEC_NAME(standard_transcoder) codec_standard_transcoder;
+typedef CODEC_NAME(layout_encoder)    codec_layout_encoder;
+typedef CODEC_NAME(container_writer)  codec_container_writer;
+typedef CODEC_L_NAME(decoder)         codecl_decoder;
+typedef CODEC_L_NAME(encoder)         codecl_encoder;
+typedef CODEC_L_NAME(record_span)     codecl_record_span;
+#ifndef CODEC_NO_CONTENT_NAMES
+typedef CODEC_NAME(content_hasher)    codec_content_hasher;
+#endif
+
+#define CODEC_STATUS_OK                       CODEC_CONSTANT(STATUS_OK)
+#define CODEC_STATUS_PARTIALLY_COMPLETE       CODEC_CONSTANT(STATUS_PARTIALLY_COMPLETE)
+#define CODEC_ERROR_INVALID_SOURCE_DATA       CODEC_CONSTANT(ERROR_INVALID_SOURCE_DATA)
+#define CODEC_ERROR_UNTERMINATED_LENGTH_FIELD CODEC_CONSTANT(ERROR_UNTERMINATED_LENGTH_FIELD)
+#define CODEC_ERROR_TRUNCATED_DATA            CODEC_CONSTANT(ERROR_TRUNCATED_DATA)
+#define CODEC_ERROR_INVALID_LENGTH            CODEC_CONSTANT(ERROR_INVALID_LENGTH)
+#define CODEC_ERROR_NOT_ENOUGH_ROOM           CODEC_CONSTANT(ERROR_NOT_ENOUGH_ROOM)
+#define CODEC_ERROR_ALLOCATION_FAILED         CODEC_CONSTANT(ERROR_ALLOCATION_FAILED)
+#define CODEC_ERROR_TOO_MUCH_DATA             CODEC_CONSTANT(ERROR_TOO_MUCH_DATA)
+#define CODEC_ERROR_INVALID_ALPHABET          CODEC_CONSTANT(ERROR_INVALID_ALPHABET)
+#define CODEC_SRC_IS_AT_END_OF_STREAM         CODEC_CONSTANT(SRC_IS_AT_END_OF_STREAM)
+#define CODEC_DST_IS_AT_END_OF_STREAM         CODEC_CONSTANT(DST_IS_AT_END_OF_STREAM)
+#define CODEC_EXPECT_DST_STREAM_TO_END        CODEC_CONSTANT(EXPECT_DST_STREAM_TO_END)
+#define CODEC_STREAM_STATE_NONE               CODEC_CONSTANT(STREAM_STATE_NONE)
+
+static const int g_bits_per_byte = 8;
+
+static inline codec_accumulator accumulate_byte(const codec_accumulator accumulator, const uint8_t byte_value)
+{
+    return (accumulator << g_bits_per_byte) | byte_value;
+}
+
+static inline codec_accumulator accumulate_chunk(const codec_accumulator accumulator, const uint8_t next_chunk)
+{
+    return accumulator * g_chunk_radix + next_chunk;
+}
+
+static inline uint8_t extract_byte_from_accumulator(const codec_accumulator accumulator, const int byte_index_lo_first)
+{
+    return (uint8_t)(accumulator >> (byte_index_lo_first * g_bits_per_byte));
+}
+
+// Writes the lowest chunk_count chunks of a word as characters, most
+// significant chunk first.
+static inline void write_word_chunks(const uint8_t* const chunk_to_char,
+                                     uint64_t word,
+                                     const int chunk_count,
+                                     uint8_t* const dst)
+{
+    for(int i = chunk_count - 1; i >= 0; i--)
+    {
+        dst[i] = chunk_to_char[word % g_chunk_radix];
+        word /= g_chunk_radix;
+    }
+}
+
+// Writes the lowest chunk_count chunks of the accumulator as characters.
+static inline void write_chunks(const uint8_t* const chunk_to_char,
+                                codec_accumulator accumulator,
+                                int chunk_count,
+                                uint8_t* const dst)
+{
+#ifdef CODEC_CHUNKS_PER_WORD
+    // Split a wide accumulator into word-sized pieces first, so that only one
+    // wide division is needed per piece rather than two per chunk.
+    while(chunk_count > CODEC_CHUNKS_PER_WORD)
+    {
+        chunk_count -= CODEC_CHUNKS_PER_WORD;
+        write_word_chunks(chunk_to_char,
+                          (uint64_t)(accumulator % CODEC_WORD_CHUNK_DIVISOR),
+                          CODEC_CHUNKS_PER_WORD,
+                          dst + chunk_count);
+        accumulator /= CODEC_WORD_CHUNK_DIVISOR;
+    }
+#endif
+    write_word_chunks(chunk_to_char, (uint64_t)accumulator, chunk_count, dst);
+}
+
+static inline int calculate_length_chunk_count(int64_t length)
+{
+    int chunk_count = 0;
+    for(uint64_t i = length; i; i >>= g_bits_per_length_chunk, chunk_count++)
+    {
+    }
+
+    if(chunk_count == 0)
+    {
+        chunk_count = 1;
+    }
+
+    return chunk_count;
+}
+
+const char* CODEC_NAME(version)()
+{
+    return EXPAND_AND_QUOTE(PROJECT_VERSION);
+}
+
+int64_t CODEC_NAME(get_decoded_length)(const int64_t encoded_length)
+{
+    if(encoded_length < 0)
+    {
+        return CODEC_ERROR_INVALID_LENGTH;
+    }
+    const int64_t group_count = encoded_length / g_chunks_per_group;
+    const int byte_count = g_chunk_to_byte_count[encoded_length % g_chunks_per_group];
+    const int64_t result = group_count * g_bytes_per_group + byte_count;
+
+    KSLOG_DEBUG("Encoded Length %d, groups %d, mod %d, byte_count %d, result %d",
+        encoded_length, group_count, encoded_length % g_chunks_per_group, byte_count, result);
+    return result;
+}
+
+// Decodes using the specified decode table (the built-in one, or a custom
+// alphabet's).
+static codec_status decode_feed_with_table(const uint8_t* const char_to_chunk,
+                                           const uint8_t** const src_buffer_ptr,
+                                           const int64_t src_length,
+                                           uint8_t** const dst_buffer_ptr,
+                                           const int64_t dst_length,
+                                           const codec_stream_state stream_state)
+{
+    const uint8_t* src = *src_buffer_ptr;
+    uint8_t* dst = *dst_buffer_ptr;
+
+    const uint8_t* const src_end = src + src_length;
+    const uint8_t* const dst_end = dst + dst_length;
+
+    KSLOG_DEBUG("Decode %d chars into %d bytes, stream state %d",
+                src_end - src, dst_end - dst, stream_state);
+
+    #define WRITE_BYTES(CHUNK_COUNT) \
+    { \
+        const int bytes_to_write = g_chunk_to_byte_count[CHUNK_COUNT]; \
+        KSLOG_DEBUG("Writing %d chunks as %d decoded bytes", CHUNK_COUNT, bytes_to_write); \
+        for(int i = bytes_to_write - 1; i >= 0; i--) \
+        { \
+            *dst++ = extract_byte_from_accumulator(accumulator, i); \
+            KSLOG_DEBUG("Wrote byte %02x to index %d", dst[-1], i); \
+        } \
+    }
+
+    const uint8_t* last_src = src;
+    int current_group_chunk_count = 0;
+    codec_accumulator accumulator = 0;
+
+    while(src < src_end)
+    {
+        if(current_group_chunk_count == 0 &&
+           src_end - src >= g_chunks_per_group &&
+           dst_end - dst > g_bytes_per_group)
+        {
+            // Whole groups without whitespace are decoded in one go. Chunk
+            // values are all below 0x80 and both chunk codes have the high bit
+            // set, so a single check covers the entire group.
+            uint8_t chunk_bits = 0;
+            for(int i = 0; i < g_chunks_per_group; i++)
+            {
+                const uint8_t next_chunk = char_to_chunk[src[i]];
+                chunk_bits |= next_chunk;
+                accumulator = accumulate_chunk(accumulator, next_chunk);
+            }
+            if((chunk_bits & 0x80) == 0)
+            {
+                src += g_chunks_per_group;
+                WRITE_BYTES(g_chunks_per_group);
+                accumulator = 0;
+                last_src = src;
+                continue;
+            }
+            accumulator = 0;
+        }
+
+        const uint8_t next_char = *src++;
+        const uint8_t next_chunk = char_to_chunk[next_char];
+        if(next_chunk == CHUNK_CODE_WHITESPACE)
+        {
+            KSLOG_TRACE("Whitespace");
+            continue;
+        }
+        if(next_chunk == CHUNK_CODE_ERROR)
+        {
+            KSLOG_DEBUG("Error: Invalid source data: %02x: [%c]", next_char, next_char);
+            *src_buffer_ptr = src - 1;
+            *dst_buffer_ptr = dst;
+            return CODEC_ERROR_INVALID_SOURCE_DATA;
+        }
+        accumulator = accumulate_chunk(accumulator, next_chunk);
+        current_group_chunk_count++;
+        KSLOG_DEBUG("Accumulated chunk %d of %d", current_group_chunk_count, g_chunks_per_group);
+        if(dst + g_chunk_to_byte_count[current_group_chunk_count] >= dst_end)
+        {
+            break;
+        }
+        if(current_group_chunk_count == g_chunks_per_group)
+        {
+            WRITE_BYTES(current_group_chunk_count);
+            current_group_chunk_count = 0;
+            accumulator = 0;
+            last_src = src;
+        }
+    }
+
+    // Skip over any trailing whitespace. last_src stays at the start of the
+    // unwritten group so that the caller feeds it again next time.
+    for(; src < src_end; src++)
+    {
+        if(char_to_chunk[*src] != CHUNK_CODE_WHITESPACE)
+        {
+            break;
+        }
+    }
+
+    bool src_is_at_end = (stream_state & CODEC_SRC_IS_AT_END_OF_STREAM) && src >= src_end;
+    bool dst_is_at_end = (stream_state & CODEC_DST_IS_AT_END_OF_STREAM) && dst + g_chunk_to_byte_count[current_group_chunk_count] >= dst_end;
+
+    if(current_group_chunk_count > 0 && (src_is_at_end || dst_is_at_end))
+    {
+        KSLOG_DEBUG("End of stream. Writing remaining chunks");
+        WRITE_BYTES(current_group_chunk_count);
+        last_src = src;
+        dst_is_at_end = (stream_state & CODEC_DST_IS_AT_END_OF_STREAM) && dst >= dst_end;
+    }
+
+    KSLOG_DEBUG("At end of feed. processed %d src bytes and %d dst bytes",
+        last_src - *src_buffer_ptr, dst - *dst_buffer_ptr);
+
+    *src_buffer_ptr = last_src;
+    *dst_buffer_ptr = dst;
+
+    if(src_is_at_end || dst_is_at_end)
+    {
+        if(stream_state & CODEC_EXPECT_DST_STREAM_TO_END)
+        {
+            if(dst_is_at_end)
+            {
+                KSLOG_DEBUG("OK: Dest is at end of stream & controls end of stream");
+                return CODEC_STATUS_OK;
+            }
+            else
+            {
+                KSLOG_DEBUG("Error: Dest controls end of stream, but source is at end");
+                return CODEC_ERROR_TRUNCATED_DATA;
+            }
+        }
+        else
+        {
+            if(src_is_at_end)
+            {
+                KSLOG_DEBUG("OK: Source is at end of stream & controls end of stream");
+                return CODEC_STATUS_OK;
+            }
+            else
+            {
+                KSLOG_DEBUG("Error: Source controls end of stream, but dest is at end");
+                return CODEC_ERROR_NOT_ENOUGH_ROOM;
+            }
+        }
+    }
+
+    KSLOG_DEBUG("Decode partially complete");
+    return CODEC_STATUS_PARTIALLY_COMPLETE;
+
+    #undef WRITE_BYTES
+}
+
+static inline codec_status decode_feed(const uint8_t** const src_buffer_ptr,
+                                       const int64_t src_length,
+                                       uint8_t** const dst_buffer_ptr,
+                                       const int64_t dst_length,
+                                       const codec_stream_state stream_state)
+{
+    return decode_feed_with_table(g_encode_char_to_chunk,
+                                  src_buffer_ptr,
+                                  src_length,
+                                  dst_buffer_ptr,
+                                  dst_length,
+                                  stream_state);
+}
+
+codec_status CODEC_NAME(decode_feed)(const uint8_t** const src_buffer_ptr,
+                                     const int64_t src_length,
+                                     uint8_t** const dst_buffer_ptr,
+                                     const int64_t dst_length,
+                                     const codec_stream_state stream_state)
+{
+    if(src_length < 0 || dst_length < 0)
+    {
+        return CODEC_ERROR_INVALID_LENGTH;
+    }
+    return decode_feed(src_buffer_ptr, src_length, dst_buffer_ptr, dst_length, stream_state);
+}
+
+int64_t CODEC_NAME(read_length_field)(const uint8_t* const buffer,
+                                      const int64_t buffer_length,
+                                      int64_t* const length)
+{
+    if(buffer_length < 0)
+    {
+        return CODEC_ERROR_INVALID_LENGTH;
+    }
+    const int64_t max_pre_append_value = INT64_MAX >> g_bits_per_length_chunk;
+    const int continuation_bit = 1 << g_bits_per_length_chunk;
+    const int max_chunk_value = continuation_bit - 1;
+    const int chunk_mask = continuation_bit - 1;
+    KSLOG_DEBUG("bits %d, continue %02x, mask %02x",
+                g_bits_per_length_chunk, continuation_bit, chunk_mask);
+
+    const uint8_t* buffer_end = buffer + buffer_length;
+    int64_t value = 0;
+    int next_chunk = 0;
+
+    const uint8_t* src = buffer;
+    while(src < buffer_end)
+    {
+        next_chunk = g_encode_char_to_chunk[(int)*src];
+        if(next_chunk == CHUNK_CODE_WHITESPACE)
+        {
+            src++;
+            continue;
+        }
+        const int chunk_value = next_chunk & ~continuation_bit;
+        if(chunk_value > max_chunk_value)
+        {
+            KSLOG_DEBUG("Error: Invalid length character: [%c]", *src);
+            return CODEC_ERROR_INVALID_SOURCE_DATA;
+        }
+        if(value > max_pre_append_value)
+        {
+            KSLOG_DEBUG("Error: Length field too big");
+            return CODEC_ERROR_INVALID_SOURCE_DATA;            
+        }
+        value = (value << g_bits_per_length_chunk) | (next_chunk & chunk_mask);
+        KSLOG_DEBUG("Chunk %d: '%c' (%d), continue %d, value portion = %d",
+                    src - buffer, *src, next_chunk, next_chunk & continuation_bit,
+                    (next_chunk & chunk_mask));
+        src++;
+        if(!(next_chunk & continuation_bit))
+        {
+            break;
+        }
+    }
+    if(next_chunk & continuation_bit)
+    {
+        KSLOG_DEBUG("Error: Unterminated length field");
+        return CODEC_ERROR_UNTERMINATED_LENGTH_FIELD;
+    }
+    *length = value;
+    KSLOG_DEBUG("Length = %d, chunks = %d", value, src - buffer);
+    return src - buffer;
+}
+
+int64_t CODEC_NAME(decode)(const uint8_t* const src_buffer,
+                           const int64_t src_length,
+                           uint8_t* const dst_buffer,
+                           const int64_t dst_length)
+{
+    if(src_length < 0 || dst_length < 0)
+    {
+        return CODEC_ERROR_INVALID_LENGTH;
+    }
+    const uint8_t* src = src_buffer;
+    uint8_t* dst = dst_buffer;
+    const codec_status status = CODEC_NAME(decode_feed)(
+                                    &src,
+                                    src_length,
+                                    &dst,
+                                    dst_length,
+                                    (codec_stream_state)(CODEC_SRC_IS_AT_END_OF_STREAM | CODEC_DST_IS_AT_END_OF_STREAM));
+    if(status != CODEC_STATUS_OK)
+    {
+        if(status == CODEC_STATUS_PARTIALLY_COMPLETE)
+        {
+            return CODEC_ERROR_NOT_ENOUGH_ROOM;
+        }
+        return status;
+    }
+    int64_t decoded_byte_count = dst - dst_buffer;
+    KSLOG_DEBUG("Decoded %d bytes", decoded_byte_count);
+    return decoded_byte_count;
+}
+
+int64_t CODEC_L_NAME(decode)(const uint8_t* const src_buffer,
+                             const int64_t src_length,
+                             uint8_t* const dst_buffer,
+                             const int64_t dst_length)
+{
+    if(src_length < 0 || dst_length < 0)
+    {
+        return CODEC_ERROR_INVALID_LENGTH;
+    }
+    KSLOG_DEBUG("Decode with src buffer length %ld, dst buffer length %d", src_length, dst_length);
+    int64_t specified_length = 0;
+    const int64_t bytes_used = CODEC_NAME(read_length_field)(src_buffer, src_length, &specified_length);
+    if(bytes_used < 0)
+    {
+        return bytes_used;
+    }
+    KSLOG_DEBUG("Used %ld bytes to read expected length of %lu", bytes_used, specified_length);
+    const int64_t read_length = src_length - bytes_used;
+    const uint8_t* src = src_buffer + bytes_used;
+    uint8_t* dst = dst_buffer;
+    const codec_status status = CODEC_NAME(decode_feed)(
+                                    &src,
+                                    read_length,
+                                    &dst,
+                                    specified_length,
+                                    (codec_stream_state)(CODEC_SRC_IS_AT_END_OF_STREAM |
+                                                         CODEC_DST_IS_AT_END_OF_STREAM |
+                                                         CODEC_EXPECT_DST_STREAM_TO_END));
+    if(status != CODEC_STATUS_OK)
+    {
+        if(status == CODEC_STATUS_PARTIALLY_COMPLETE)
+        {
+            KSLOG_DEBUG("Error: Partially complete, but expected complete");
+            return CODEC_ERROR_NOT_ENOUGH_ROOM;
+        }
+        return status;
+    }
+    int64_t decoded_byte_count = dst - dst_buffer;
+    if(decoded_byte_count < specified_length)
+    {
+        KSLOG_DEBUG("Error: Expected to decode %lu bytes, but only decoded %lu bytes",
+            specified_length, decoded_byte_count);
+        return CODEC_ERROR_TRUNCATED_DATA;
+    }
+    KSLOG_DEBUG("Decoded %d bytes", decoded_byte_count);
+    return decoded_byte_count;
+}
+
+void CODEC_L_NAME(decoder_init)(codecl_decoder* const decoder)
+{
+    decoder->declared_length = -1;
+    decoder->decoded_length = 0;
+    decoder->length_field_value = 0;
+}
+
+static codec_status feed_length_field(codecl_decoder* const decoder,
+                                      const uint8_t** const src_buffer_ptr,
+                                      const uint8_t* const src_end)
+{
+    const int64_t max_pre_append_value = INT64_MAX >> g_bits_per_length_chunk;
+    const int continuation_bit = 1 << g_bits_per_length_chunk;
+    const int max_chunk_value = continuation_bit - 1;
+    const int chunk_mask = continuation_bit - 1;
+
+    const uint8_t* src = *src_buffer_ptr;
+    while(src < src_end)
+    {
+        const int next_chunk = g_encode_char_to_chunk[*src];
+        if(next_chunk == CHUNK_CODE_WHITESPACE)
+        {
+            src++;
+            continue;
+        }
+        if((next_chunk & ~continuation_bit) > max_chunk_value)
+        {
+            KSLOG_DEBUG("Error: Invalid length character: [%c]", *src);
+            *src_buffer_ptr = src;
+            return CODEC_ERROR_INVALID_SOURCE_DATA;
+        }
+        if(decoder->length_field_value > max_pre_append_value)
+        {
+            KSLOG_DEBUG("Error: Length field too big");
+            *src_buffer_ptr = src;
+            return CODEC_ERROR_INVALID_SOURCE_DATA;
+        }
+        decoder->length_field_value = (decoder->length_field_value << g_bits_per_length_chunk) | (next_chunk & chunk_mask);
+        src++;
+        if(!(next_chunk & continuation_bit))
+        {
+            decoder->declared_length = decoder->length_field_value;
+            KSLOG_DEBUG("Length = %d", decoder->declared_length);
+            break;
+        }
+    }
+    *src_buffer_ptr = src;
+    return CODEC_STATUS_OK;
+}
+
+codec_status CODEC_L_NAME(decode_feed)(codecl_decoder* const decoder,
+                                       const uint8_t** const src_buffer_ptr,
+                                       const int64_t src_length,
+                                       uint8_t** const dst_buffer_ptr,
+                                       const int64_t dst_length,
+                                       const bool is_end_of_data)
+{
+    if(src_length < 0 || dst_length < 0)
+    {
+        return CODEC_ERROR_INVALID_LENGTH;
+    }
+    const uint8_t* const src_end = *src_buffer_ptr + src_length;
+
+    if(decoder->declared_length < 0)
+    {
+        const codec_status status = feed_length_field(decoder, src_buffer_ptr, src_end);
+        if(status != CODEC_STATUS_OK)
+        {
+            return status;
+        }
+        if(decoder->declared_length < 0)
+        {
+            if(is_end_of_data)
+            {
+                KSLOG_DEBUG("Error: Unterminated length field");
+                return CODEC_ERROR_UNTERMINATED_LENGTH_FIELD;
+            }
+            return CODEC_STATUS_PARTIALLY_COMPLETE;
+        }
+    }
+
+    const int64_t remaining_length = decoder->declared_length - decoder->decoded_length;
+    if(remaining_length == 0)
+    {
+        return CODEC_STATUS_OK;
+    }
+
+    // The length field decides where the sequence ends, so the destination
+    // only counts as ending once it can hold everything that's left.
+    int stream_state = CODEC_EXPECT_DST_STREAM_TO_END;
+    int64_t feed_dst_length = dst_length;
+    if(dst_length >= remaining_length)
+    {
+        feed_dst_length = remaining_length;
+        stream_state |= CODEC_DST_IS_AT_END_OF_STREAM;
+    }
+    if(is_end_of_data)
+    {
+        stream_state |= CODEC_SRC_IS_AT_END_OF_STREAM;
+    }
+
+    uint8_t* const dst_start = *dst_buffer_ptr;
+    const codec_status status = decode_feed(src_buffer_ptr,
+                                            src_end - *src_buffer_ptr,
+                                            dst_buffer_ptr,
+                                            feed_dst_length,
+                                            (codec_stream_state)stream_state);
+    decoder->decoded_length += *dst_buffer_ptr - dst_start;
+    KSLOG_DEBUG("Decoded %d of %d bytes", decoder->decoded_length, decoder->declared_length);
+    return status;
+}
+
+int64_t CODEC_NAME(get_encoded_length)(const int64_t decoded_length,
+                                       const bool include_length_field)
+{
+    if(decoded_length < 0)
+    {
+        return CODEC_ERROR_INVALID_LENGTH;
+    }
+    const int64_t group_count = decoded_length / g_bytes_per_group;
+    const int chunk_count = g_byte_to_chunk_count[decoded_length % g_bytes_per_group];
+    int length_chunk_count = 0;
+    if(include_length_field)
+    {
+        length_chunk_count = calculate_length_chunk_count(decoded_length);
+    }
+    KSLOG_DEBUG("Decoded Length %d, groups %d, mod %d, chunk_count %d, length_chunk_count %d, result %d",
+                decoded_length, group_count, decoded_length % g_bytes_per_group, chunk_count,
+                length_chunk_count, group_count * g_bytes_per_group + chunk_count + length_chunk_count);
+    return group_count * g_chunks_per_group + chunk_count + length_chunk_count;
+}
+
+// Encodes using the specified alphabet (the built-in one, or a custom one).
+static codec_status encode_feed_with_table(const uint8_t* const chunk_to_char,
+                                           const uint8_t** const src_buffer_ptr,
+                                           const int64_t src_length,
+                                           uint8_t** const dst_buffer_ptr,
+                                           const int64_t dst_length,
+                                           const bool is_end_of_data)
+{
+    const uint8_t* src = *src_buffer_ptr;
+    uint8_t* dst = *dst_buffer_ptr;
+
+    const uint8_t* const src_end = src + src_length;
+    const uint8_t* const dst_end = dst + dst_length;
+
+    KSLOG_DEBUG("Encode %d bytes into %d encoded chars, ending %d",
+                src_end - src, dst_end - dst, is_end_of_data);
+
+    #define WRITE_CHUNKS(DEC_BYTE_COUNT) \
+    { \
+        int chunks_to_write = g_byte_to_chunk_count[DEC_BYTE_COUNT]; \
+        KSLOG_DEBUG("Writing %d bytes of %lx as %d chunks", DEC_BYTE_COUNT, (uint64_t)accumulator, chunks_to_write); \
+        if(dst + chunks_to_write > dst_end) \
+        { \
+            KSLOG_DEBUG("Error: Need %d chars but only %d available", chunks_to_write, dst_end - dst); \
+            *src_buffer_ptr = last_src; \
+            *dst_buffer_ptr = dst; \
+            return CODEC_STATUS_PARTIALLY_COMPLETE; \
+        } \
+        write_chunks(chunk_to_char, accumulator, chunks_to_write, dst); \
+        dst += chunks_to_write; \
+    }
+
+    // Whole groups that fit are encoded first, in a loop that the constant
+    // group sizes let the compiler unroll completely.
+    const int64_t src_group_count = (src_end - src) / g_bytes_per_group;
+    const int64_t dst_group_count = (dst_end - dst) / g_chunks_per_group;
+    for(int64_t group_count = src_group_count < dst_group_count ? src_group_count : dst_group_count;
+        group_count > 0;
+        group_count--)
+    {
+        codec_accumulator accumulator = 0;
+        for(int i = 0; i < g_bytes_per_group; i++)
+        {
+            accumulator = accumulate_byte(accumulator, *src++);
+        }
+        write_chunks(chunk_to_char, accumulator, g_chunks_per_group, dst);
+        dst += g_chunks_per_group;
+    }
+
+    const uint8_t* last_src = src;
+    int current_group_byte_count = 0;
+    codec_accumulator accumulator = 0;
+
+    while(src < src_end)
+    {
+        const uint8_t next_byte = *src++;
+        accumulator = accumulate_byte(accumulator, next_byte);
+        current_group_byte_count++;
+        KSLOG_DEBUG("Accumulated byte %d of %d", current_group_byte_count, g_bytes_per_group);
+        if(current_group_byte_count == g_bytes_per_group)
+        {
+            WRITE_CHUNKS(current_group_byte_count);
+            current_group_byte_count = 0;
+            accumulator = 0;
+            last_src = src;
+        }
+    }
+
+    if(current_group_byte_count > 0)
+    {
+        if(is_end_of_data)
+        {
+            KSLOG_DEBUG("End of stream. Writing remaining bytes");
+            WRITE_CHUNKS(current_group_byte_count);
+        }
+        else
+        {
+            KSLOG_DEBUG("End of buffer. Not processing remaining bytes");
+            src -= current_group_byte_count;
+        }
+        last_src = src;
+    }
+
+    *src_buffer_ptr = last_src;
+    *dst_buffer_ptr = dst;
+
+    return CODEC_STATUS_OK;
+#undef WRITE_CHUNKS
+}
+
+static inline codec_status encode_feed(const uint8_t** const src_buffer_ptr,
+                                       const int64_t src_length,
+                                       uint8_t** const dst_buffer_ptr,
+                                       const int64_t dst_length,
+                                       const bool is_end_of_data)
+{
+    return encode_feed_with_table(g_chunk_to_encode_char,
+                                  src_buffer_ptr,
+                                  src_length,
+                                  dst_buffer_ptr,
+                                  dst_length,
+                                  is_end_of_data);
+}
+
+codec_status CODEC_NAME(encode_feed)(const uint8_t** const src_buffer_ptr,
+                                     const int64_t src_length,
+                                     uint8_t** const dst_buffer_ptr,
+                                     const int64_t dst_length,
+                                     const bool is_end_of_data)
+{
+    if(src_length < 0 || dst_length < 0)
+    {
+        return CODEC_ERROR_INVALID_LENGTH;
+    }
+    return encode_feed(src_buffer_ptr, src_length, dst_buffer_ptr, dst_length, is_end_of_data);
+}
+
+int64_t CODEC_NAME(write_length_field)(const int64_t length,
+                                       uint8_t* const dst_buffer,
+                                       const int64_t dst_buffer_length)
+{
+    if(dst_buffer_length < 0 || length < 0)
+    {
+        return CODEC_ERROR_INVALID_LENGTH;
+    }
+    const int continuation_bit = 1 << g_bits_per_length_chunk;
+    const int chunk_mask = continuation_bit - 1;
+    KSLOG_DEBUG("bits %d, continue %02x, mask %02x", g_bits_per_length_chunk, continuation_bit, chunk_mask);
+
+    int chunk_count = 0;
+    for(uint64_t i = length; i; i >>= g_bits_per_length_chunk, chunk_count++)
+    {
+    }
+    if(chunk_count == 0)
+    {
+        chunk_count = 1;
+    }
+    KSLOG_DEBUG("Value: %lu, chunk count %d", length, chunk_count);
+
+    if(chunk_count > dst_buffer_length)
+    {
+        KSLOG_DEBUG("Error: Require %d bytes but only %d available", chunk_count, dst_buffer_length);
+        return CODEC_ERROR_NOT_ENOUGH_ROOM;
+    }
+
+    uint8_t* dst = dst_buffer;
+    for(int shift_amount = chunk_count - 1; shift_amount >= 0; shift_amount--)
+    {
+        const int should_continue = (shift_amount == 0) ? 0 : continuation_bit;
+        const int chunk_value = ((length>>(g_bits_per_length_chunk * shift_amount)) & chunk_mask) + should_continue;
+        const uint8_t next_char = g_chunk_to_encode_char[chunk_value];
+        *dst++ = next_char;
+        KSLOG_DEBUG("Chunk %d: '%c' (%d), continue %d", shift_amount, next_char,
+                    ((length>>(g_bits_per_length_chunk * shift_amount)) & chunk_mask), should_continue);
+    }
+    return chunk_count;
+}
+
+codec_status CODEC_L_NAME(encoder_init)(codecl_encoder* const encoder, const int64_t length)
+{
+    if(length < 0)
+    {
+        return CODEC_ERROR_INVALID_LENGTH;
+    }
+    encoder->declared_length = length;
+    encoder->encoded_length = 0;
+    encoder->has_written_length_field = false;
+    return CODEC_STATUS_OK;
+}
+
+codec_status CODEC_L_NAME(encode_feed)(codecl_encoder* const encoder,
+                                       const uint8_t** const src_buffer_ptr,
+                                       const int64_t src_length,
+                                       uint8_t** const dst_buffer_ptr,
+                                       const int64_t dst_length,
+                                       const bool is_end_of_data)
+{
+    if(src_length < 0 || dst_length < 0)
+    {
+        return CODEC_ERROR_INVALID_LENGTH;
+    }
+    const int64_t remaining_length = encoder->declared_length - encoder->encoded_length;
+    if(src_length > remaining_length)
+    {
+        KSLOG_DEBUG("Error: Got %d bytes but only %d remain", src_length, remaining_length);
+        return CODEC_ERROR_TOO_MUCH_DATA;
+    }
+    if(is_end_of_data && src_length < remaining_length)
+    {
+        KSLOG_DEBUG("Error: Data ended %d bytes short", remaining_length - src_length);
+        return CODEC_ERROR_TRUNCATED_DATA;
+    }
+
+    int64_t feed_dst_length = dst_length;
+    if(!encoder->has_written_length_field)
+    {
+        const int64_t bytes_used = CODEC_NAME(write_length_field)(encoder->declared_length, *dst_buffer_ptr, dst_length);
+        if(bytes_used < 0)
+        {
+            return (codec_status)bytes_used;
+        }
+        *dst_buffer_ptr += bytes_used;
+        feed_dst_length -= bytes_used;
+        encoder->has_written_length_field = true;
+    }
+
+    const uint8_t* const src_start = *src_buffer_ptr;
+    const codec_status status = encode_feed(src_buffer_ptr,
+                                            src_length,
+                                            dst_buffer_ptr,
+                                            feed_dst_length,
+                                            src_length == remaining_length);
+    encoder->encoded_length += *src_buffer_ptr - src_start;
+    KSLOG_DEBUG("Encoded %d of %d bytes", encoder->encoded_length, encoder->declared_length);
+    if(status != CODEC_STATUS_OK)
+    {
+        return status;
+    }
+    if(encoder->encoded_length < encoder->declared_length)
+    {
+        return CODEC_STATUS_PARTIALLY_COMPLETE;
+    }
+    return CODEC_STATUS_OK;
+}
+
+int64_t CODEC_NAME(encode)(const uint8_t* const src_buffer,
+                           const int64_t src_length,
+                           uint8_t* const dst_buffer,
+                           const int64_t dst_length)
+{
+    if(src_length < 0 || dst_length < 0)
+    {
+        return CODEC_ERROR_INVALID_LENGTH;
+    }
+    const uint8_t* src = src_buffer;
+    uint8_t* dst = dst_buffer;
+    const codec_status status = CODEC_NAME(encode_feed)(&src, src_length, &dst, dst_length, true);
+    if(status != CODEC_STATUS_OK)
+    {
+        if(status == CODEC_STATUS_PARTIALLY_COMPLETE)
+        {
+            return CODEC_ERROR_NOT_ENOUGH_ROOM;
+        }
+        return status;
+    }
+    return dst - dst_buffer;
+}
+
+int64_t CODEC_L_NAME(encode)(const uint8_t* const src_buffer,
+                             const int64_t src_length,
+                             uint8_t* const dst_buffer,
+                             const int64_t dst_length)
+{
+    if(src_length < 0 || dst_length < 0)
+    {
+        return CODEC_ERROR_INVALID_LENGTH;
+    }
+    int64_t bytes_used = CODEC_NAME(write_length_field)(src_length, dst_buffer, dst_length);
+    if(bytes_used < 0)
+    {
+        return bytes_used;
+    }
+
+    const uint8_t* src = src_buffer;
+    uint8_t* dst = dst_buffer + bytes_used;
+    codec_status status = CODEC_NAME(encode_feed)(&src, src_length, &dst, dst_length, true);
+    if(status != CODEC_STATUS_OK)
+    {
+        if(status == CODEC_STATUS_PARTIALLY_COMPLETE)
+        {
+            return CODEC_ERROR_NOT_ENOUGH_ROOM;
+        }
+        return status;
+    }
+    return dst - dst_buffer;
+}
+
+int64_t CODEC_NAME(encode_batch)(const uint8_t* const* const src_buffers,
+                                 const int64_t* const src_lengths,
+                                 const int64_t record_count,
+                                 uint8_t* const dst_buffer,
+                                 const int64_t dst_length,
+                                 int64_t* const dst_offsets)
+{
+    if(record_count < 0 || dst_length < 0)
+    {
+        return CODEC_ERROR_INVALID_LENGTH;
+    }
+
+    // Validate the whole batch up front so that nothing (not even
+    // dst_offsets) gets written unless the entire batch fits.
+    int64_t total_length = 0;
+    bool is_too_long = false;
+    for(int64_t i = 0; i < record_count; i++)
+    {
+        const int64_t encoded_length = CODEC_NAME(get_encoded_length)(src_lengths[i], false);
+        if(encoded_length < 0)
+        {
+            KSLOG_DEBUG("Error: Record %d has invalid length %d", i, src_lengths[i]);
+            return encoded_length;
+        }
+        if(encoded_length > dst_length - total_length)
+        {
+            is_too_long = true;
+            continue;
+        }
+        total_length += encoded_length;
+    }
+    KSLOG_DEBUG("Encode %d records into %d chars", record_count, total_length);
+
+    if(is_too_long)
+    {
+        KSLOG_DEBUG("Error: Batch requires more than the %d bytes available", dst_length);
+        return CODEC_ERROR_NOT_ENOUGH_ROOM;
+    }
+
+    // Lay out the batch. The loop below doesn't need any per-record checks.
+    dst_offsets[0] = 0;
+    for(int64_t i = 0; i < record_count; i++)
+    {
+        dst_offsets[i+1] = dst_offsets[i] + CODEC_NAME(get_encoded_length)(src_lengths[i], false);
+    }
+
+    for(int64_t i = 0; i < record_count; i++)
+    {
+        const uint8_t* src = src_buffers[i];
+        uint8_t* dst = dst_buffer + dst_offsets[i];
+        encode_feed(&src, src_lengths[i], &dst, dst_offsets[i+1] - dst_offsets[i], true);
+    }
+    return total_length;
+}
+
+int64_t CODEC_NAME(decode_batch)(const uint8_t* const* const src_buffers,
+                                 const int64_t* const src_lengths,
+                                 const int64_t record_count,
+                                 uint8_t* const dst_buffer,
+                                 const int64_t dst_length,
+                                 int64_t* const dst_offsets)
+{
+    if(record_count < 0 || dst_length < 0)
+    {
+        return CODEC_ERROR_INVALID_LENGTH;
+    }
+    for(int64_t i = 0; i < record_count; i++)
+    {
+        if(src_lengths[i] < 0)
+        {
+            KSLOG_DEBUG("Error: Record %d has invalid length %d", i, src_lengths[i]);
+            return CODEC_ERROR_INVALID_LENGTH;
+        }
+    }
+
+    uint8_t* dst = dst_buffer;
+    uint8_t* const dst_end = dst_buffer + dst_length;
+    for(int64_t i = 0; i < record_count; i++)
+    {
+        dst_offsets[i] = dst - dst_buffer;
+        const uint8_t* src = src_buffers[i];
+        const codec_status status = decode_feed(&src,
+                                                src_lengths[i],
+                                                &dst,
+                                                dst_end - dst,
+                                                (codec_stream_state)(CODEC_SRC_IS_AT_END_OF_STREAM | CODEC_DST_IS_AT_END_OF_STREAM));
+        if(status != CODEC_STATUS_OK)
+        {
+            KSLOG_DEBUG("Error: Record %d failed with status %d", i, status);
+            if(status == CODEC_STATUS_PARTIALLY_COMPLETE)
+            {
+                return CODEC_ERROR_NOT_ENOUGH_ROOM;
+            }
+            return status;
+        }
+    }
+    dst_offsets[record_count] = dst - dst_buffer;
+    KSLOG_DEBUG("Decoded %d records into %d bytes", record_count, dst - dst_buffer);
+    return dst - dst_buffer;
+}
+
+// Reads the next group of chunks, skipping whitespace.
+// Returns the number of chunks read (less than a full group only at the end
+// of the data), or -1 if an invalid character was encountered.
+static inline int read_chunk_group(const uint8_t** const src_ptr,
+                                   const uint8_t* const src_end,
+                                   uint8_t* const chunks)
+{
+    const uint8_t* src = *src_ptr;
+    int chunk_count = 0;
+    while(chunk_count < g_chunks_per_group && src < src_end)
+    {
+        const uint8_t next_chunk = g_encode_char_to_chunk[*src++];
+        if(next_chunk == CHUNK_CODE_WHITESPACE)
+        {
+            continue;
+        }
+        if(next_chunk == CHUNK_CODE_ERROR)
+        {
+            KSLOG_DEBUG("Error: Invalid source data: %02x: [%c]", src[-1], src[-1]);
+            return -1;
+        }
+        chunks[chunk_count++] = next_chunk;
+    }
+    *src_ptr = src;
+    return chunk_count;
+}
+
+// Decodes a single group of chunks, returning the number of bytes written.
+static inline int decode_chunk_group(const uint8_t* const chunks,
+                                     const int chunk_count,
+                                     uint8_t* const bytes)
+{
+    uint8_t chars[g_chunks_per_group];
+    for(int i = 0; i < chunk_count; i++)
+    {
+        chars[i] = g_chunk_to_encode_char[chunks[i]];
+    }
+    const uint8_t* src = chars;
+    uint8_t* dst = bytes;
+    decode_feed(&src, chunk_count, &dst, g_bytes_per_group, CODEC_SRC_IS_AT_END_OF_STREAM);
+    return dst - bytes;
+}
+
+static inline int compare_bytes(const uint8_t* const a,
+                                const int64_t a_length,
+                                const uint8_t* const b,
+                                const int64_t b_length)
+{
+    const int64_t common_length = a_length < b_length ? a_length : b_length;
+    const int result = memcmp(a, b, common_length);
+    if(result != 0)
+    {
+        return result < 0 ? -1 : 1;
+    }
+    if(a_length == b_length)
+    {
+        return 0;
+    }
+    return a_length < b_length ? -1 : 1;
+}
+
+static inline int64_t get_common_prefix_length(const uint8_t* const a,
+                                               const uint8_t* const b,
+                                               const int64_t length)
+{
+    int64_t i = 0;
+    for(; i + (int64_t)sizeof(uint64_t) <= length; i += sizeof(uint64_t))
+    {
+        uint64_t a_word;
+        uint64_t b_word;
+        memcpy(&a_word, a + i, sizeof(a_word));
+        memcpy(&b_word, b + i, sizeof(b_word));
+        if(a_word != b_word)
+        {
+            break;
+        }
+    }
+    for(; i < length && a[i] == b[i]; i++)
+    {
+    }
+    return i;
+}
+
+codec_status CODEC_NAME(compare_encoded)(const uint8_t* const a_buffer,
+                                         const int64_t a_length,
+                                         const uint8_t* const b_buffer,
+                                         const int64_t b_length,
+                                         int* const result)
+{
+    if(a_length < 0 || b_length < 0)
+    {
+        return CODEC_ERROR_INVALID_LENGTH;
+    }
+
+    // Identical characters produce identical chunks, so skip straight past
+    // the common prefix, backing up to the last group boundary inside it.
+    const int64_t prefix_length = get_common_prefix_length(a_buffer,
+                                                           b_buffer,
+                                                           a_length < b_length ? a_length : b_length);
+    int64_t group_start = 0;
+    int current_group_chunk_count = 0;
+    for(int64_t i = 0; i < prefix_length; i++)
+    {
+        const uint8_t next_chunk = g_encode_char_to_chunk[a_buffer[i]];
+        if(next_chunk == CHUNK_CODE_WHITESPACE)
+        {
+            continue;
+        }
+        if(next_chunk == CHUNK_CODE_ERROR)
+        {
+            KSLOG_DEBUG("Error: Invalid source data: %02x: [%c]", a_buffer[i], a_buffer[i]);
+            return CODEC_ERROR_INVALID_SOURCE_DATA;
+        }
+        if(++current_group_chunk_count == g_chunks_per_group)
+        {
+            current_group_chunk_count = 0;
+            group_start = i + 1;
+        }
+    }
+    KSLOG_DEBUG("Common prefix %d chars, resuming at %d", prefix_length, group_start);
+
+    const uint8_t* a = a_buffer + group_start;
+    const uint8_t* b = b_buffer + group_start;
+    const uint8_t* const a_end = a_buffer + a_length;
+    const uint8_t* const b_end = b_buffer + b_length;
+    for(;;)
+    {
+        uint8_t a_chunks[g_chunks_per_group];
+        uint8_t b_chunks[g_chunks_per_group];
+        const int a_chunk_count = read_chunk_group(&a, a_end, a_chunks);
+        const int b_chunk_count = read_chunk_group(&b, b_end, b_chunks);
+        if(a_chunk_count < 0 || b_chunk_count < 0)
+        {
+            return CODEC_ERROR_INVALID_SOURCE_DATA;
+        }
+
+        if(a_chunk_count == g_chunks_per_group && b_chunk_count == g_chunks_per_group)
+        {
+            // Full groups sort the same as the bytes they represent.
+            const int group_result = memcmp(a_chunks, b_chunks, g_chunks_per_group);
+            if(group_result != 0)
+            {
+                *result = group_result < 0 ? -1 : 1;
+                return CODEC_STATUS_OK;
+            }
+            continue;
+        }
+
+        // Partial groups are right-aligned, so they must be compared as bytes.
+        uint8_t a_bytes[g_bytes_per_group];
+        uint8_t b_bytes[g_bytes_per_group];
+        const int a_byte_count = decode_chunk_group(a_chunks, a_chunk_count, a_bytes);
+        const int b_byte_count = decode_chunk_group(b_chunks, b_chunk_count, b_bytes);
+        *result = compare_bytes(a_bytes, a_byte_count, b_bytes, b_byte_count);
+        KSLOG_DEBUG("Partial group compare (%d vs %d bytes): %d", a_byte_count, b_byte_count, *result);
+        return CODEC_STATUS_OK;
+    }
+}
+
+codec_status CODEC_NAME(compare_encoded_to_binary)(const uint8_t* const encoded_buffer,
+                                                   const int64_t encoded_length,
+                                                   const uint8_t* const binary_buffer,
+                                                   const int64_t binary_length,
+                                                   int* const result)
+{
+    if(encoded_length < 0 || binary_length < 0)
+    {
+        return CODEC_ERROR_INVALID_LENGTH;
+    }
+
+    const uint8_t* src = encoded_buffer;
+    const uint8_t* const src_end = encoded_buffer + encoded_length;
+    const uint8_t* binary = binary_buffer;
+    const uint8_t* const binary_end = binary_buffer + binary_length;
+
+    // Decode in small tiles and compare each against the binary data.
+    uint8_t tile[g_bytes_per_group * 64];
+    for(;;)
+    {
+        uint8_t* dst = tile;
+        const codec_status status = decode_feed(&src,
+                                                src_end - src,
+                                                &dst,
+                                                sizeof(tile),
+                                                CODEC_SRC_IS_AT_END_OF_STREAM);
+        if(status != CODEC_STATUS_OK && status != CODEC_STATUS_PARTIALLY_COMPLETE)
+        {
+            return status;
+        }
+        const int64_t decoded_count = dst - tile;
+        const int64_t binary_remaining = binary_end - binary;
+        const int64_t common_length = decoded_count < binary_remaining ? decoded_count : binary_remaining;
+        // binary may be NULL when comparing against an empty value.
+        const int tile_result = common_length > 0 ? memcmp(tile, binary, common_length) : 0;
+        if(tile_result != 0)
+        {
+            *result = tile_result < 0 ? -1 : 1;
+            return CODEC_STATUS_OK;
+        }
+        if(decoded_count > binary_remaining)
+        {
+            *result = 1;
+            return CODEC_STATUS_OK;
+        }
+        binary += decoded_count;
+        if(status == CODEC_STATUS_OK)
+        {
+            *result = binary < binary_end ? -1 : 0;
+            return CODEC_STATUS_OK;
+        }
+    }
+}
+
+// Encodes a single (possibly partial) group, returning the number of chars written.
+static inline int encode_byte_group(const uint8_t* const bytes,
+                                    const int byte_count,
+                                    uint8_t* const chars)
+{
+    const uint8_t* src = bytes;
+    uint8_t* dst = chars;
+    encode_feed(&src, byte_count, &dst, g_chunks_per_group, true);
+    return dst - chars;
+}
+
+// Converts a sequence into the smallest sequence that sorts after every
+// sequence starting with it. Returns the new length, or 0 if there is no such
+// sequence (every character is the last one in the alphabet).
+static inline int64_t make_prefix_successor(uint8_t* const buffer, int64_t length)
+{
+    const uint8_t last_char = g_chunk_to_encode_char[sizeof(g_chunk_to_encode_char) - 1];
+    while(length > 0 && buffer[length - 1] == last_char)
+    {
+        length--;
+    }
+    if(length > 0)
+    {
+        const int chunk = g_encode_char_to_chunk[buffer[length - 1]];
+        buffer[length - 1] = g_chunk_to_encode_char[chunk + 1];
+    }
+    return length;
+}
+
+codec_status CODEC_NAME(encoded_range_for_prefix)(const uint8_t* const prefix_buffer,
+                                                  const int64_t prefix_length,
+                                                  uint8_t* const lo_buffer,
+                                                  int64_t* const lo_length,
+                                                  uint8_t* const hi_buffer,
+                                                  int64_t* const hi_length)
+{
+    if(prefix_length < 0 || *lo_length < 0 || *hi_length < 0)
+    {
+        return CODEC_ERROR_INVALID_LENGTH;
+    }
+
+    const int64_t full_group_length = prefix_length - prefix_length % g_bytes_per_group;
+    const int remainder_length = prefix_length % g_bytes_per_group;
+    const int64_t head_length = CODEC_NAME(get_encoded_length)(full_group_length, false);
+    if(head_length < 0)
+    {
+        return (codec_status)head_length;
+    }
+    const int64_t required_length = head_length + (remainder_length > 0 ? g_chunks_per_group : 0);
+    if(*lo_length < required_length || *hi_length < required_length)
+    {
+        KSLOG_DEBUG("Error: Require %d bytes but only %d and %d available", required_length, *lo_length, *hi_length);
+        return CODEC_ERROR_NOT_ENOUGH_ROOM;
+    }
+
+    // The complete groups of the prefix encode the same way in every match.
+    const uint8_t* src = prefix_buffer;
+    uint8_t* dst = lo_buffer;
+    encode_feed(&src, full_group_length, &dst, head_length, true);
+    memcpy(hi_buffer, lo_buffer, head_length);
+
+    if(remainder_length == 0)
+    {
+        *lo_length = head_length;
+        *hi_length = make_prefix_successor(hi_buffer, head_length);
+        KSLOG_DEBUG("Group aligned prefix: lo length %d, hi length %d", *lo_length, *hi_length);
+        return CODEC_STATUS_OK;
+    }
+
+    // The remaining prefix bytes split the next group. Matches either continue
+    // with a full group, or end in a partial group that contains the
+    // remaining bytes. Partial groups are right-aligned, so each possible
+    // partial length is a separate range that must be considered.
+    uint8_t group[g_bytes_per_group];
+    memcpy(group, prefix_buffer + full_group_length, remainder_length);
+
+    uint8_t lo_tail[g_chunks_per_group];
+    uint8_t hi_tail[g_chunks_per_group];
+    uint8_t candidate[g_chunks_per_group];
+
+    memset(group + remainder_length, 0, g_bytes_per_group - remainder_length);
+    int lo_tail_length = encode_byte_group(group, g_bytes_per_group, lo_tail);
+    memset(group + remainder_length, 0xff, g_bytes_per_group - remainder_length);
+    int hi_tail_length = encode_byte_group(group, g_bytes_per_group, hi_tail);
+    hi_tail_length = make_prefix_successor(hi_tail, hi_tail_length);
+
+    for(int byte_count = remainder_length; byte_count < g_bytes_per_group; byte_count++)
+    {
+        memset(group + remainder_length, 0, byte_count - remainder_length);
+        int candidate_length = encode_byte_group(group, byte_count, candidate);
+        if(compare_bytes(candidate, candidate_length, lo_tail, lo_tail_length) < 0)
+        {
+            memcpy(lo_tail, candidate, candidate_length);
+            lo_tail_length = candidate_length;
+        }
+
+        if(hi_tail_length > 0)
+        {
+            // A partial group ends the sequence, so the tightest exclusive
+            // bound is the candidate followed by the lowest character.
+            memset(group + remainder_length, 0xff, byte_count - remainder_length);
+            candidate_length = encode_byte_group(group, byte_count, candidate);
+            candidate[candidate_length++] = g_chunk_to_encode_char[0];
+            if(compare_bytes(candidate, candidate_length, hi_tail, hi_tail_length) > 0)
+            {
+                memcpy(hi_tail, candidate, candidate_length);
+                hi_tail_length = candidate_length;
+            }
+        }
+    }
+
+    memcpy(lo_buffer + head_length, lo_tail, lo_tail_length);
+    *lo_length = head_length + lo_tail_length;
+    if(hi_tail_length > 0)
+    {
+        memcpy(hi_buffer + head_length, hi_tail, hi_tail_length);
+        *hi_length = head_length + hi_tail_length;
+    }
+    else
+    {
+        *hi_length = make_prefix_successor(hi_buffer, head_length);
+    }
+    KSLOG_DEBUG("Split prefix: lo length %d, hi length %d", *lo_length, *hi_length);
+    return CODEC_STATUS_OK;
+}
+
+void* CODEC_NAME(arena_allocate)(void* const arena, const int64_t size)
+{
+    codec_arena* const a = (codec_arena*)arena;
+    if(size < 0 || size > a->length - a->used)
+    {
+        KSLOG_DEBUG("Error: Arena has %d bytes free, but %d were requested", a->length - a->used, size);
+        return NULL;
+    }
+    void* const result = a->buffer + a->used;
+    a->used += size;
+    return result;
+}
+
+static int64_t count_chunks(const uint8_t* const src_buffer, const int64_t src_length)
+{
+    const uint8_t* const src_end = src_buffer + src_length;
+    int64_t chunk_count = 0;
+    for(const uint8_t* src = src_buffer; src < src_end; src++)
+    {
+        const uint8_t next_chunk = g_encode_char_to_chunk[*src];
+        if(next_chunk == CHUNK_CODE_WHITESPACE)
+        {
+            continue;
+        }
+        if(next_chunk == CHUNK_CODE_ERROR)
+        {
+            KSLOG_DEBUG("Error: Invalid source data: %02x: [%c]", *src, *src);
+            return CODEC_ERROR_INVALID_SOURCE_DATA;
+        }
+        chunk_count++;
+    }
+    return chunk_count;
+}
+
+static int64_t allocate_output(const int64_t length,
+                               const codec_allocate_function allocate,
+                               void* const context,
+                               uint8_t** const dst_buffer)
+{
+    *dst_buffer = NULL;
+    if(length == 0)
+    {
+        return 0;
+    }
+    *dst_buffer = (uint8_t*)allocate(context, length);
+    if(*dst_buffer == NULL)
+    {
+        KSLOG_DEBUG("Error: Could not allocate %d bytes", length);
+        return CODEC_ERROR_ALLOCATION_FAILED;
+    }
+    return length;
+}
+
+int64_t CODEC_NAME(get_decoded_length_exact)(const uint8_t* const src_buffer,
+                                             const int64_t src_length)
+{
+    if(src_length < 0)
+    {
+        return CODEC_ERROR_INVALID_LENGTH;
+    }
+    const int64_t chunk_count = count_chunks(src_buffer, src_length);
+    if(chunk_count < 0)
+    {
+        return chunk_count;
+    }
+    return CODEC_NAME(get_decoded_length)(chunk_count);
+}
+
+int64_t CODEC_NAME(encode_alloc)(const uint8_t* const src_buffer,
+                                 const int64_t src_length,
+                                 const codec_allocate_function allocate,
+                                 void* const context,
+                                 uint8_t** const dst_buffer)
+{
+    const int64_t dst_length = CODEC_NAME(get_encoded_length)(src_length, false);
+    if(dst_length < 0)
+    {
+        return dst_length;
+    }
+    const int64_t allocated_length = allocate_output(dst_length, allocate, context, dst_buffer);
+    if(allocated_length <= 0)
+    {
+        return allocated_length;
+    }
+    return CODEC_NAME(encode)(src_buffer, src_length, *dst_buffer, dst_length);
+}
+
+int64_t CODEC_L_NAME(encode_alloc)(const uint8_t* const src_buffer,
+                                   const int64_t src_length,
+                                   const codec_allocate_function allocate,
+                                   void* const context,
+                                   uint8_t** const dst_buffer)
+{
+    const int64_t dst_length = CODEC_NAME(get_encoded_length)(src_length, true);
+    if(dst_length < 0)
+    {
+        return dst_length;
+    }
+    const int64_t allocated_length = allocate_output(dst_length, allocate, context, dst_buffer);
+    if(allocated_length <= 0)
+    {
+        return allocated_length;
+    }
+    return CODEC_L_NAME(encode)(src_buffer, src_length, *dst_buffer, dst_length);
+}
+
+int64_t CODEC_NAME(decode_alloc)(const uint8_t* const src_buffer,
+                                 const int64_t src_length,
+                                 const codec_allocate_function allocate,
+                                 void* const context,
+                                 uint8_t** const dst_buffer)
+{
+    const int64_t dst_length = CODEC_NAME(get_decoded_length_exact)(src_buffer, src_length);
+    if(dst_length < 0)
+    {
+        return dst_length;
+    }
+    const int64_t allocated_length = allocate_output(dst_length, allocate, context, dst_buffer);
+    if(allocated_length <= 0)
+    {
+        return allocated_length;
+    }
+    return CODEC_NAME(decode)(src_buffer, src_length, *dst_buffer, dst_length);
+}
+
+int64_t CODEC_L_NAME(decode_alloc)(const uint8_t* const src_buffer,
+                                   const int64_t src_length,
+                                   const codec_allocate_function allocate,
+                                   void* const context,
+                                   uint8_t** const dst_buffer)
+{
+    if(src_length < 0)
+    {
+        return CODEC_ERROR_INVALID_LENGTH;
+    }
+    int64_t specified_length = 0;
+    const int64_t bytes_used = CODEC_NAME(read_length_field)(src_buffer, src_length, &specified_length);
+    if(bytes_used < 0)
+    {
+        return bytes_used;
+    }
+
+    // Validate everything before allocating, so that nothing is allocated on failure.
+    const int64_t chunk_count = count_chunks(src_buffer + bytes_used, src_length - bytes_used);
+    if(chunk_count < 0)
+    {
+        return chunk_count;
+    }
+    if(chunk_count < CODEC_NAME(get_encoded_length)(specified_length, false))
+    {
+        KSLOG_DEBUG("Error: Expected %d bytes, but only %d chunks are present", specified_length, chunk_count);
+        return CODEC_ERROR_TRUNCATED_DATA;
+    }
+
+    const int64_t allocated_length = allocate_output(specified_length, allocate, context, dst_buffer);
+    if(allocated_length <= 0)
+    {
+        return allocated_length;
+    }
+    return CODEC_L_NAME(decode)(src_buffer, src_length, *dst_buffer, specified_length);
+}
+
+static inline int64_t skip_whitespace(const uint8_t* const buffer, int64_t offset, const int64_t buffer_length)
+{
+    while(offset < buffer_length && g_encode_char_to_chunk[buffer[offset]] == CHUNK_CODE_WHITESPACE)
+    {
+        offset++;
+    }
+    return offset;
+}
+
+int64_t CODEC_L_NAME(scan_record)(const uint8_t* const src_buffer,
+                                  const int64_t src_length,
+                                  const bool may_contain_whitespace,
+                                  codecl_record_span* const span)
+{
+    if(src_length < 0)
+    {
+        return CODEC_ERROR_INVALID_LENGTH;
+    }
+    int64_t offset = 0;
+    if(may_contain_whitespace)
+    {
+        offset = skip_whitespace(src_buffer, offset, src_length);
+    }
+    if(offset >= src_length)
+    {
+        KSLOG_DEBUG("Error: No length field");
+        return CODEC_ERROR_UNTERMINATED_LENGTH_FIELD;
+    }
+
+    int64_t decoded_length = 0;
+    const int64_t length_field_length = CODEC_NAME(read_length_field)(src_buffer + offset,
+                                                                      src_length - offset,
+                                                                      &decoded_length);
+    if(length_field_length < 0)
+    {
+        return length_field_length;
+    }
+    int64_t end = offset + length_field_length;
+
+    // Encoded data is never shorter than its decoded form, which also keeps
+    // absurd length fields from overflowing the encoded length calculation.
+    if(decoded_length > src_length - end)
+    {
+        KSLOG_DEBUG("Error: Record of %d bytes can't fit in %d chars", decoded_length, src_length - end);
+        return CODEC_ERROR_TRUNCATED_DATA;
+    }
+    int64_t chunks_remaining = CODEC_NAME(get_encoded_length)(decoded_length, false);
+
+    if(!may_contain_whitespace)
+    {
+        if(chunks_remaining > src_length - end)
+        {
+            KSLOG_DEBUG("Error: Record needs %d chars, but only %d remain", chunks_remaining, src_length - end);
+            return CODEC_ERROR_TRUNCATED_DATA;
+        }
+        end += chunks_remaining;
+    }
+    else
+    {
+        while(chunks_remaining > 0)
+        {
+            if(end >= src_length)
+            {
+                KSLOG_DEBUG("Error: Record is missing %d chars", chunks_remaining);
+                return CODEC_ERROR_TRUNCATED_DATA;
+            }
+            const uint8_t next_chunk = g_encode_char_to_chunk[src_buffer[end++]];
+            if(next_chunk == CHUNK_CODE_WHITESPACE)
+            {
+                continue;
+            }
+            if(next_chunk == CHUNK_CODE_ERROR)
+            {
+                KSLOG_DEBUG("Error: Invalid source data at offset %d", end - 1);
+                return CODEC_ERROR_INVALID_SOURCE_DATA;
+            }
+            chunks_remaining--;
+        }
+    }
+
+    span->offset = offset;
+    span->encoded_length = end - offset;
+    span->decoded_length = decoded_length;
+    KSLOG_DEBUG("Record at %d: %d chars, %d bytes", offset, end - offset, decoded_length);
+    return end;
+}
+
+int64_t CODEC_L_NAME(index_records)(const uint8_t* const src_buffer,
+                                    const int64_t src_length,
+                                    const bool may_contain_whitespace,
+                                    codecl_record_span* const spans,
+                                    const int64_t span_count)
+{
+    if(src_length < 0 || span_count < 0)
+    {
+        return CODEC_ERROR_INVALID_LENGTH;
+    }
+
+    int64_t record_count = 0;
+    int64_t offset = 0;
+    for(;;)
+    {
+        if(may_contain_whitespace)
+        {
+            offset = skip_whitespace(src_buffer, offset, src_length);
+        }
+        if(offset >= src_length)
+        {
+            break;
+        }
+        codecl_record_span span;
+        const int64_t record_end = CODEC_L_NAME(scan_record)(src_buffer + offset,
+                                                             src_length - offset,
+                                                             may_contain_whitespace,
+                                                             &span);
+        if(record_end < 0)
+        {
+            return record_end;
+        }
+        if(spans != NULL)
+        {
+            if(record_count >= span_count)
+            {
+                KSLOG_DEBUG("Error: More than %d records", span_count);
+                return CODEC_ERROR_NOT_ENOUGH_ROOM;
+            }
+            spans[record_count] = span;
+            spans[record_count].offset += offset;
+        }
+        record_count++;
+        offset += record_end;
+    }
+    KSLOG_DEBUG("Indexed %d records", record_count);
+    return record_count;
+}
+
+static inline int64_t get_layout_offset(const codec_layout* const layout, const int64_t char_index)
+{
+    if(layout == NULL)
+    {
+        return char_index;
+    }
+    if(layout->line_length == 0)
+    {
+        return layout->indent_length + char_index;
+    }
+    const int64_t line_break_length = layout->use_crlf ? 2 : 1;
+    const int64_t line_index = char_index / layout->line_length;
+    return layout->indent_length +
+           line_index * (layout->line_length + line_break_length + layout->indent_length) +
+           char_index % layout->line_length;
+}
+
+// Decode a complete sequence in small tiles, discarding the first skip_count
+// bytes and writing at most dst_length bytes after that.
+static int64_t decode_tiled(const uint8_t* src,
+                            const uint8_t* const src_end,
+                            int64_t skip_count,
+                            uint8_t* const dst_buffer,
+                            const int64_t dst_length)
+{
+    uint8_t* dst = dst_buffer;
+    uint8_t* const dst_end = dst_buffer + dst_length;
+    uint8_t tile[g_bytes_per_group * 64];
+    while(dst < dst_end)
+    {
+        uint8_t* tile_dst = tile;
+        const codec_status status = decode_feed(&src,
+                                                src_end - src,
+                                                &tile_dst,
+                                                sizeof(tile),
+                                                CODEC_SRC_IS_AT_END_OF_STREAM);
+        if(status != CODEC_STATUS_OK && status != CODEC_STATUS_PARTIALLY_COMPLETE)
+        {
+            return status;
+        }
+        int64_t copy_count = (tile_dst - tile) - skip_count;
+        if(copy_count > dst_end - dst)
+        {
+            copy_count = dst_end - dst;
+        }
+        if(copy_count > 0)
+        {
+            memcpy(dst, tile + skip_count, copy_count);
+            dst += copy_count;
+            skip_count = 0;
+        }
+        else
+        {
+            skip_count -= tile_dst - tile;
+        }
+        if(status == CODEC_STATUS_OK)
+        {
+            break;
+        }
+    }
+    KSLOG_DEBUG("Decoded %d bytes", dst - dst_buffer);
+    return dst - dst_buffer;
+}
+
+// Locates the whole groups that contain a range of bytes (byte_count > 0).
+static inline void locate_range_groups(const codec_layout* const layout,
+                                       const int64_t byte_offset,
+                                       const int64_t byte_count,
+                                       int64_t* const src_start_offset,
+                                       int64_t* const src_end_offset)
+{
+    const int64_t first_group = byte_offset / g_bytes_per_group;
+    const int64_t end_group = (byte_offset + byte_count + g_bytes_per_group - 1) / g_bytes_per_group;
+    *src_start_offset = get_layout_offset(layout, first_group * g_chunks_per_group);
+    *src_end_offset = get_layout_offset(layout, end_group * g_chunks_per_group - 1) + 1;
+    KSLOG_DEBUG("Bytes %d-%d are in groups %d-%d at offsets %d-%d",
+                byte_offset, byte_offset + byte_count, first_group, end_group, *src_start_offset, *src_end_offset);
+}
+
+codec_status CODEC_NAME(locate_range)(const int64_t byte_offset,
+                                      const int64_t byte_count,
+                                      const codec_layout* const layout,
+                                      int64_t* const src_offset,
+                                      int64_t* const src_length,
+                                      int64_t* const skip_count)
+{
+    if(byte_offset < 0 || byte_count < 0)
+    {
+        return CODEC_ERROR_INVALID_LENGTH;
+    }
+    if(layout != NULL && (layout->line_length < 0 || layout->indent_length < 0))
+    {
+        return CODEC_ERROR_INVALID_LENGTH;
+    }
+    int64_t src_start_offset = 0;
+    int64_t src_end_offset = 0;
+    if(byte_count > 0)
+    {
+        locate_range_groups(layout, byte_offset, byte_count, &src_start_offset, &src_end_offset);
+    }
+    *src_offset = src_start_offset;
+    *src_length = src_end_offset - src_start_offset;
+    *skip_count = byte_offset % g_bytes_per_group;
+    return CODEC_STATUS_OK;
+}
+
+int64_t CODEC_NAME(decode_range)(const uint8_t* const src_buffer,
+                                 const int64_t src_length,
+                                 const int64_t byte_offset,
+                                 int64_t byte_count,
+                                 uint8_t* const dst_buffer,
+                                 const int64_t dst_length,
+                                 const codec_layout* const layout)
+{
+    if(src_length < 0 || byte_offset < 0 || byte_count < 0 || dst_length < 0)
+    {
+        return CODEC_ERROR_INVALID_LENGTH;
+    }
+    if(layout != NULL && (layout->line_length < 0 || layout->indent_length < 0))
+    {
+        return CODEC_ERROR_INVALID_LENGTH;
+    }
+    if(dst_length < byte_count)
+    {
+        KSLOG_DEBUG("Error: Require %d bytes but only %d available", byte_count, dst_length);
+        return CODEC_ERROR_NOT_ENOUGH_ROOM;
+    }
+
+    // Encoded data is never shorter than its decoded form.
+    if(byte_offset >= src_length)
+    {
+        return 0;
+    }
+    if(byte_count > src_length - byte_offset)
+    {
+        byte_count = src_length - byte_offset;
+    }
+    if(byte_count == 0)
+    {
+        return 0;
+    }
+
+    int64_t src_start_offset = 0;
+    int64_t src_end_offset = 0;
+    locate_range_groups(layout, byte_offset, byte_count, &src_start_offset, &src_end_offset);
+    if(src_start_offset >= src_length)
+    {
+        return 0;
+    }
+    if(src_end_offset > src_length)
+    {
+        src_end_offset = src_length;
+    }
+
+    return decode_tiled(src_buffer + src_start_offset,
+                        src_buffer + src_end_offset,
+                        byte_offset % g_bytes_per_group,
+                        dst_buffer,
+                        byte_count);
+}
+
+// The line break and indentation that go between lines.
+static inline int64_t get_line_separator_length(const codec_layout* const layout)
+{
+    return (layout->use_crlf ? 2 : 1) + layout->indent_length;
+}
+
+static const int g_container_value_length  = 8;
+static const int g_container_header_length = 16;
+
+static inline void write_container_value(uint8_t* const dst, uint64_t value)
+{
+    for(int i = g_container_value_length - 1; i >= 0; i--)
+    {
+        dst[i] = (uint8_t)value;
+        value >>= 8;
+    }
+}
+
+static inline int64_t read_container_value(const uint8_t* const src)
+{
+    uint64_t value = 0;
+    for(int i = 0; i < g_container_value_length; i++)
+    {
+        value = (value << 8) | src[i];
+    }
+    return (int64_t)value;
+}
+
+static inline int64_t get_container_segment_count(const int64_t data_length, const int64_t segment_length)
+{
+    return data_length / segment_length + (data_length % segment_length != 0);
+}
+
+static inline int64_t get_container_index_length(const int64_t segment_count)
+{
+    return g_container_header_length + segment_count * g_container_value_length;
+}
+
+// The length of raw_length characters once laid out, including the line
+// break after a full last line.
+static inline int64_t get_laid_out_text_length(const codec_layout* const layout, const int64_t raw_length)
+{
+    if(layout == NULL)
+    {
+        return raw_length;
+    }
+    if(layout->line_length == 0)
+    {
+        return layout->indent_length + raw_length;
+    }
+    return layout->indent_length + raw_length + raw_length / layout->line_length * get_line_separator_length(layout);
+}
+
+// The length of a container before it's laid out.
+static int64_t get_container_raw_length(const int64_t data_length, const int64_t segment_length)
+{
+    const int64_t full_segment_count = data_length / segment_length;
+    const int64_t last_segment_length = data_length % segment_length;
+    const int64_t segment_count = get_container_segment_count(data_length, segment_length);
+
+    int64_t length = full_segment_count * CODEC_NAME(get_encoded_length)(segment_length, true);
+    if(last_segment_length > 0)
+    {
+        length += CODEC_NAME(get_encoded_length)(last_segment_length, true);
+    }
+    length += CODEC_NAME(get_encoded_length)(get_container_index_length(segment_count), true);
+    length += CODEC_NAME(get_encoded_length)(g_container_value_length, false);
+    return length;
+}
+
+int64_t CODEC_NAME(container_get_encoded_length)(const int64_t data_length,
+                                                 const int64_t segment_length,
+                                                 const codec_layout* const layout)
+{
+    if(data_length < 0 || segment_length <= 0)
+    {
+        return CODEC_ERROR_INVALID_LENGTH;
+    }
+    if(layout != NULL && (layout->line_length < 0 || layout->indent_length < 0))
+    {
+        return CODEC_ERROR_INVALID_LENGTH;
+    }
+    const int64_t length = get_laid_out_text_length(layout, get_container_raw_length(data_length, segment_length));
+    KSLOG_DEBUG("Container of %d bytes in segments of %d: %d chars", data_length, segment_length, length);
+    return length;
+}
+
+// Reads the trailer at the end of the buffer, skipping whitespace in and
+// after it. Returns the index offset, and stores where the trailer starts.
+static int64_t read_container_trailer(const uint8_t* const src_buffer,
+                                      const int64_t src_length,
+                                      int64_t* const trailer_offset)
+{
+    const int trailer_length = (int)CODEC_NAME(get_encoded_length)(g_container_value_length, false);
+    uint8_t chars[32];
+    int char_count = 0;
+    int64_t offset = src_length;
+    while(char_count < trailer_length)
+    {
+        if(offset == 0)
+        {
+            KSLOG_DEBUG("Error: Container is too short to contain a trailer");
+            return CODEC_ERROR_TRUNCATED_DATA;
+        }
+        const uint8_t next_char = src_buffer[--offset];
+        const uint8_t next_chunk = g_encode_char_to_chunk[next_char];
+        if(next_chunk == CHUNK_CODE_WHITESPACE)
+        {
+            continue;
+        }
+        if(next_chunk == CHUNK_CODE_ERROR)
+        {
+            KSLOG_DEBUG("Error: Invalid trailer character %02x", next_char);
+            return CODEC_ERROR_INVALID_SOURCE_DATA;
+        }
+        chars[trailer_length - ++char_count] = next_char;
+    }
+
+    uint8_t value[g_container_value_length];
+    if(CODEC_NAME(decode)(chars, trailer_length, value, sizeof(value)) != g_container_value_length)
+    {
+        KSLOG_DEBUG("Error: Invalid trailer");
+        return CODEC_ERROR_INVALID_SOURCE_DATA;
+    }
+    const int64_t index_offset = read_container_value(value);
+    if(index_offset < 0)
+    {
+        KSLOG_DEBUG("Error: Index offset %d is out of range", index_offset);
+        return CODEC_ERROR_INVALID_SOURCE_DATA;
+    }
+    *trailer_offset = offset;
+    return index_offset;
+}
+
+// Reads the index, which starts at index_offset and ends at trailer_offset.
+static codec_status open_container_index(const uint8_t* const index_buffer,
+                                         const int64_t index_offset,
+                                         const int64_t trailer_offset,
+                                         codec_container* const container)
+{
+    const int64_t index_text_length = trailer_offset - index_offset;
+    int64_t index_length = 0;
+    int64_t result = CODEC_NAME(read_length_field)(index_buffer, index_text_length, &index_length);
+    if(result < 0)
+    {
+        return (codec_status)result;
+    }
+    const int64_t index_data_offset = index_offset + result;
+    if(index_length < g_container_header_length ||
+       (index_length - g_container_header_length) % g_container_value_length != 0 ||
+       index_length > index_text_length - result ||
+       CODEC_NAME(get_encoded_length)(index_length, false) != count_chunks(index_buffer + result, index_text_length - result))
+    {
+        KSLOG_DEBUG("Error: Invalid index length %d", index_length);
+        return CODEC_ERROR_INVALID_SOURCE_DATA;
+    }
+
+    uint8_t value[g_container_header_length];
+    result = decode_tiled(index_buffer + result, index_buffer + index_text_length, 0, value, sizeof(value));
+    if(result < 0)
+    {
+        return (codec_status)result;
+    }
+    const int64_t segment_length = read_container_value(value);
+    const int64_t data_length = read_container_value(value + g_container_value_length);
+    if(segment_length <= 0 || data_length < 0 ||
+       get_container_index_length(get_container_segment_count(data_length, segment_length)) != index_length)
+    {
+        KSLOG_DEBUG("Error: Invalid index header");
+        return CODEC_ERROR_INVALID_SOURCE_DATA;
+    }
+
+    container->data_length = data_length;
+    container->segment_length = segment_length;
+    container->segment_count = get_container_segment_count(data_length, segment_length);
+    container->index_offset = index_offset;
+    container->index_data_offset = index_data_offset;
+    container->trailer_offset = trailer_offset;
+    KSLOG_DEBUG("Container: %d bytes in %d segments of %d", data_length, container->segment_count, segment_length);
+    return CODEC_STATUS_OK;
+}
+
+int64_t CODEC_NAME(container_find_index)(const uint8_t* const end_buffer,
+                                         const int64_t end_buffer_length,
+                                         const int64_t container_length,
+                                         int64_t* const trailer_offset)
+{
+    if(end_buffer_length < 0 || end_buffer_length > container_length)
+    {
+        return CODEC_ERROR_INVALID_LENGTH;
+    }
+    int64_t end_trailer_offset = 0;
+    const int64_t index_offset = read_container_trailer(end_buffer, end_buffer_length, &end_trailer_offset);
+    if(index_offset < 0)
+    {
+        return index_offset;
+    }
+    const int64_t container_trailer_offset = container_length - end_buffer_length + end_trailer_offset;
+    if(index_offset >= container_trailer_offset)
+    {
+        KSLOG_DEBUG("Error: Index offset %d is out of range", index_offset);
+        return CODEC_ERROR_INVALID_SOURCE_DATA;
+    }
+    *trailer_offset = container_trailer_offset;
+    return index_offset;
+}
+
+codec_status CODEC_NAME(container_open_index)(const uint8_t* const index_buffer,
+                                              const int64_t index_buffer_length,
+                                              const int64_t index_offset,
+                                              codec_container* const container)
+{
+    if(index_buffer_length < 0 || index_offset < 0)
+    {
+        return CODEC_ERROR_INVALID_LENGTH;
+    }
+    return open_container_index(index_buffer, index_offset, index_offset + index_buffer_length, container);
+}
+
+codec_status CODEC_NAME(container_open)(const uint8_t* const src_buffer,
+                                        const int64_t src_length,
+                                        codec_container* const container)
+{
+    if(src_length < 0)
+    {
+        return CODEC_ERROR_INVALID_LENGTH;
+    }
+    int64_t trailer_offset = 0;
+    const int64_t index_offset = CODEC_NAME(container_find_index)(src_buffer, src_length, src_length, &trailer_offset);
+    if(index_offset < 0)
+    {
+        return (codec_status)index_offset;
+    }
+    return open_container_index(src_buffer + index_offset, index_offset, trailer_offset, container);
+}
+
+// Reads a segment's offset from the index (whose text is in index_buffer).
+static int64_t read_container_segment_offset(const uint8_t* const index_buffer,
+                                             const codec_container* const container,
+                                             const int64_t segment_index)
+{
+    if(segment_index == container->segment_count)
+    {
+        return container->index_offset;
+    }
+    const int64_t index_length = get_container_index_length(container->segment_count);
+    const uint8_t* const data_start = index_buffer + (container->index_data_offset - container->index_offset);
+    const int64_t data_text_length = container->trailer_offset - container->index_data_offset;
+    const int64_t value_offset = g_container_header_length + segment_index * g_container_value_length;
+    uint8_t value[g_container_value_length];
+    int64_t result = 0;
+    if(data_text_length == CODEC_NAME(get_encoded_length)(index_length, false))
+    {
+        // Without whitespace, the value can be located arithmetically.
+        result = CODEC_NAME(decode_range)(data_start, data_text_length, value_offset, sizeof(value), value, sizeof(value), NULL);
+    }
+    else
+    {
+        result = decode_tiled(data_start, data_start + data_text_length, value_offset, value, sizeof(value));
+    }
+    if(result < 0)
+    {
+        return result;
+    }
+    if(result != g_container_value_length)
+    {
+        return CODEC_ERROR_TRUNCATED_DATA;
+    }
+    const int64_t offset = read_container_value(value);
+    if(offset < 0 || offset > container->index_offset)
+    {
+        KSLOG_DEBUG("Error: Segment %d offset %d is out of range", segment_index, offset);
+        return CODEC_ERROR_INVALID_SOURCE_DATA;
+    }
+    return offset;
+}
+
+codec_status CODEC_NAME(container_locate_segment)(const uint8_t* const index_buffer,
+                                                  const int64_t index_buffer_length,
+                                                  const codec_container* const container,
+                                                  const int64_t segment_index,
+                                                  int64_t* const segment_offset,
+                                                  int64_t* const segment_encoded_length)
+{
+    if(index_buffer_length < 0 || segment_index < 0 || segment_index >= container->segment_count)
+    {
+        return CODEC_ERROR_INVALID_LENGTH;
+    }
+    if(index_buffer_length < container->trailer_offset - container->index_offset)
+    {
+        return CODEC_ERROR_TRUNCATED_DATA;
+    }
+    const int64_t start_offset = read_container_segment_offset(index_buffer, container, segment_index);
+    if(start_offset < 0)
+    {
+        return (codec_status)start_offset;
+    }
+    const int64_t end_offset = read_container_segment_offset(index_buffer, container, segment_index + 1);
+    if(end_offset < 0)
+    {
+        return (codec_status)end_offset;
+    }
+    if(end_offset < start_offset)
+    {
+        KSLOG_DEBUG("Error: Segment %d ends before it starts", segment_index);
+        return CODEC_ERROR_INVALID_SOURCE_DATA;
+    }
+    *segment_offset = start_offset;
+    *segment_encoded_length = end_offset - start_offset;
+    return CODEC_STATUS_OK;
+}
+
+// Find the encoded data of a segment (following its length field), and
+// check that its length field is what the index says it should be.
+static codec_status locate_container_segment(const uint8_t* const src_buffer,
+                                             const int64_t src_length,
+                                             const codec_container* const container,
+                                             const int64_t segment_index,
+                                             const uint8_t** const data_start,
+                                             const uint8_t** const data_end)
+{
+    if(container->trailer_offset > src_length)
+    {
+        return CODEC_ERROR_TRUNCATED_DATA;
+    }
+    int64_t start_offset = 0;
+    int64_t encoded_length = 0;
+    const codec_status status = CODEC_NAME(container_locate_segment)(src_buffer + container->index_offset,
+                                                                     container->trailer_offset - container->index_offset,
+                                                                     container,
+                                                                     segment_index,
+                                                                     &start_offset,
+                                                                     &encoded_length);
+    if(status != CODEC_STATUS_OK)
+    {
+        return status;
+    }
+    const int64_t end_offset = start_offset + encoded_length;
+
+    int64_t declared_length = 0;
+    const int64_t length_field_length = CODEC_NAME(read_length_field)(src_buffer + start_offset,
+                                                                      end_offset - start_offset,
+                                                                      &declared_length);
+    if(length_field_length < 0)
+    {
+        return (codec_status)length_field_length;
+    }
+    const int64_t segment_offset = segment_index * container->segment_length;
+    const int64_t remaining_length = container->data_length - segment_offset;
+    const int64_t expected_length = remaining_length < container->segment_length ? remaining_length : container->segment_length;
+    if(declared_length != expected_length)
+    {
+        KSLOG_DEBUG("Error: Segment %d has length %d, but expected %d", segment_index, declared_length, expected_length);
+        return CODEC_ERROR_INVALID_SOURCE_DATA;
+    }
+    *data_start = src_buffer + start_offset + length_field_length;
+    *data_end = src_buffer + end_offset;
+    return CODEC_STATUS_OK;
+}
+
+int64_t CODEC_NAME(container_decode_segment)(const uint8_t* const src_buffer,
+                                             const int64_t src_length,
+                                             const codec_container* const container,
+                                             const int64_t segment_index,
+                                             uint8_t* const dst_buffer,
+                                             const int64_t dst_length)
+{
+    if(src_length < 0 || dst_length < 0 || segment_index < 0 || segment_index >= container->segment_count)
+    {
+        return CODEC_ERROR_INVALID_LENGTH;
+    }
+    const int64_t segment_offset = segment_index * container->segment_length;
+    const int64_t remaining_length = container->data_length - segment_offset;
+    const int64_t expected_length = remaining_length < container->segment_length ? remaining_length : container->segment_length;
+    if(dst_length < expected_length)
+    {
+        KSLOG_DEBUG("Error: Require %d bytes but only %d available", expected_length, dst_length);
+        return CODEC_ERROR_NOT_ENOUGH_ROOM;
+    }
+
+    const uint8_t* data_start = NULL;
+    const uint8_t* data_end = NULL;
+    const codec_status status = locate_container_segment(src_buffer, src_length, container, segment_index, &data_start, &data_end);
+    if(status != CODEC_STATUS_OK)
+    {
+        return status;
+    }
+    const int64_t decoded_length = CODEC_NAME(decode)(data_start, data_end - data_start, dst_buffer, expected_length);
+    if(decoded_length >= 0 && decoded_length < expected_length)
+    {
+        KSLOG_DEBUG("Error: Segment %d decoded to %d bytes, but expected %d", segment_index, decoded_length, expected_length);
+        return CODEC_ERROR_TRUNCATED_DATA;
+    }
+    return decoded_length;
+}
+
+int64_t CODEC_NAME(container_decode_range)(const uint8_t* const src_buffer,
+                                           const int64_t src_length,
+                                           const codec_container* const container,
+                                           const int64_t byte_offset,
+                                           int64_t byte_count,
+                                           uint8_t* const dst_buffer,
+                                           const int64_t dst_length)
+{
+    if(src_length < 0 || byte_offset < 0 || byte_count < 0 || dst_length < 0)
+    {
+        return CODEC_ERROR_INVALID_LENGTH;
+    }
+    if(dst_length < byte_count)
+    {
+        KSLOG_DEBUG("Error: Require %d bytes but only %d available", byte_count, dst_length);
+        return CODEC_ERROR_NOT_ENOUGH_ROOM;
+    }
+    if(byte_offset >= container->data_length)
+    {
+        return 0;
+    }
+    if(byte_count > container->data_length - byte_offset)
+    {
+        byte_count = container->data_length - byte_offset;
+    }
+
+    uint8_t* dst = dst_buffer;
+    int64_t offset = byte_offset;
+    const int64_t end_offset = byte_offset + byte_count;
+    while(offset < end_offset)
+    {
+        const int64_t segment_index = offset / container->segment_length;
+        const int64_t skip_count = offset - segment_index * container->segment_length;
+        int64_t segment_byte_count = container->segment_length - skip_count;
+        if(segment_byte_count > end_offset - offset)
+        {
+            segment_byte_count = end_offset - offset;
+        }
+
+        const uint8_t* data_start = NULL;
+        const uint8_t* data_end = NULL;
+        const codec_status status = locate_container_segment(src_buffer, src_length, container, segment_index, &data_start, &data_end);
+        if(status != CODEC_STATUS_OK)
+        {
+            return status;
+        }
+        const int64_t decoded_length = decode_tiled(data_start, data_end, skip_count, dst, segment_byte_count);
+        if(decoded_length < 0)
+        {
+            return decoded_length;
+        }
+        if(decoded_length < segment_byte_count)
+        {
+            KSLOG_DEBUG("Error: Segment %d is truncated", segment_index);
+            return CODEC_ERROR_TRUNCATED_DATA;
+        }
+        dst += decoded_length;
+        offset += decoded_length;
+    }
+    KSLOG_DEBUG("Decoded %d bytes from container", dst - dst_buffer);
+    return dst - dst_buffer;
+}
+
+codec_status CODEC_NAME(alphabet_init)(codec_alphabet* const alphabet,
+                                       const char* const chars,
+                                       const char* const whitespace,
+                                       const char* const substitutions)
+{
+    memset(alphabet->char_to_chunk, CHUNK_CODE_ERROR, sizeof(alphabet->char_to_chunk));
+
+    int chunk_count = 0;
+    for(const uint8_t* ch = (const uint8_t*)chars; *ch != 0; ch++)
+    {
+        if(chunk_count == g_chunk_radix || alphabet->char_to_chunk[*ch] != CHUNK_CODE_ERROR)
+        {
+            KSLOG_DEBUG("Error: Alphabet character %d [%c] is a duplicate or one too many", chunk_count, *ch);
+            return CODEC_ERROR_INVALID_ALPHABET;
+        }
+        alphabet->char_to_chunk[*ch] = (uint8_t)chunk_count;
+        alphabet->chunk_to_char[chunk_count] = *ch;
+        chunk_count++;
+    }
+    if(chunk_count != g_chunk_radix)
+    {
+        KSLOG_DEBUG("Error: Alphabet has %d characters but requires %d", chunk_count, g_chunk_radix);
+        return CODEC_ERROR_INVALID_ALPHABET;
+    }
+
+    for(const uint8_t* ch = (const uint8_t*)whitespace; ch != NULL && *ch != 0; ch++)
+    {
+        if(alphabet->char_to_chunk[*ch] != CHUNK_CODE_ERROR)
+        {
+            KSLOG_DEBUG("Error: Whitespace character [%c] is already in use", *ch);
+            return CODEC_ERROR_INVALID_ALPHABET;
+        }
+        alphabet->char_to_chunk[*ch] = CHUNK_CODE_WHITESPACE;
+    }
+
+    for(const uint8_t* pair = (const uint8_t*)substitutions; pair != NULL && *pair != 0; pair += 2)
+    {
+        const uint8_t from = pair[0];
+        const uint8_t to = pair[1];
+        const uint8_t chunk = alphabet->char_to_chunk[to];
+        if(to == 0 ||
+           chunk >= g_chunk_radix ||
+           alphabet->chunk_to_char[chunk] != to ||
+           alphabet->char_to_chunk[from] != CHUNK_CODE_ERROR)
+        {
+            KSLOG_DEBUG("Error: Invalid substitution [%c] -> [%c]", from, to);
+            return CODEC_ERROR_INVALID_ALPHABET;
+        }
+        alphabet->char_to_chunk[from] = chunk;
+    }
+
+    return CODEC_STATUS_OK;
+}
+
+codec_status CODEC_NAME(alphabet_decode_feed)(const codec_alphabet* const alphabet,
+                                              const uint8_t** const src_buffer_ptr,
+                                              const int64_t src_length,
+                                              uint8_t** const dst_buffer_ptr,
+                                              const int64_t dst_length,
+                                              const codec_stream_state stream_state)
+{
+    if(src_length < 0 || dst_length < 0)
+    {
+        return CODEC_ERROR_INVALID_LENGTH;
+    }
+    return decode_feed_with_table(alphabet->char_to_chunk,
+                                  src_buffer_ptr,
+                                  src_length,
+                                  dst_buffer_ptr,
+                                  dst_length,
+                                  stream_state);
+}
+
+codec_status CODEC_NAME(alphabet_encode_feed)(const codec_alphabet* const alphabet,
+                                              const uint8_t** const src_buffer_ptr,
+                                              const int64_t src_length,
+                                              uint8_t** const dst_buffer_ptr,
+                                              const int64_t dst_length,
+                                              const bool is_end_of_data)
+{
+    if(src_length < 0 || dst_length < 0)
+    {
+        return CODEC_ERROR_INVALID_LENGTH;
+    }
+    return encode_feed_with_table(alphabet->chunk_to_char,
+                                  src_buffer_ptr,
+                                  src_length,
+                                  dst_buffer_ptr,
+                                  dst_length,
+                                  is_end_of_data);
+}
+
+int64_t CODEC_NAME(alphabet_decode)(const codec_alphabet* const alphabet,
+                                    const uint8_t* const src_buffer,
+                                    const int64_t src_length,
+                                    uint8_t* const dst_buffer,
+                                    const int64_t dst_length)
+{
+    const uint8_t* src = src_buffer;
+    uint8_t* dst = dst_buffer;
+    const codec_status status = CODEC_NAME(alphabet_decode_feed)(
+                                    alphabet,
+                                    &src,
+                                    src_length,
+                                    &dst,
+                                    dst_length,
+                                    (codec_stream_state)(CODEC_SRC_IS_AT_END_OF_STREAM | CODEC_DST_IS_AT_END_OF_STREAM));
+    if(status != CODEC_STATUS_OK)
+    {
+        if(status == CODEC_STATUS_PARTIALLY_COMPLETE)
+        {
+            return CODEC_ERROR_NOT_ENOUGH_ROOM;
+        }
+        return status;
+    }
+    return dst - dst_buffer;
+}
+
+int64_t CODEC_NAME(alphabet_encode)(const codec_alphabet* const alphabet,
+                                    const uint8_t* const src_buffer,
+                                    const int64_t src_length,
+                                    uint8_t* const dst_buffer,
+                                    const int64_t dst_length)
+{
+    const uint8_t* src = src_buffer;
+    uint8_t* dst = dst_buffer;
+    const codec_status status = CODEC_NAME(alphabet_encode_feed)(alphabet, &src, src_length, &dst, dst_length, true);
+    if(status != CODEC_STATUS_OK)
+    {
+        if(status == CODEC_STATUS_PARTIALLY_COMPLETE)
+        {
+            return CODEC_ERROR_NOT_ENOUGH_ROOM;
+        }
+        return status;
+    }
+    return dst - dst_buffer;
+}
+
+// CRC32C (Castagnoli), reflected, using the CRC instructions where the CPU
+// has them.
+static const uint32_t g_crc32c_table[256] =
+{
+    0x00000000, 0xf26b8303, 0xe13b70f7, 0x1350f3f4, 0xc79a971f, 0x35f1141c, 0x26a1e7e8, 0xd4ca64eb,
+    0x8ad958cf, 0x78b2dbcc, 0x6be22838, 0x9989ab3b, 0x4d43cfd0, 0xbf284cd3, 0xac78bf27, 0x5e133c24,
+    0x105ec76f, 0xe235446c, 0xf165b798, 0x030e349b, 0xd7c45070, 0x25afd373, 0x36ff2087, 0xc494a384,
+    0x9a879fa0, 0x68ec1ca3, 0x7bbcef57, 0x89d76c54, 0x5d1d08bf, 0xaf768bbc, 0xbc267848, 0x4e4dfb4b,
+    0x20bd8ede, 0xd2d60ddd, 0xc186fe29, 0x33ed7d2a, 0xe72719c1, 0x154c9ac2, 0x061c6936, 0xf477ea35,
+    0xaa64d611, 0x580f5512, 0x4b5fa6e6, 0xb93425e5, 0x6dfe410e, 0x9f95c20d, 0x8cc531f9, 0x7eaeb2fa,
+    0x30e349b1, 0xc288cab2, 0xd1d83946, 0x23b3ba45, 0xf779deae, 0x05125dad, 0x1642ae59, 0xe4292d5a,
+    0xba3a117e, 0x4851927d, 0x5b016189, 0xa96ae28a, 0x7da08661, 0x8fcb0562, 0x9c9bf696, 0x6ef07595,
+    0x417b1dbc, 0xb3109ebf, 0xa0406d4b, 0x522bee48, 0x86e18aa3, 0x748a09a0, 0x67dafa54, 0x95b17957,
+    0xcba24573, 0x39c9c670, 0x2a993584, 0xd8f2b687, 0x0c38d26c, 0xfe53516f, 0xed03a29b, 0x1f682198,
+    0x5125dad3, 0xa34e59d0, 0xb01eaa24, 0x42752927, 0x96bf4dcc, 0x64d4cecf, 0x77843d3b, 0x85efbe38,
+    0xdbfc821c, 0x2997011f, 0x3ac7f2eb, 0xc8ac71e8, 0x1c661503, 0xee0d9600, 0xfd5d65f4, 0x0f36e6f7,
+    0x61c69362, 0x93ad1061, 0x80fde395, 0x72966096, 0xa65c047d, 0x5437877e, 0x4767748a, 0xb50cf789,
+    0xeb1fcbad, 0x197448ae, 0x0a24bb5a, 0xf84f3859, 0x2c855cb2, 0xdeeedfb1, 0xcdbe2c45, 0x3fd5af46,
+    0x7198540d, 0x83f3d70e, 0x90a324fa, 0x62c8a7f9, 0xb602c312, 0x44694011, 0x5739b3e5, 0xa55230e6,
+    0xfb410cc2, 0x092a8fc1, 0x1a7a7c35, 0xe811ff36, 0x3cdb9bdd, 0xceb018de, 0xdde0eb2a, 0x2f8b6829,
+    0x82f63b78, 0x709db87b, 0x63cd4b8f, 0x91a6c88c, 0x456cac67, 0xb7072f64, 0xa457dc90, 0x563c5f93,
+    0x082f63b7, 0xfa44e0b4, 0xe9141340, 0x1b7f9043, 0xcfb5f4a8, 0x3dde77ab, 0x2e8e845f, 0xdce5075c,
+    0x92a8fc17, 0x60c37f14, 0x73938ce0, 0x81f80fe3, 0x55326b08, 0xa759e80b, 0xb4091bff, 0x466298fc,
+    0x1871a4d8, 0xea1a27db, 0xf94ad42f, 0x0b21572c, 0xdfeb33c7, 0x2d80b0c4, 0x3ed04330, 0xccbbc033,
+    0xa24bb5a6, 0x502036a5, 0x4370c551, 0xb11b4652, 0x65d122b9, 0x97baa1ba, 0x84ea524e, 0x7681d14d,
+    0x2892ed69, 0xdaf96e6a, 0xc9a99d9e, 0x3bc21e9d, 0xef087a76, 0x1d63f975, 0x0e330a81, 0xfc588982,
+    0xb21572c9, 0x407ef1ca, 0x532e023e, 0xa145813d, 0x758fe5d6, 0x87e466d5, 0x94b49521, 0x66df1622,
+    0x38cc2a06, 0xcaa7a905, 0xd9f75af1, 0x2b9cd9f2, 0xff56bd19, 0x0d3d3e1a, 0x1e6dcdee, 0xec064eed,
+    0xc38d26c4, 0x31e6a5c7, 0x22b65633, 0xd0ddd530, 0x0417b1db, 0xf67c32d8, 0xe52cc12c, 0x1747422f,
+    0x49547e0b, 0xbb3ffd08, 0xa86f0efc, 0x5a048dff, 0x8ecee914, 0x7ca56a17, 0x6ff599e3, 0x9d9e1ae0,
+    0xd3d3e1ab, 0x21b862a8, 0x32e8915c, 0xc083125f, 0x144976b4, 0xe622f5b7, 0xf5720643, 0x07198540,
+    0x590ab964, 0xab613a67, 0xb831c993, 0x4a5a4a90, 0x9e902e7b, 0x6cfbad78, 0x7fab5e8c, 0x8dc0dd8f,
+    0xe330a81a, 0x115b2b19, 0x020bd8ed, 0xf0605bee, 0x24aa3f05, 0xd6c1bc06, 0xc5914ff2, 0x37faccf1,
+    0x69e9f0d5, 0x9b8273d6, 0x88d28022, 0x7ab90321, 0xae7367ca, 0x5c18e4c9, 0x4f48173d, 0xbd23943e,
+    0xf36e6f75, 0x0105ec76, 0x12551f82, 0xe03e9c81, 0x34f4f86a, 0xc69f7b69, 0xd5cf889d, 0x27a40b9e,
+    0x79b737ba, 0x8bdcb4b9, 0x988c474d, 0x6ae7c44e, 0xbe2da0a5, 0x4c4623a6, 0x5f16d052, 0xad7d5351,
+};
+
+static uint32_t crc32c_update_software(uint32_t crc, const uint8_t* data, int64_t length)
+{
+    for(; length > 0; length--)
+    {
+        crc = g_crc32c_table[(crc ^ *data++) & 0xff] ^ (crc >> 8);
+    }
+    return crc;
+}
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+    #define CODEC_CRC32C_HARDWARE_TARGET __attribute__((target("sse4.2")))
+    #define CODEC_CRC32C_HARDWARE_IS_AVAILABLE() __builtin_cpu_supports("sse4.2")
+    #define CODEC_CRC32C_BYTE(CRC, VALUE) __builtin_ia32_crc32qi(CRC, VALUE)
+    #if defined(__x86_64__)
+        #define CODEC_CRC32C_WORD(CRC, VALUE) (uint32_t)__builtin_ia32_crc32di(CRC, VALUE)
+    #endif
+#elif defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+    #include <arm_acle.h>
+    #define CODEC_CRC32C_HARDWARE_TARGET
+    #define CODEC_CRC32C_HARDWARE_IS_AVAILABLE() 1
+    #define CODEC_CRC32C_BYTE(CRC, VALUE) __crc32cb(CRC, VALUE)
+    #define CODEC_CRC32C_WORD(CRC, VALUE) __crc32cd(CRC, VALUE)
+#endif
+
+#ifdef CODEC_CRC32C_BYTE
+CODEC_CRC32C_HARDWARE_TARGET
+static uint32_t crc32c_update_hardware(uint32_t crc, const uint8_t* data, int64_t length)
+{
+#ifdef CODEC_CRC32C_WORD
+    for(; length >= 8; length -= 8, data += 8)
+    {
+        uint64_t word;
+        memcpy(&word, data, sizeof(word));
+        crc = CODEC_CRC32C_WORD(crc, word);
+    }
+#endif
+    for(; length > 0; length--)
+    {
+        crc = CODEC_CRC32C_BYTE(crc, *data++);
+    }
+    return crc;
+}
+#endif
+
+static inline uint32_t crc32c_update(const uint32_t crc, const uint8_t* const data, const int64_t length)
+{
+#ifdef CODEC_CRC32C_BYTE
+    if(CODEC_CRC32C_HARDWARE_IS_AVAILABLE())
+    {
+        return crc32c_update_hardware(crc, data, length);
+    }
+#endif
+    return crc32c_update_software(crc, data, length);
+}
+
+uint32_t CODEC_NAME(crc32c)(const uint32_t crc, const uint8_t* const buffer, const int64_t length)
+{
+    if(length <= 0)
+    {
+        return crc;
+    }
+    return ~crc32c_update(~crc, buffer, length);
+}
+
+// The checksummed feeds work through the data a block at a time, and
+// checksum each block's binary data right after encoding or decoding it, while
+// it's still in the cache.
+static const int64_t g_checksum_block_group_count = 1024;
+
+codec_status CODEC_NAME(decode_feed_crc32c)(const uint8_t** const src_buffer_ptr,
+                                            const int64_t src_length,
+                                            uint8_t** const dst_buffer_ptr,
+                                            const int64_t dst_length,
+                                            const codec_stream_state stream_state,
+                                            uint32_t* const crc)
+{
+    if(src_length < 0 || dst_length < 0)
+    {
+        return CODEC_ERROR_INVALID_LENGTH;
+    }
+    const uint8_t* const src_end = *src_buffer_ptr + src_length;
+    uint8_t* const dst_end = *dst_buffer_ptr + dst_length;
+    const int64_t block_length = g_checksum_block_group_count * g_chunks_per_group;
+    uint32_t value = ~*crc;
+    codec_status status = CODEC_STATUS_PARTIALLY_COMPLETE;
+
+    // Everything up to the last block is decoded as if neither stream ended
+    // there, so that the end of stream handling only ever happens once, over
+    // the final call. A block that makes no progress (because it's all
+    // whitespace, or the destination is full) also ends the loop.
+    while(src_end - *src_buffer_ptr > block_length)
+    {
+        const uint8_t* const block_src = *src_buffer_ptr;
+        uint8_t* const block_dst = *dst_buffer_ptr;
+        status = decode_feed(src_buffer_ptr,
+                             block_length,
+                             dst_buffer_ptr,
+                             dst_end - *dst_buffer_ptr,
+                             CODEC_STREAM_STATE_NONE);
+        value = crc32c_update(value, block_dst, *dst_buffer_ptr - block_dst);
+        if(status != CODEC_STATUS_PARTIALLY_COMPLETE || *src_buffer_ptr == block_src)
+        {
+            break;
+        }
+    }
+
+    if(status == CODEC_STATUS_PARTIALLY_COMPLETE)
+    {
+        uint8_t* const block_dst = *dst_buffer_ptr;
+        status = decode_feed(src_buffer_ptr,
+                             src_end - *src_buffer_ptr,
+                             dst_buffer_ptr,
+                             dst_end - *dst_buffer_ptr,
+                             stream_state);
+        value = crc32c_update(value, block_dst, *dst_buffer_ptr - block_dst);
+    }
+
+    *crc = ~value;
+    return status;
+}
+
+codec_status CODEC_NAME(encode_feed_crc32c)(const uint8_t** const src_buffer_ptr,
+                                            const int64_t src_length,
+                                            uint8_t** const dst_buffer_ptr,
+                                            const int64_t dst_length,
+                                            const bool is_end_of_data,
+                                            uint32_t* const crc)
+{
+    if(src_length < 0 || dst_length < 0)
+    {
+        return CODEC_ERROR_INVALID_LENGTH;
+    }
+    const uint8_t* const src_end = *src_buffer_ptr + src_length;
+    uint8_t* const dst_end = *dst_buffer_ptr + dst_length;
+    const int64_t block_length = g_checksum_block_group_count * g_bytes_per_group;
+    uint32_t value = ~*crc;
+    codec_status status = CODEC_STATUS_OK;
+
+    // Blocks are made of whole groups, so the only way a block can come up
+    // short is if the destination is full.
+    for(;;)
+    {
+        const uint8_t* const block_src = *src_buffer_ptr;
+        const bool is_last_block = src_end - block_src <= block_length;
+        const int64_t length = is_last_block ? src_end - block_src : block_length;
+        status = encode_feed(src_buffer_ptr,
+                             length,
+                             dst_buffer_ptr,
+                             dst_end - *dst_buffer_ptr,
+                             is_end_of_data && is_last_block);
+        value = crc32c_update(value, block_src, *src_buffer_ptr - block_src);
+        if(is_last_block || status != CODEC_STATUS_OK || *src_buffer_ptr < block_src + length)
+        {
+            break;
+        }
+    }
+
+    *crc = ~value;
+    return status;
+}
+
+int64_t CODEC_NAME(decode_crc32c)(const uint8_t* const src_buffer,
+                                  const int64_t src_length,
+                                  uint8_t* const dst_buffer,
+                                  const int64_t dst_length,
+                                  uint32_t* const crc)
+{
+    const uint8_t* src = src_buffer;
+    uint8_t* dst = dst_buffer;
+    *crc = 0;
+    const codec_status status = CODEC_NAME(decode_feed_crc32c)(
+                                    &src,
+                                    src_length,
+                                    &dst,
+                                    dst_length,
+                                    (codec_stream_state)(CODEC_SRC_IS_AT_END_OF_STREAM | CODEC_DST_IS_AT_END_OF_STREAM),
+                                    crc);
+    if(status != CODEC_STATUS_OK)
+    {
+        if(status == CODEC_STATUS_PARTIALLY_COMPLETE)
+        {
+            return CODEC_ERROR_NOT_ENOUGH_ROOM;
+        }
+        return status;
+    }
+    return dst - dst_buffer;
+}
+
+int64_t CODEC_NAME(encode_crc32c)(const uint8_t* const src_buffer,
+                                  const int64_t src_length,
+                                  uint8_t* const dst_buffer,
+                                  const int64_t dst_length,
+                                  uint32_t* const crc)
+{
+    const uint8_t* src = src_buffer;
+    uint8_t* dst = dst_buffer;
+    *crc = 0;
+    const codec_status status = CODEC_NAME(encode_feed_crc32c)(&src, src_length, &dst, dst_length, true, crc);
+    if(status != CODEC_STATUS_OK)
+    {
+        if(status == CODEC_STATUS_PARTIALLY_COMPLETE)
+        {
+            return CODEC_ERROR_NOT_ENOUGH_ROOM;
+        }
+        return status;
+    }
+    return dst - dst_buffer;
+}
+
+#ifndef CODEC_NO_CONTENT_NAMES
+
+// SHA-256, as specified in FIPS 180-4.
+static const uint32_t g_sha256_round_constants[64] =
+{
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+static const int g_sha256_block_length = 64;
+static const int g_content_hash_length = 32;
+
+static inline uint32_t rotate_right(const uint32_t value, const int bits)
+{
+    return (value >> bits) | (value << (32 - bits));
+}
+
+static void sha256_process_block(uint32_t* const state, const uint8_t* const block)
+{
+    uint32_t w[64];
+    for(int i = 0; i < 16; i++)
+    {
+        w[i] = ((uint32_t)block[i*4] << 24) | ((uint32_t)block[i*4+1] << 16) |
+               ((uint32_t)block[i*4+2] << 8) | (uint32_t)block[i*4+3];
+    }
+    for(int i = 16; i < 64; i++)
+    {
+        const uint32_t s0 = rotate_right(w[i-15], 7) ^ rotate_right(w[i-15], 18) ^ (w[i-15] >> 3);
+        const uint32_t s1 = rotate_right(w[i-2], 17) ^ rotate_right(w[i-2], 19) ^ (w[i-2] >> 10);
+        w[i] = w[i-16] + s0 + w[i-7] + s1;
+    }
+
+    uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+    uint32_t e = state[4], f = state[5], g = state[6], h = state[7];
+    for(int i = 0; i < 64; i++)
+    {
+        const uint32_t s1 = rotate_right(e, 6) ^ rotate_right(e, 11) ^ rotate_right(e, 25);
+        const uint32_t choice = (e & f) ^ (~e & g);
+        const uint32_t temp1 = h + s1 + choice + g_sha256_round_constants[i] + w[i];
+        const uint32_t s0 = rotate_right(a, 2) ^ rotate_right(a, 13) ^ rotate_right(a, 22);
+        const uint32_t majority = (a & b) ^ (a & c) ^ (b & c);
+        const uint32_t temp2 = s0 + majority;
+        h = g;
+        g = f;
+        f = e;
+        e = d + temp1;
+        d = c;
+        c = b;
+        b = a;
+        a = temp1 + temp2;
+    }
+    state[0] += a; state[1] += b; state[2] += c; state[3] += d;
+    state[4] += e; state[5] += f; state[6] += g; state[7] += h;
+}
+
+void CODEC_NAME(content_name_init)(codec_content_hasher* const hasher)
+{
+    static const uint32_t initial_state[8] =
+    {
+        0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19,
+    };
+    memcpy(hasher->state, initial_state, sizeof(initial_state));
+    hasher->length = 0;
+}
+
+codec_status CODEC_NAME(content_name_update)(codec_content_hasher* const hasher,
+                                             const uint8_t* const src_buffer,
+                                             const int64_t src_length)
+{
+    if(src_length < 0)
+    {
+        return CODEC_ERROR_INVALID_LENGTH;
+    }
+    const uint8_t* src = src_buffer;
+    const uint8_t* const src_end = src + src_length;
+    int buffered_length = (int)(hasher->length % g_sha256_block_length);
+    hasher->length += src_length;
+
+    if(buffered_length > 0)
+    {
+        const int64_t fill_length = g_sha256_block_length - buffered_length;
+        if(src_end - src < fill_length)
+        {
+            memcpy(hasher->block + buffered_length, src, src_end - src);
+            return CODEC_STATUS_OK;
+        }
+        memcpy(hasher->block + buffered_length, src, fill_length);
+        src += fill_length;
+        sha256_process_block(hasher->state, hasher->block);
+    }
+
+    // Whole blocks are hashed straight from the source.
+    for(; src_end - src >= g_sha256_block_length; src += g_sha256_block_length)
+    {
+        sha256_process_block(hasher->state, src);
+    }
+    if(src < src_end)
+    {
+        memcpy(hasher->block, src, src_end - src);
+    }
+    return CODEC_STATUS_OK;
+}
+
+int64_t CODEC_NAME(get_content_name_length)(const int64_t directory_count, const int64_t directory_length)
+{
+    if(directory_count < 0 || directory_length < 0 || (directory_count > 0 && directory_length == 0))
+    {
+        return CODEC_ERROR_INVALID_LENGTH;
+    }
+    const int64_t hash_encoded_length = CODEC_NAME(get_encoded_length)(g_content_hash_length, false);
+    // Check each factor first so that the product can't overflow.
+    if(directory_count >= hash_encoded_length ||
+       directory_length >= hash_encoded_length ||
+       directory_count * directory_length >= hash_encoded_length)
+    {
+        KSLOG_DEBUG("Error: %d directories of length %d leave nothing for the file name",
+                    directory_count, directory_length);
+        return CODEC_ERROR_INVALID_LENGTH;
+    }
+    return hash_encoded_length + directory_count;
+}
+
+// Encodes a content hash, with the first directory_count * directory_length
+// characters split off into directories.
+static void write_content_name(const uint8_t* const hash,
+                               const int64_t directory_count,
+                               const int64_t directory_length,
+                               uint8_t* dst)
+{
+    // Nothing encodes to more than twice its length (safe16).
+    uint8_t encoded[64];
+    const uint8_t* src = hash;
+    uint8_t* encoded_end = encoded;
+    encode_feed(&src, g_content_hash_length, &encoded_end, sizeof(encoded), true);
+
+    const uint8_t* encoded_src = encoded;
+    for(int64_t i = 0; i < directory_count; i++)
+    {
+        memcpy(dst, encoded_src, directory_length);
+        dst += directory_length;
+        encoded_src += directory_length;
+        *dst++ = '/';
+    }
+    memcpy(dst, encoded_src, encoded_end - encoded_src);
+}
+
+int64_t CODEC_NAME(content_name_finish)(codec_content_hasher* const hasher,
+                                        const int64_t directory_count,
+                                        const int64_t directory_length,
+                                        uint8_t* const dst_buffer,
+                                        const int64_t dst_length)
+{
+    const int64_t name_length = CODEC_NAME(get_content_name_length)(directory_count, directory_length);
+    if(name_length < 0 || dst_length < 0)
+    {
+        return CODEC_ERROR_INVALID_LENGTH;
+    }
+    if(name_length > dst_length)
+    {
+        KSLOG_DEBUG("Error: Require %d bytes but only %d available", name_length, dst_length);
+        return CODEC_ERROR_NOT_ENOUGH_ROOM;
+    }
+
+    // Padding: 0x80, zeroes up to 8 bytes before the end of a block, then the
+    // length in bits.
+    const uint64_t bit_length = hasher->length * 8;
+    int buffered_length = (int)(hasher->length % g_sha256_block_length);
+    hasher->block[buffered_length++] = 0x80;
+    if(buffered_length > g_sha256_block_length - 8)
+    {
+        memset(hasher->block + buffered_length, 0, g_sha256_block_length - buffered_length);
+        sha256_process_block(hasher->state, hasher->block);
+        buffered_length = 0;
+    }
+    memset(hasher->block + buffered_length, 0, g_sha256_block_length - 8 - buffered_length);
+    for(int i = 0; i < 8; i++)
+    {
+        hasher->block[g_sha256_block_length - 1 - i] = (uint8_t)(bit_length >> (i * 8));
+    }
+    sha256_process_block(hasher->state, hasher->block);
+
+    uint8_t hash[32];
+    for(int i = 0; i < g_content_hash_length; i++)
+    {
+        hash[i] = (uint8_t)(hasher->state[i / 4] >> (24 - (i % 4) * 8));
+    }
+    write_content_name(hash, directory_count, directory_length, dst_buffer);
+    return name_length;
+}
+
+int64_t CODEC_NAME(content_name)(const uint8_t* const src_buffer,
+                                 const int64_t src_length,
+                                 const int64_t directory_count,
+                                 const int64_t directory_length,
+                                 uint8_t* const dst_buffer,
+                                 const int64_t dst_length)
+{
+    codec_content_hasher hasher;
+    CODEC_NAME(content_name_init)(&hasher);
+    const codec_status status = CODEC_NAME(content_name_update)(&hasher, src_buffer, src_length);
+    if(status != CODEC_STATUS_OK)
+    {
+        return status;
+    }
+    return CODEC_NAME(content_name_finish)(&hasher, directory_count, directory_length, dst_buffer, dst_length);
+}
+
+int64_t CODEC_NAME(content_name_batch)(const uint8_t* const* const src_buffers,
+                                       const int64_t* const src_lengths,
+                                       const int64_t record_count,
+                                       const int64_t directory_count,
+                                       const int64_t directory_length,
+                                       uint8_t* const dst_buffer,
+                                       const int64_t dst_length)
+{
+    const int64_t name_length = CODEC_NAME(get_content_name_length)(directory_count, directory_length);
+    if(name_length < 0 || record_count < 0 || dst_length < 0)
+    {
+        return CODEC_ERROR_INVALID_LENGTH;
+    }
+    for(int64_t i = 0; i < record_count; i++)
+    {
+        if(src_lengths[i] < 0)
+        {
+            KSLOG_DEBUG("Error: Record %d has invalid length %d", i, src_lengths[i]);
+            return CODEC_ERROR_INVALID_LENGTH;
+        }
+    }
+    if(record_count > dst_length / name_length)
+    {
+        KSLOG_DEBUG("Error: Require %d names of %d bytes but only %d bytes available",
+                    record_count, name_length, dst_length);
+        return CODEC_ERROR_NOT_ENOUGH_ROOM;
+    }
+    const int64_t total_length = name_length * record_count;
+
+    for(int64_t i = 0; i < record_count; i++)
+    {
+        codec_content_hasher hasher;
+        CODEC_NAME(content_name_init)(&hasher);
+        CODEC_NAME(content_name_update)(&hasher, src_buffers[i], src_lengths[i]);
+        CODEC_NAME(content_name_finish)(&hasher, directory_count, directory_length, dst_buffer + i * name_length, name_length);
+    }
+    return total_length;
+}
+
+#endif // CODEC_NO_CONTENT_NAMES
+
+int64_t CODEC_NAME(get_json_string_length)(const int64_t decoded_length)
+{
+    const int64_t encoded_length = CODEC_NAME(get_encoded_length)(decoded_length, false);
+    if(encoded_length < 0)
+    {
+        return encoded_length;
+    }
+    return encoded_length + 2;
+}
+
+int64_t CODEC_NAME(encode_json_string)(const uint8_t* const src_buffer,
+                                       const int64_t src_length,
+                                       uint8_t* const dst_buffer,
+                                       const int64_t dst_length)
+{
+    const int64_t string_length = CODEC_NAME(get_json_string_length)(src_length);
+    if(string_length < 0 || dst_length < 0)
+    {
+        return CODEC_ERROR_INVALID_LENGTH;
+    }
+    if(string_length > dst_length)
+    {
+        KSLOG_DEBUG("Error: Require %d bytes but only %d available", string_length, dst_length);
+        return CODEC_ERROR_NOT_ENOUGH_ROOM;
+    }
+
+    // None of the encoding characters need escaping in JSON, so the encoded
+    // data goes straight between the quotes.
+    const uint8_t* src = src_buffer;
+    uint8_t* dst = dst_buffer;
+    *dst++ = '"';
+    encode_feed(&src, src_length, &dst, string_length - 2, true);
+    *dst++ = '"';
+    return dst - dst_buffer;
+}
+
+int64_t CODEC_NAME(decode_json_string_in_place)(uint8_t* const buffer,
+                                                const int64_t buffer_length,
+                                                int64_t* const string_length)
+{
+    if(buffer_length < 0)
+    {
+        return CODEC_ERROR_INVALID_LENGTH;
+    }
+    if(buffer_length == 0 || buffer[0] != '"')
+    {
+        KSLOG_DEBUG("Error: Value doesn't start with a quote");
+        return CODEC_ERROR_INVALID_SOURCE_DATA;
+    }
+    const uint8_t* const closing_quote = (const uint8_t*)memchr(buffer + 1, '"', buffer_length - 1);
+    if(closing_quote == NULL)
+    {
+        KSLOG_DEBUG("Error: Unterminated string");
+        return CODEC_ERROR_TRUNCATED_DATA;
+    }
+
+    // Each group is read in full before any of it is written, and a group
+    // decodes to fewer bytes than it has characters, so the decoded data
+    // never overtakes the encoded data it overwrites. Escape sequences are
+    // rejected as invalid characters.
+    const uint8_t* src = buffer + 1;
+    uint8_t* dst = buffer;
+    const int64_t encoded_length = closing_quote - src;
+    const codec_status status = decode_feed(&src,
+                                            encoded_length,
+                                            &dst,
+                                            CODEC_NAME(get_decoded_length)(encoded_length),
+                                            (codec_stream_state)(CODEC_SRC_IS_AT_END_OF_STREAM | CODEC_DST_IS_AT_END_OF_STREAM));
+    if(status != CODEC_STATUS_OK)
+    {
+        return status;
+    }
+    *string_length = closing_quote + 1 - buffer;
+    return dst - buffer;
+}
+
+// The tiles that binary data passes through when transcoding. This is a
+// multiple of every codec's group size, and small enough to stay in the L1
+// cache.
+#define TRANSCODE_TILE_LENGTH 3840
+#define STANDARD_CODE_PADDING 0xfd
+
+typedef struct
+{
+    const char* alphabet;
+    int bits_per_char;
+    int chars_per_group;
+    int bytes_per_group;
+    bool is_case_insensitive;
+} standard_format_info;
+
+static const standard_format_info g_standard_formats[] =
+{
+    {"ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/", 6, 4, 3, false},
+    {"ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_", 6, 4, 3, false},
+    {"ABCDEFGHIJKLMNOPQRSTUVWXYZ234567", 5, 8, 5, false},
+    {"0123456789ABCDEF", 4, 2, 1, true},
+};
+
+static const standard_format_info* get_standard_format_info(const codec_standard_format format)
+{
+    if((int)format < 0 || (int)format >= (int)(sizeof(g_standard_formats) / sizeof(*g_standard_formats)))
+    {
+        KSLOG_DEBUG("Error: Unknown standard format %d", format);
+        return NULL;
+    }
+    return &g_standard_formats[format];
+}
+
+static void build_standard_decode_table(const standard_format_info* const info, uint8_t* const char_to_value)
+{
+    memset(char_to_value, CHUNK_CODE_ERROR, 256);
+    char_to_value['\t'] = CHUNK_CODE_WHITESPACE;
+    char_to_value['\n'] = CHUNK_CODE_WHITESPACE;
+    char_to_value['\r'] = CHUNK_CODE_WHITESPACE;
+    char_to_value[' '] = CHUNK_CODE_WHITESPACE;
+    char_to_value['='] = STANDARD_CODE_PADDING;
+    for(int i = 0; info->alphabet[i] != 0; i++)
+    {
+        const uint8_t ch = (uint8_t)info->alphabet[i];
+        char_to_value[ch] = (uint8_t)i;
+        if(info->is_case_insensitive && ch >= 'A' && ch <= 'Z')
+        {
+            char_to_value[ch - 'A' + 'a'] = (uint8_t)i;
+        }
+    }
+}
+
+int64_t CODEC_NAME(get_transcoded_length_from_standard)(const codec_standard_format format, const int64_t src_length)
+{
+    const standard_format_info* const info = get_standard_format_info(format);
+    if(info == NULL)
+    {
+        return CODEC_ERROR_INVALID_ALPHABET;
+    }
+    if(src_length < 0)
+    {
+        return CODEC_ERROR_INVALID_LENGTH;
+    }
+    const int64_t decoded_length = src_length / info->chars_per_group * info->bytes_per_group +
+                                   src_length % info->chars_per_group * info->bits_per_char / g_bits_per_byte;
+    return CODEC_NAME(get_encoded_length)(decoded_length, false);
+}
+
+int64_t CODEC_NAME(get_transcoded_length_to_standard)(const codec_standard_format format,
+                                                      const int64_t src_length,
+                                                      const bool use_padding)
+{
+    const standard_format_info* const info = get_standard_format_info(format);
+    if(info == NULL)
+    {
+        return CODEC_ERROR_INVALID_ALPHABET;
+    }
+    const int64_t decoded_length = CODEC_NAME(get_decoded_length)(src_length);
+    if(decoded_length < 0)
+    {
+        return decoded_length;
+    }
+    const int64_t group_count = decoded_length / info->bytes_per_group;
+    const int remainder = (int)(decoded_length % info->bytes_per_group);
+    if(remainder == 0)
+    {
+        return group_count * info->chars_per_group;
+    }
+    if(use_padding)
+    {
+        return (group_count + 1) * info->chars_per_group;
+    }
+    return group_count * info->chars_per_group +
+           (remainder * g_bits_per_byte + info->bits_per_char - 1) / info->bits_per_char;
+}
+
+codec_status CODEC_NAME(standard_transcoder_init_from_standard)(codec_standard_transcoder* const transcoder,
+                                                                const codec_standard_format format)
+{
+    const standard_format_info* const info = get_standard_format_info(format);
+    if(info == NULL)
+    {
+        return CODEC_ERROR_INVALID_ALPHABET;
+    }
+    transcoder->format = format;
+    transcoder->is_to_standard = false;
+    transcoder->use_padding = false;
+    transcoder->is_padding_seen = false;
+    transcoder->bits = 0;
+    transcoder->bit_count = 0;
+    transcoder->char_count = 0;
+    transcoder->tile_offset = 0;
+    transcoder->tile_length = 0;
+    build_standard_decode_table(info, transcoder->char_to_value);
+    return CODEC_STATUS_OK;
+}
+
+codec_status CODEC_NAME(standard_transcoder_init_to_standard)(codec_standard_transcoder* const transcoder,
+                                                              const codec_standard_format format,
+                                                              const bool use_padding)
+{
+    const codec_status status = CODEC_NAME(standard_transcoder_init_from_standard)(transcoder, format);
+    if(status != CODEC_STATUS_OK)
+    {
+        return status;
+    }
+    transcoder->is_to_standard = true;
+    transcoder->use_padding = use_padding;
+    return CODEC_STATUS_OK;
+}
+
+// Encodes the first length bytes of the tile into dst, for as long as there's
+// room, and drops the encoded bytes from the tile.
+static void flush_standard_tile(codec_standard_transcoder* const transcoder,
+                                const int64_t length,
+                                uint8_t** const dst_buffer_ptr,
+                                const uint8_t* const dst_end,
+                                const bool is_end_of_data)
+{
+    const uint8_t* tile_src = transcoder->tile;
+    encode_feed(&tile_src, length, dst_buffer_ptr, dst_end - *dst_buffer_ptr, is_end_of_data);
+    const int64_t offset = tile_src - transcoder->tile;
+    transcoder->tile_length -= offset;
+    memmove(transcoder->tile, transcoder->tile + offset, transcoder->tile_length);
+}
+
+static codec_status feed_from_standard(codec_standard_transcoder* const transcoder,
+                                       const standard_format_info* const info,
+                                       const uint8_t** const src_buffer_ptr,
+                                       const int64_t src_length,
+                                       uint8_t** const dst_buffer_ptr,
+                                       const int64_t dst_length,
+                                       const bool is_end_of_data)
+{
+    const uint8_t* const char_to_value = transcoder->char_to_value;
+    const int bits_per_char = info->bits_per_char;
+    const uint8_t* src = *src_buffer_ptr;
+    const uint8_t* const src_end = src + src_length;
+    uint8_t* dst = *dst_buffer_ptr;
+    const uint8_t* const dst_end = dst + dst_length;
+    uint32_t bits = transcoder->bits;
+    int bit_count = transcoder->bit_count;
+    codec_status status = CODEC_STATUS_OK;
+
+    // The binary data collects in the tile, which is encoded whenever it
+    // fills (a multiple of the group size, so no partial groups are encoded
+    // before the end of the data).
+    while(src < src_end)
+    {
+        if(transcoder->tile_length >= TRANSCODE_TILE_LENGTH)
+        {
+            flush_standard_tile(transcoder, transcoder->tile_length, &dst, dst_end, false);
+            if(transcoder->tile_length >= TRANSCODE_TILE_LENGTH)
+            {
+                break;
+            }
+        }
+        const uint8_t value = char_to_value[*src];
+        if(value < 0x80 && !transcoder->is_padding_seen)
+        {
+            bits = (bits << bits_per_char) | value;
+            bit_count += bits_per_char;
+            if(bit_count >= g_bits_per_byte)
+            {
+                bit_count -= g_bits_per_byte;
+                transcoder->tile[transcoder->tile_length++] = (uint8_t)(bits >> bit_count);
+            }
+            src++;
+            continue;
+        }
+        if(value == CHUNK_CODE_WHITESPACE)
+        {
+            src++;
+            continue;
+        }
+        if(value == STANDARD_CODE_PADDING)
+        {
+            // Only padding and whitespace may follow the first padding character.
+            transcoder->is_padding_seen = true;
+            src++;
+            continue;
+        }
+        KSLOG_DEBUG("Error: Invalid source data: %02x: [%c]", *src, *src);
+        status = CODEC_ERROR_INVALID_SOURCE_DATA;
+        break;
+    }
+
+    transcoder->bits = bits;
+    transcoder->bit_count = bit_count;
+    if(status == CODEC_STATUS_OK && is_end_of_data && src >= src_end)
+    {
+        // A final character that doesn't complete a byte is a truncated group.
+        if(bit_count >= bits_per_char)
+        {
+            KSLOG_DEBUG("Error: %d leftover bits", bit_count);
+            status = CODEC_ERROR_TRUNCATED_DATA;
+        }
+        else
+        {
+            flush_standard_tile(transcoder, transcoder->tile_length, &dst, dst_end, true);
+        }
+    }
+
+    *src_buffer_ptr = src;
+    *dst_buffer_ptr = dst;
+    if(status != CODEC_STATUS_OK)
+    {
+        return status;
+    }
+    if(is_end_of_data && src >= src_end && transcoder->tile_length == 0)
+    {
+        return CODEC_STATUS_OK;
+    }
+    return CODEC_STATUS_PARTIALLY_COMPLETE;
+}
+
+static codec_status feed_to_standard(codec_standard_transcoder* const transcoder,
+                                     const standard_format_info* const info,
+                                     const uint8_t** const src_buffer_ptr,
+                                     const int64_t src_length,
+                                     uint8_t** const dst_buffer_ptr,
+                                     const int64_t dst_length,
+                                     const bool is_end_of_data)
+{
+    const uint8_t* const alphabet = (const uint8_t*)info->alphabet;
+    const int bits_per_char = info->bits_per_char;
+    const uint32_t char_mask = (1u << bits_per_char) - 1;
+    const uint8_t* src = *src_buffer_ptr;
+    const uint8_t* const src_end = src + src_length;
+    uint8_t* dst = *dst_buffer_ptr;
+    const uint8_t* const dst_end = dst + dst_length;
+    uint32_t bits = transcoder->bits;
+    int bit_count = transcoder->bit_count;
+    bool is_src_done = false;
+    codec_status status = CODEC_STATUS_OK;
+
+    // The source is decoded a tile at a time, and each tile is then written
+    // out a character at a time.
+    while(dst < dst_end)
+    {
+        if(bit_count >= bits_per_char)
+        {
+            bit_count -= bits_per_char;
+            *dst++ = alphabet[(bits >> bit_count) & char_mask];
+            transcoder->char_count++;
+            continue;
+        }
+        if(transcoder->tile_offset < transcoder->tile_length)
+        {
+            bits = (bits << g_bits_per_byte) | transcoder->tile[transcoder->tile_offset++];
+            bit_count += g_bits_per_byte;
+            continue;
+        }
+        if(is_src_done)
+        {
+            break;
+        }
+
+        const uint8_t* const src_before = src;
+        uint8_t* tile_end = transcoder->tile;
+        status = decode_feed(&src,
+                             src_end - src,
+                             &tile_end,
+                             TRANSCODE_TILE_LENGTH,
+                             is_end_of_data ? CODEC_SRC_IS_AT_END_OF_STREAM : CODEC_STREAM_STATE_NONE);
+        transcoder->tile_offset = 0;
+        transcoder->tile_length = tile_end - transcoder->tile;
+        if(status == CODEC_STATUS_OK)
+        {
+            // Only trailing whitespace can be left over.
+            src = src_end;
+        }
+        else if(status != CODEC_STATUS_PARTIALLY_COMPLETE)
+        {
+            break;
+        }
+        is_src_done = src >= src_end || (transcoder->tile_length == 0 && src == src_before);
+        status = CODEC_STATUS_OK;
+    }
+
+    const bool is_data_done = status == CODEC_STATUS_OK &&
+                              is_end_of_data &&
+                              src >= src_end &&
+                              transcoder->tile_offset >= transcoder->tile_length &&
+                              bit_count < bits_per_char;
+    if(is_data_done)
+    {
+        if(bit_count > 0 && dst < dst_end)
+        {
+            *dst++ = alphabet[(bits << (bits_per_char - bit_count)) & char_mask];
+            transcoder->char_count++;
+            bit_count = 0;
+        }
+        while(bit_count == 0 &&
+              transcoder->use_padding &&
+              transcoder->char_count % info->chars_per_group != 0 &&
+              dst < dst_end)
+        {
+            *dst++ = '=';
+            transcoder->char_count++;
+        }
+    }
+
+    transcoder->bits = bits;
+    transcoder->bit_count = bit_count;
+    *src_buffer_ptr = src;
+    *dst_buffer_ptr = dst;
+    if(status != CODEC_STATUS_OK)
+    {
+        return status;
+    }
+    if(is_data_done &&
+       bit_count == 0 &&
+       (!transcoder->use_padding || transcoder->char_count % info->chars_per_group == 0))
+    {
+        return CODEC_STATUS_OK;
+    }
+    return CODEC_STATUS_PARTIALLY_COMPLETE;
+}
+
+codec_status CODEC_NAME(standard_transcoder_feed)(codec_standard_transcoder* const transcoder,
+                                                  const uint8_t** const src_buffer_ptr,
+                                                  const int64_t src_length,
+                                                  uint8_t** const dst_buffer_ptr,
+                                                  const int64_t dst_length,
+                                                  const bool is_end_of_data)
+{
+    if(src_length < 0 || dst_length < 0)
+    {
+        return CODEC_ERROR_INVALID_LENGTH;
+    }
+    const standard_format_info* const info = get_standard_format_info(transcoder->format);
+    if(info == NULL)
+    {
+        return CODEC_ERROR_INVALID_ALPHABET;
+    }
+    if(transcoder->is_to_standard)
+    {
+        return feed_to_standard(transcoder, info, src_buffer_ptr, src_length, dst_buffer_ptr, dst_length, is_end_of_data);
+    }
+    return feed_from_standard(transcoder, info, src_buffer_ptr, src_length, dst_buffer_ptr, dst_length, is_end_of_data);
+}
+
+// Runs a whole transcode through an initialized standard transcoder.
+static int64_t transcode_standard(codec_standard_transcoder* const transcoder,
+                                  const uint8_t* const src_buffer,
+                                  const int64_t src_length,
+                                  uint8_t* const dst_buffer,
+                                  const int64_t dst_length)
+{
+    const uint8_t* src = src_buffer;
+    uint8_t* dst = dst_buffer;
+    const codec_status status = CODEC_NAME(standard_transcoder_feed)(transcoder, &src, src_length, &dst, dst_length, true);
+    if(status == CODEC_STATUS_PARTIALLY_COMPLETE)
+    {
+        KSLOG_DEBUG("Error: Not enough room");
+        return CODEC_ERROR_NOT_ENOUGH_ROOM;
+    }
+    if(status != CODEC_STATUS_OK)
+    {
+        return status;
+    }
+    return dst - dst_buffer;
+}
+
+int64_t CODEC_NAME(transcode_from_standard)(const codec_standard_format format,
+                                            const uint8_t* const src_buffer,
+                                            const int64_t src_length,
+                                            uint8_t* const dst_buffer,
+                                            const int64_t dst_length)
+{
+    codec_standard_transcoder transcoder;
+    const codec_status status = CODEC_NAME(standard_transcoder_init_from_standard)(&transcoder, format);
+    if(status != CODEC_STATUS_OK)
+    {
+        return status;
+    }
+    return transcode_standard(&transcoder, src_buffer, src_length, dst_buffer, dst_length);
+}
+
+int64_t CODEC_NAME(transcode_to_standard)(const codec_standard_format format,
+                                          const bool use_padding,
+                                          const uint8_t* const src_buffer,
+                                          const int64_t src_length,
+                                          uint8_t* const dst_buffer,
+                                          const int64_t dst_length)
+{
+    codec_standard_transcoder transcoder;
+    const codec_status status = CODEC_NAME(standard_transcoder_init_to_standard)(&transcoder, format, use_padding);
+    if(status != CODEC_STATUS_OK)
+    {
+        return status;
+    }
+    return transcode_standard(&transcoder, src_buffer, src_length, dst_buffer, dst_length);
+}
+
+// The least common multiple of every codec's group size (1, 3, 4, 5 and 15).
+// The other codec's encoder is only given multiples of this until the end of
+// the data, so that it never sees a partial group before then.
+#define TRANSCODE_GROUP_LCM 60
+
+void CODEC_NAME(transcoder_init)(codec_transcoder* const transcoder, const codec_encode_function encode)
+{
+    transcoder->encode = encode;
+    transcoder->tile_length = 0;
+}
+
+// Encodes the first length bytes of the tile into dst, in one go if there's
+// room, and otherwise in pieces for as long as there's room.
+static codec_status flush_transcoder_tile(codec_transcoder* const transcoder,
+                                          const int64_t length,
+                                          uint8_t** const dst_buffer_ptr,
+                                          const uint8_t* const dst_end)
+{
+    codec_status status = CODEC_STATUS_OK;
+    int64_t offset = 0;
+    int64_t piece_length = length;
+    while(offset < length)
+    {
+        if(piece_length > length - offset)
+        {
+            piece_length = length - offset;
+        }
+        const int64_t result = transcoder->encode(transcoder->tile + offset,
+                                                  piece_length,
+                                                  *dst_buffer_ptr,
+                                                  dst_end - *dst_buffer_ptr);
+        if(result == CODEC_ERROR_NOT_ENOUGH_ROOM && piece_length > TRANSCODE_GROUP_LCM)
+        {
+            piece_length = TRANSCODE_GROUP_LCM;
+            continue;
+        }
+        if(result == CODEC_ERROR_NOT_ENOUGH_ROOM)
+        {
+            status = CODEC_STATUS_PARTIALLY_COMPLETE;
+            break;
+        }
+        if(result < 0)
+        {
+            status = (codec_status)result;
+            break;
+        }
+        *dst_buffer_ptr += result;
+        offset += piece_length;
+    }
+
+    transcoder->tile_length -= offset;
+    memmove(transcoder->tile, transcoder->tile + offset, transcoder->tile_length);
+    return status;
+}
+
+codec_status CODEC_NAME(transcoder_feed)(codec_transcoder* const transcoder,
+                                         const uint8_t** const src_buffer_ptr,
+                                         const int64_t src_length,
+                                         uint8_t** const dst_buffer_ptr,
+                                         const int64_t dst_length,
+                                         const bool is_end_of_data)
+{
+    if(src_length < 0 || dst_length < 0)
+    {
+        return CODEC_ERROR_INVALID_LENGTH;
+    }
+
+    const uint8_t* src = *src_buffer_ptr;
+    const uint8_t* const src_end = src + src_length;
+    uint8_t* dst = *dst_buffer_ptr;
+    const uint8_t* const dst_end = dst + dst_length;
+    uint8_t* const tile_end = transcoder->tile + sizeof(transcoder->tile);
+    bool is_src_done = false;
+    codec_status status = CODEC_STATUS_OK;
+
+    while(status == CODEC_STATUS_OK)
+    {
+        // Full tiles are passed on in whole groups of every codec, and at
+        // the end of the data, everything is.
+        const bool is_last = is_end_of_data && is_src_done;
+        if(transcoder->tile_length >= TRANSCODE_TILE_LENGTH || (is_last && transcoder->tile_length > 0))
+        {
+            const int64_t flush_length = is_last
+                ? transcoder->tile_length
+                : transcoder->tile_length - transcoder->tile_length % TRANSCODE_GROUP_LCM;
+            status = flush_transcoder_tile(transcoder, flush_length, &dst, dst_end);
+            continue;
+        }
+        if(is_src_done)
+        {
+            break;
+        }
+
+        const uint8_t* const src_before = src;
+        uint8_t* tile_dst = transcoder->tile + transcoder->tile_length;
+        status = decode_feed(&src,
+                             src_end - src,
+                             &tile_dst,
+                             tile_end - tile_dst,
+                             is_end_of_data ? CODEC_SRC_IS_AT_END_OF_STREAM : CODEC_STREAM_STATE_NONE);
+        const int64_t decoded_length = tile_dst - (transcoder->tile + transcoder->tile_length);
+        transcoder->tile_length += decoded_length;
+        if(status == CODEC_STATUS_OK)
+        {
+            // Only trailing whitespace can be left over.
+            src = src_end;
+        }
+        else if(status != CODEC_STATUS_PARTIALLY_COMPLETE)
+        {
+            break;
+        }
+        is_src_done = src >= src_end || (decoded_length == 0 && src == src_before);
+        status = CODEC_STATUS_OK;
+    }
+
+    *src_buffer_ptr = src;
+    *dst_buffer_ptr = dst;
+    if(status != CODEC_STATUS_OK && status != CODEC_STATUS_PARTIALLY_COMPLETE)
+    {
+        return status;
+    }
+    if(is_end_of_data && src >= src_end && transcoder->tile_length == 0)
+    {
+        return CODEC_STATUS_OK;
+    }
+    return CODEC_STATUS_PARTIALLY_COMPLETE;
+}
+
+int64_t CODEC_NAME(transcode)(const codec_encode_function encode,
+                              const uint8_t* const src_buffer,
+                              const int64_t src_length,
+                              uint8_t* const dst_buffer,
+                              const int64_t dst_length)
+{
+    codec_transcoder transcoder;
+    CODEC_NAME(transcoder_init)(&transcoder, encode);
+    const uint8_t* src = src_buffer;
+    uint8_t* dst = dst_buffer;
+    const codec_status status = CODEC_NAME(transcoder_feed)(&transcoder, &src, src_length, &dst, dst_length, true);
+    if(status == CODEC_STATUS_PARTIALLY_COMPLETE)
+    {
+        KSLOG_DEBUG("Error: Not enough room");
+        return CODEC_ERROR_NOT_ENOUGH_ROOM;
+    }
+    if(status != CODEC_STATUS_OK)
+    {
+        return status;
+    }
+    return dst - dst_buffer;
+}
+
+int64_t CODEC_NAME(get_encoded_length_with_layout)(const int64_t decoded_length,
+                                                   const bool include_length_field,
+                                                   const codec_layout* const layout)
+{
+    if(layout->line_length < 0 || layout->indent_length < 0)
+    {
+        return CODEC_ERROR_INVALID_LENGTH;
+    }
+    const int64_t encoded_length = CODEC_NAME(get_encoded_length)(decoded_length, include_length_field);
+    if(encoded_length < 0 || layout->line_length == 0)
+    {
+        return encoded_length < 0 ? encoded_length : layout->indent_length + encoded_length;
+    }
+    return layout->indent_length +
+           encoded_length +
+           encoded_length / layout->line_length * get_line_separator_length(layout);
+}
+
+codec_status CODEC_NAME(layout_encoder_init)(codec_layout_encoder* const encoder, const codec_layout* const layout)
+{
+    if(layout->line_length < 0 || layout->indent_length < 0)
+    {
+        return CODEC_ERROR_INVALID_LENGTH;
+    }
+    encoder->layout = *layout;
+    encoder->declared_length = -1;
+    encoder->encoded_length = 0;
+    encoder->column = -1;
+    encoder->separator_offset = 0;
+    encoder->pending_offset = 0;
+    encoder->pending_length = 0;
+    return CODEC_STATUS_OK;
+}
+
+// Starts a new record (with a length field if length >= 0) where the last
+// one left off, so that several records can be laid out as one text.
+static void start_layout_record(codec_layout_encoder* const encoder, const int64_t length)
+{
+    encoder->declared_length = length;
+    encoder->encoded_length = 0;
+    encoder->pending_offset = 0;
+    encoder->pending_length = 0;
+    if(length >= 0)
+    {
+        encoder->pending_length = (int)CODEC_NAME(write_length_field)(length,
+                                                                      encoder->pending,
+                                                                      sizeof(encoder->pending));
+    }
+}
+
+codec_status CODEC_L_NAME(layout_encoder_init)(codec_layout_encoder* const encoder,
+                                               const codec_layout* const layout,
+                                               const int64_t length)
+{
+    if(length < 0)
+    {
+        return CODEC_ERROR_INVALID_LENGTH;
+    }
+    const codec_status status = CODEC_NAME(layout_encoder_init)(encoder, layout);
+    if(status == CODEC_STATUS_OK)
+    {
+        start_layout_record(encoder, length);
+    }
+    return status;
+}
+
+// Writes as much as fits of the indentation (before the first line) or the
+// line break and indentation (at the end of a full line), continuing from
+// wherever the last call left off.
+// Returns true once the next character can go on the current line.
+static bool write_line_start(codec_layout_encoder* const encoder,
+                             uint8_t** const dst_ptr,
+                             const uint8_t* const dst_end)
+{
+    const codec_layout* const layout = &encoder->layout;
+    int line_break_length = 0;
+    if(encoder->column >= 0)
+    {
+        if(layout->line_length == 0 || encoder->column < layout->line_length)
+        {
+            return true;
+        }
+        line_break_length = layout->use_crlf ? 2 : 1;
+    }
+
+    uint8_t* dst = *dst_ptr;
+    const uint8_t* const line_break = (const uint8_t*)"\r\n" + 2 - line_break_length;
+    while(encoder->separator_offset < line_break_length && dst < dst_end)
+    {
+        *dst++ = line_break[encoder->separator_offset++];
+    }
+    const int64_t separator_length = line_break_length + layout->indent_length;
+    int64_t space_count = separator_length - encoder->separator_offset;
+    if(space_count > dst_end - dst)
+    {
+        space_count = dst_end - dst;
+    }
+    if(space_count > 0)
+    {
+        memset(dst, ' ', space_count);
+        dst += space_count;
+        encoder->separator_offset += space_count;
+    }
+    *dst_ptr = dst;
+
+    if(encoder->separator_offset < separator_length)
+    {
+        return false;
+    }
+    encoder->separator_offset = 0;
+    encoder->column = 0;
+    return true;
+}
+
+// Writes as many of the pending characters as fit, along with the line
+// breaks and indentation between them.
+// Returns true once all of them have been written.
+static bool write_pending_chars(codec_layout_encoder* const encoder,
+                                uint8_t** const dst_ptr,
+                                const uint8_t* const dst_end)
+{
+    const int64_t line_length = encoder->layout.line_length;
+    while(encoder->pending_offset < encoder->pending_length)
+    {
+        if(!write_line_start(encoder, dst_ptr, dst_end))
+        {
+            return false;
+        }
+        int64_t count = encoder->pending_length - encoder->pending_offset;
+        if(line_length > 0 && count > line_length - encoder->column)
+        {
+            count = line_length - encoder->column;
+        }
+        if(count > dst_end - *dst_ptr)
+        {
+            count = dst_end - *dst_ptr;
+        }
+        if(count == 0)
+        {
+            return false;
+        }
+        memcpy(*dst_ptr, encoder->pending + encoder->pending_offset, count);
+        *dst_ptr += count;
+        encoder->pending_offset += (int)count;
+        encoder->column += count;
+    }
+    return true;
+}
+
+codec_status CODEC_NAME(layout_encoder_feed)(codec_layout_encoder* const encoder,
+                                             const uint8_t** const src_buffer_ptr,
+                                             const int64_t src_length,
+                                             uint8_t** const dst_buffer_ptr,
+                                             const int64_t dst_length,
+                                             const bool is_end_of_data)
+{
+    if(src_length < 0 || dst_length < 0)
+    {
+        return CODEC_ERROR_INVALID_LENGTH;
+    }
+
+    const codec_layout* const layout = &encoder->layout;
+    const bool has_length_field = encoder->declared_length >= 0;
+    bool is_last_feed = is_end_of_data;
+    if(has_length_field)
+    {
+        const int64_t remaining_length = encoder->declared_length - encoder->encoded_length;
+        if(src_length > remaining_length)
+        {
+            KSLOG_DEBUG("Error: Got %d bytes but only %d remain", src_length, remaining_length);
+            return CODEC_ERROR_TOO_MUCH_DATA;
+        }
+        if(is_end_of_data && src_length < remaining_length)
+        {
+            KSLOG_DEBUG("Error: Data ended %d bytes short", remaining_length - src_length);
+            return CODEC_ERROR_TRUNCATED_DATA;
+        }
+        is_last_feed = src_length == remaining_length;
+    }
+
+    const uint8_t* src = *src_buffer_ptr;
+    const uint8_t* const src_end = src + src_length;
+    uint8_t* dst = *dst_buffer_ptr;
+    const uint8_t* const dst_end = dst + dst_length;
+    const int64_t line_length = layout->line_length;
+
+    // The first line is indented even if there's nothing to write.
+    codec_status status = CODEC_STATUS_OK;
+    if(encoder->column < 0 && !write_line_start(encoder, &dst, dst_end))
+    {
+        status = CODEC_STATUS_PARTIALLY_COMPLETE;
+    }
+
+    // Everything is written a character at a time if need be, so that any
+    // destination room makes progress.
+    while(status == CODEC_STATUS_OK)
+    {
+        if(!write_pending_chars(encoder, &dst, dst_end))
+        {
+            status = CODEC_STATUS_PARTIALLY_COMPLETE;
+            break;
+        }
+        if(src >= src_end)
+        {
+            break;
+        }
+
+        // Whole groups that fit on the rest of the line are encoded straight
+        // into place.
+        if(dst_end - dst >= g_chunks_per_group)
+        {
+            if(!write_line_start(encoder, &dst, dst_end))
+            {
+                status = CODEC_STATUS_PARTIALLY_COMPLETE;
+                break;
+            }
+            const int64_t line_group_count = line_length > 0
+                ? (line_length - encoder->column) / g_chunks_per_group
+                : (src_end - src) / g_bytes_per_group;
+            const int64_t src_group_count = (src_end - src) / g_bytes_per_group;
+            const int64_t dst_group_count = (dst_end - dst) / g_chunks_per_group;
+            int64_t group_count = line_group_count < src_group_count ? line_group_count : src_group_count;
+            group_count = group_count < dst_group_count ? group_count : dst_group_count;
+            if(group_count > 0)
+            {
+                uint8_t* const dst_start = dst;
+                encode_feed(&src, group_count * g_bytes_per_group, &dst, group_count * g_chunks_per_group, false);
+                encoder->column += dst - dst_start;
+                continue;
+            }
+        }
+
+        // Anything else (a group that crosses the end of the line, the final
+        // partial group, or a group that doesn't fit) becomes pending.
+        const int64_t group_length = src_end - src < g_bytes_per_group ? src_end - src : g_bytes_per_group;
+        if(group_length < g_bytes_per_group && !is_last_feed)
+        {
+            break;
+        }
+        uint8_t* pending_end = encoder->pending;
+        encode_feed(&src, group_length, &pending_end, sizeof(encoder->pending), is_last_feed);
+        encoder->pending_offset = 0;
+        encoder->pending_length = (int)(pending_end - encoder->pending);
+    }
+
+    encoder->encoded_length += src - *src_buffer_ptr;
+    *src_buffer_ptr = src;
+
+    // A full last line still gets its line break (as the command line tool
+    // has always done).
+    const bool is_complete = is_last_feed && src >= src_end && encoder->pending_offset == encoder->pending_length;
+    if(status == CODEC_STATUS_OK && is_complete && line_length > 0 && encoder->column == line_length &&
+       !write_line_start(encoder, &dst, dst_end))
+    {
+        status = CODEC_STATUS_PARTIALLY_COMPLETE;
+    }
+    *dst_buffer_ptr = dst;
+
+    if(status == CODEC_STATUS_OK && has_length_field && !is_complete)
+    {
+        return CODEC_STATUS_PARTIALLY_COMPLETE;
+    }
+    return status;
+}
+
+int64_t CODEC_NAME(encode_with_layout)(const uint8_t* const src_buffer,
+                                       const int64_t src_length,
+                                       uint8_t* const dst_buffer,
+                                       const int64_t dst_length,
+                                       const codec_layout* const layout)
+{
+    codec_layout_encoder encoder;
+    codec_status status = CODEC_NAME(layout_encoder_init)(&encoder, layout);
+    if(status != CODEC_STATUS_OK)
+    {
+        return status;
+    }
+    const uint8_t* src = src_buffer;
+    uint8_t* dst = dst_buffer;
+    status = CODEC_NAME(layout_encoder_feed)(&encoder, &src, src_length, &dst, dst_length, true);
+    if(status == CODEC_STATUS_PARTIALLY_COMPLETE)
+    {
+        KSLOG_DEBUG("Error: Not enough room");
+        return CODEC_ERROR_NOT_ENOUGH_ROOM;
+    }
+    if(status != CODEC_STATUS_OK)
+    {
+        return status;
+    }
+    return dst - dst_buffer;
+}
+
+// The container writer works through these stages in order.
+enum
+{
+    CONTAINER_STAGE_SEGMENTS = 0,
+    CONTAINER_STAGE_INDEX    = 1,
+    CONTAINER_STAGE_TRAILER  = 2,
+    CONTAINER_STAGE_DONE     = 3,
+};
+
+codec_status CODEC_NAME(container_writer_init)(codec_container_writer* const writer,
+                                               const int64_t segment_length,
+                                               const codec_layout* const layout)
+{
+    if(segment_length <= 0)
+    {
+        return CODEC_ERROR_INVALID_LENGTH;
+    }
+    // The whole container is laid out as one text, and the index records
+    // where each segment actually starts within it.
+    const codec_layout no_layout = {0, 0, false};
+    const codec_status status = CODEC_NAME(layout_encoder_init)(&writer->encoder, layout != NULL ? layout : &no_layout);
+    if(status != CODEC_STATUS_OK)
+    {
+        return status;
+    }
+    writer->segment_length = segment_length;
+    writer->data_length = 0;
+    writer->position = 0;
+    writer->stage = CONTAINER_STAGE_SEGMENTS;
+    return CODEC_STATUS_OK;
+}
+
+// Gets the bytes of the index (or trailer) from position onwards. Values are
+// generated as needed, so the index never has to be held in memory.
+static int64_t get_container_index_bytes(const codec_container_writer* const writer,
+                                         const int64_t position,
+                                         uint8_t* const dst,
+                                         const int64_t dst_length)
+{
+    const codec_layout* const layout = &writer->encoder.layout;
+    const int64_t data_length = writer->data_length;
+    const int64_t segment_length = writer->segment_length;
+    const int64_t full_segment_encoded_length = CODEC_NAME(get_encoded_length)(segment_length, true);
+    const int64_t segment_count = get_container_segment_count(data_length, segment_length);
+
+    if(writer->stage == CONTAINER_STAGE_TRAILER)
+    {
+        // All segments but the last have the same encoded length.
+        int64_t raw_index_offset = data_length / segment_length * full_segment_encoded_length;
+        if(data_length % segment_length != 0)
+        {
+            raw_index_offset += CODEC_NAME(get_encoded_length)(data_length % segment_length, true);
+        }
+        uint8_t trailer[g_container_value_length];
+        write_container_value(trailer, get_layout_offset(layout, raw_index_offset));
+        const int64_t length = g_container_value_length - position;
+        memcpy(dst, trailer + position, length);
+        return length;
+    }
+
+    const int64_t index_length = get_container_index_length(segment_count);
+    const int64_t end = index_length - position < dst_length ? index_length : position + dst_length;
+    uint8_t value[g_container_value_length];
+    for(int64_t i = position; i < end; i++)
+    {
+        const int64_t value_index = i / g_container_value_length;
+        const int value_offset = (int)(i % g_container_value_length);
+        if(i == position || value_offset == 0)
+        {
+            int64_t value_data = value_index == 0 ? segment_length : data_length;
+            if(value_index >= 2)
+            {
+                value_data = get_layout_offset(layout, (value_index - 2) * full_segment_encoded_length);
+            }
+            write_container_value(value, value_data);
+        }
+        dst[i - position] = value[value_offset];
+    }
+    return end - position;
+}
+
+codec_status CODEC_NAME(container_writer_feed)(codec_container_writer* const writer,
+                                               const uint8_t** const src_buffer_ptr,
+                                               const int64_t src_length,
+                                               uint8_t** const dst_buffer_ptr,
+                                               const int64_t dst_length,
+                                               const bool is_end_of_data)
+{
+    if(src_length < 0 || dst_length < 0)
+    {
+        return CODEC_ERROR_INVALID_LENGTH;
+    }
+
+    codec_layout_encoder* const encoder = &writer->encoder;
+    const uint8_t* src = *src_buffer_ptr;
+    const uint8_t* const src_end = src + src_length;
+    uint8_t* dst = *dst_buffer_ptr;
+    const uint8_t* const dst_end = dst + dst_length;
+    codec_status status = CODEC_STATUS_OK;
+
+    // Segments are streamed through as they arrive. A segment's length field
+    // comes first, so a segment only starts once all of it is available (or
+    // the data has ended).
+    while(writer->stage == CONTAINER_STAGE_SEGMENTS)
+    {
+        const bool is_in_segment = encoder->declared_length >= 0;
+        if(!is_in_segment)
+        {
+            if(src_end - src >= writer->segment_length)
+            {
+                start_layout_record(encoder, writer->segment_length);
+            }
+            else if(is_end_of_data && src < src_end)
+            {
+                start_layout_record(encoder, src_end - src);
+            }
+            else if(is_end_of_data)
+            {
+                KSLOG_DEBUG("Container data ends at %d bytes", writer->data_length);
+                writer->stage = CONTAINER_STAGE_INDEX;
+                const int64_t segment_count = get_container_segment_count(writer->data_length, writer->segment_length);
+                start_layout_record(encoder, get_container_index_length(segment_count));
+                break;
+            }
+            else
+            {
+                status = CODEC_STATUS_PARTIALLY_COMPLETE;
+                break;
+            }
+        }
+
+        const int64_t remaining_length = encoder->declared_length - encoder->encoded_length;
+        const uint8_t* const segment_src = src;
+        status = CODEC_NAME(layout_encoder_feed)(encoder,
+                                                 &src,
+                                                 src_end - src < remaining_length ? src_end - src : remaining_length,
+                                                 &dst,
+                                                 dst_end - dst,
+                                                 false);
+        writer->data_length += src - segment_src;
+        if(status != CODEC_STATUS_OK)
+        {
+            break;
+        }
+        encoder->declared_length = -1;
+    }
+    *src_buffer_ptr = src;
+    if(writer->stage == CONTAINER_STAGE_SEGMENTS)
+    {
+        *dst_buffer_ptr = dst;
+        return status;
+    }
+
+    // The index and trailer are generated a little at a time, in multiples
+    // of the group size so that only the last piece has a partial group.
+    while(writer->stage != CONTAINER_STAGE_DONE)
+    {
+        uint8_t piece[g_bytes_per_group * g_container_value_length];
+        const int64_t piece_length = get_container_index_bytes(writer, writer->position, piece, sizeof(piece));
+        const uint8_t* piece_src = piece;
+        status = CODEC_NAME(layout_encoder_feed)(encoder,
+                                                 &piece_src,
+                                                 piece_length,
+                                                 &dst,
+                                                 dst_end - dst,
+                                                 writer->stage == CONTAINER_STAGE_TRAILER);
+        writer->position += piece_src - piece;
+        if(status == CODEC_STATUS_OK)
+        {
+            writer->position = 0;
+            writer->stage++;
+            if(writer->stage == CONTAINER_STAGE_TRAILER)
+            {
+                start_layout_record(encoder, -1);
+            }
+        }
+        else if(status != CODEC_STATUS_PARTIALLY_COMPLETE || dst == dst_end)
+        {
+            break;
+        }
+    }
+    *dst_buffer_ptr = dst;
+    return status;
+}
+
+int64_t CODEC_NAME(container_encode)(const uint8_t* const src_buffer,
+                                     const int64_t src_length,
+                                     const int64_t segment_length,
+                                     uint8_t* const dst_buffer,
+                                     const int64_t dst_length,
+                                     const codec_layout* const layout)
+{
+    const int64_t required_length = CODEC_NAME(container_get_encoded_length)(src_length, segment_length, layout);
+    if(required_length < 0)
+    {
+        return required_length;
+    }
+    if(dst_length < 0)
+    {
+        return CODEC_ERROR_INVALID_LENGTH;
+    }
+    if(dst_length < required_length)
+    {
+        KSLOG_DEBUG("Error: Require %d bytes but only %d available", required_length, dst_length);
+        return CODEC_ERROR_NOT_ENOUGH_ROOM;
+    }
+
+    codec_container_writer writer;
+    codec_status status = CODEC_NAME(container_writer_init)(&writer, segment_length, layout);
+    if(status != CODEC_STATUS_OK)
+    {
+        return status;
+    }
+    const uint8_t* src = src_buffer;
+    uint8_t* dst = dst_buffer;
+    status = CODEC_NAME(container_writer_feed)(&writer, &src, src_length, &dst, dst_length, true);
+    if(status != CODEC_STATUS_OK)
+    {
+        return status;
+    }
+    KSLOG_DEBUG("Encoded container of %d bytes into %d chars", src_length, dst - dst_buffer);
+    return dst - dst_buffer;
+}
+
+codec_status CODEC_NAME(detect_layout)(const uint8_t* const src_buffer,
+                                       const int64_t src_length,
+                                       codec_layout* const layout)
+{
+    if(src_length < 0)
+    {
+        return CODEC_ERROR_INVALID_LENGTH;
+    }
+    const uint8_t* src = src_buffer;
+    const uint8_t* const src_end = src_buffer + src_length;
+
+    while(src < src_end && *src == ' ')
+    {
+        src++;
+    }
+    layout->indent_length = src - src_buffer;
+    layout->line_length = 0;
+    layout->use_crlf = false;
+
+    const uint8_t* const line = src;
+    while(src < src_end && g_encode_char_to_chunk[*src] < 0x80)
+    {
+        src++;
+    }
+    if(src == src_end)
+    {
+        KSLOG_DEBUG("Detected a single line indented by %d", layout->indent_length);
+        return CODEC_STATUS_OK;
+    }
+    const int64_t line_length = src - line;
+    if(src_end - src >= 2 && src[0] == '\r' && src[1] == '\n')
+    {
+        layout->use_crlf = true;
+        src += 2;
+    }
+    else if(*src == '\n')
+    {
+        src++;
+    }
+    else
+    {
+        KSLOG_DEBUG("Error: Unexpected %02x after %d characters", *src, line_length);
+        return CODEC_ERROR_INVALID_SOURCE_DATA;
+    }
+    if(line_length == 0)
+    {
+        KSLOG_DEBUG("Error: Empty first line");
+        return CODEC_ERROR_INVALID_SOURCE_DATA;
+    }
+
+    // The next line must be indented the same way.
+    for(int64_t i = 0; i < layout->indent_length && src + i < src_end; i++)
+    {
+        if(src[i] != ' ')
+        {
+            KSLOG_DEBUG("Error: Second line is not indented by %d", layout->indent_length);
+            return CODEC_ERROR_INVALID_SOURCE_DATA;
+        }
+    }
+    layout->line_length = line_length;
+    KSLOG_DEBUG("Detected lines of %d indented by %d, crlf %d",
+                layout->line_length, layout->indent_length, layout->use_crlf);
+    return CODEC_STATUS_OK;
+}
+
+// Decodes up to group_count whole groups, stopping at the first one that
+// contains anything other than encoded characters. Returns the number of
+// groups decoded.
+static int64_t decode_whole_groups(const uint8_t* src, const int64_t group_count, uint8_t* dst)
+{
+    for(int64_t group = 0; group < group_count; group++)
+    {
+        codec_accumulator accumulator = 0;
+        uint8_t chunk_bits = 0;
+        for(int i = 0; i < g_chunks_per_group; i++)
+        {
+            const uint8_t next_chunk = g_encode_char_to_chunk[src[i]];
+            chunk_bits |= next_chunk;
+            accumulator = accumulate_chunk(accumulator, next_chunk);
+        }
+        if(chunk_bits & 0x80)
+        {
+            return group;
+        }
+        for(int i = g_bytes_per_group - 1; i >= 0; i--)
+        {
+            *dst++ = extract_byte_from_accumulator(accumulator, i);
+        }
+        src += g_chunks_per_group;
+    }
+    return group_count;
+}
+
+static bool is_line_separator(const codec_layout* const layout, const uint8_t* src)
+{
+    if(layout->use_crlf && *src++ != '\r')
+    {
+        return false;
+    }
+    if(*src++ != '\n')
+    {
+        return false;
+    }
+    for(int64_t i = 0; i < layout->indent_length; i++)
+    {
+        if(src[i] != ' ')
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Decodes full lines that follow the layout exactly, skipping over the line
+// separators without looking at the characters in between. Stops at the
+// first deviation (which includes a last line that isn't full), leaving
+// *src_buffer_ptr at the first character of the first group not decoded.
+//
+// *sync_src_ptr and *sync_dst_ptr are left at the last place where both a
+// line and a group ended (just before the next line's indent), from which
+// decoding can resume with the same layout.
+static void decode_laid_out_lines(const codec_layout* const layout,
+                                  const uint8_t** const src_buffer_ptr,
+                                  const uint8_t* const src_end,
+                                  uint8_t** const dst_buffer_ptr,
+                                  const uint8_t* const dst_end,
+                                  const uint8_t** const sync_src_ptr,
+                                  uint8_t** const sync_dst_ptr)
+{
+    const uint8_t* src = *src_buffer_ptr;
+    uint8_t* dst = *dst_buffer_ptr;
+    const int64_t line_length = layout->line_length;
+    const int64_t separator_length = get_line_separator_length(layout);
+    const int64_t line_break_length = separator_length - layout->indent_length;
+    *sync_src_ptr = src;
+    *sync_dst_ptr = dst;
+
+    if(src_end - src < layout->indent_length)
+    {
+        return;
+    }
+    for(int64_t i = 0; i < layout->indent_length; i++)
+    {
+        if(src[i] != ' ')
+        {
+            return;
+        }
+    }
+    src += layout->indent_length;
+
+    // A group that's split across lines is stitched back together here.
+    uint8_t group[g_chunks_per_group];
+    int group_length = 0;
+    const uint8_t* group_start = src;
+
+    for(;;)
+    {
+        const uint8_t* line = src;
+        const uint8_t* line_end = src_end;
+        if(line_length > 0)
+        {
+            if(src_end - line < line_length + separator_length)
+            {
+                break;
+            }
+            line_end = line + line_length;
+            if(!is_line_separator(layout, line_end))
+            {
+                break;
+            }
+        }
+
+        if(group_length > 0)
+        {
+            int chars_to_copy = g_chunks_per_group - group_length;
+            if(chars_to_copy > line_end - line)
+            {
+                chars_to_copy = line_end - line;
+            }
+            memcpy(group + group_length, line, chars_to_copy);
+            group_length += chars_to_copy;
+            line += chars_to_copy;
+            if(group_length == g_chunks_per_group)
+            {
+                if(dst_end - dst < g_bytes_per_group || decode_whole_groups(group, 1, dst) == 0)
+                {
+                    break;
+                }
+                dst += g_bytes_per_group;
+                group_length = 0;
+                group_start = line;
+            }
+        }
+
+        if(group_length == 0)
+        {
+            const int64_t line_group_count = (line_end - line) / g_chunks_per_group;
+            const int64_t dst_group_count = (dst_end - dst) / g_bytes_per_group;
+            const int64_t group_count = line_group_count < dst_group_count ? line_group_count : dst_group_count;
+            const int64_t decoded_count = decode_whole_groups(line, group_count, dst);
+            line += decoded_count * g_chunks_per_group;
+            dst += decoded_count * g_bytes_per_group;
+            group_start = line;
+            if(decoded_count < line_group_count || line_length == 0)
+            {
+                break;
+            }
+            group_length = line_end - line;
+            memcpy(group, line, group_length);
+        }
+        if(group_length == 0)
+        {
+            *sync_src_ptr = line_end + line_break_length;
+            *sync_dst_ptr = dst;
+        }
+        src = line_end + separator_length;
+    }
+
+    *src_buffer_ptr = group_start;
+    *dst_buffer_ptr = dst;
+}
+
+int64_t CODEC_NAME(decode_with_layout)(const uint8_t* const src_buffer,
+                                       const int64_t src_length,
+                                       uint8_t* const dst_buffer,
+                                       const int64_t dst_length,
+                                       const codec_layout* layout)
+{
+    if(src_length < 0 || dst_length < 0)
+    {
+        return CODEC_ERROR_INVALID_LENGTH;
+    }
+    codec_layout detected_layout;
+    if(layout == NULL)
+    {
+        if(CODEC_NAME(detect_layout)(src_buffer, src_length, &detected_layout) == CODEC_STATUS_OK)
+        {
+            layout = &detected_layout;
+        }
+    }
+    else if(layout->line_length < 0 || layout->indent_length < 0)
+    {
+        return CODEC_ERROR_INVALID_LENGTH;
+    }
+
+    const uint8_t* src = src_buffer;
+    const uint8_t* const src_end = src_buffer + src_length;
+    uint8_t* dst = dst_buffer;
+    if(layout != NULL)
+    {
+        const uint8_t* sync_src = NULL;
+        uint8_t* sync_dst = NULL;
+        decode_laid_out_lines(layout, &src, src_end, &dst, dst_buffer + dst_length, &sync_src, &sync_dst);
+        KSLOG_DEBUG("Decoded %d laid out characters into %d bytes", src - src_buffer, dst - dst_buffer);
+    }
+
+    // Whatever doesn't follow the layout is decoded the usual way.
+    const int64_t result = CODEC_NAME(decode)(src, src_end - src, dst, dst_buffer + dst_length - dst);
+    if(result < 0)
+    {
+        return result;
+    }
+    return dst - dst_buffer + result;
+}
+
+codec_status CODEC_NAME(decode_with_layout_feed)(const codec_layout* const layout,
+                                                 const uint8_t** const src_buffer_ptr,
+                                                 const int64_t src_length,
+                                                 uint8_t** const dst_buffer_ptr,
+                                                 const int64_t dst_length,
+                                                 const codec_stream_state stream_state)
+{
+    if(src_length < 0 || dst_length < 0)
+    {
+        return CODEC_ERROR_INVALID_LENGTH;
+    }
+    if(layout != NULL && (layout->line_length < 0 || layout->indent_length < 0))
+    {
+        return CODEC_ERROR_INVALID_LENGTH;
+    }
+
+    const uint8_t* src = *src_buffer_ptr;
+    const uint8_t* const src_end = src + src_length;
+    uint8_t* dst = *dst_buffer_ptr;
+    uint8_t* const dst_end = dst + dst_length;
+    if(layout != NULL)
+    {
+        const uint8_t* sync_src = NULL;
+        uint8_t* sync_dst = NULL;
+        decode_laid_out_lines(layout, &src, src_end, &dst, dst_end, &sync_src, &sync_dst);
+        KSLOG_DEBUG("Decoded %d laid out characters into %d bytes, in sync up to %d",
+                    src - *src_buffer_ptr, dst - *dst_buffer_ptr, sync_src - *src_buffer_ptr);
+
+        // Mid-stream, stop where the next feed can pick up the layout again.
+        if(sync_src > *src_buffer_ptr &&
+           !(stream_state & (CODEC_SRC_IS_AT_END_OF_STREAM | CODEC_DST_IS_AT_END_OF_STREAM)))
+        {
+            *src_buffer_ptr = sync_src;
+            *dst_buffer_ptr = sync_dst;
+            return CODEC_STATUS_PARTIALLY_COMPLETE;
+        }
+    }
+
+    // Whatever doesn't follow the layout is decoded the usual way.
+    *src_buffer_ptr = src;
+    *dst_buffer_ptr = dst;
+    return decode_feed(src_buffer_ptr, src_end - src, dst_buffer_ptr, dst_end - dst, stream_state);
+}
@@ -0,0 +1,104 @@
+#!/usr/bin/env python3
+#
+# Generates the single-header distribution of a safeXX library by combining
+# its public header, its library source and the private headers that the
+# source includes.
+#
+# Usage: amalgamate.py <public header> <library source> <output> <version> [depfile]
+
+import os
+import re
+import sys
+
+header_path, source_path, output_path, version = sys.argv[1:5]
+depfile_path = sys.argv[5] if len(sys.argv) > 5 else None
+name = os.path.splitext(os.path.basename(header_path))[0]
+upper = name.upper()
+guard = upper + "_AMALGAMATED_H"
+
+with open(header_path) as f:
+    header = f.read()
+with open(source_path) as f:
+    source = f.read()
+
+# The private headers (the shared codec engine, and the tables generated into
+# the build directory) are pasted in where library.c includes them.
+search_dirs = [os.path.dirname(source_path), os.path.dirname(os.path.abspath(output_path))]
+inlined_paths = []
+
+def inline_include(match):
+    for directory in search_dirs:
+        path = os.path.join(directory, match.group(1))
+        if os.path.exists(path):
+            inlined_paths.append(path)
+            with open(path) as f:
+                return f.read()
+    sys.exit("%s: cannot find %s" % (source_path, match.group(1)))
+
+source = re.sub(r'^#include "((?!kslogger\.h)[^"]+)"\n', inline_include, source, flags=re.M)
+
+# The header and source are pasted in directly, so the includes between them
+# (and the logger, which only produces output in debug builds) go away.
+source = re.sub(r'^#include <%s/%s\.h>\n' % (name, name), '', source, flags=re.M)
+source = re.sub(r'^(// )?#define KSLogger_LocalLevel.*\n', '', source, flags=re.M)
+source = re.sub(r'^#include "kslogger\.h"\n', '', source, flags=re.M)
+source = source.replace('EXPAND_AND_QUOTE(PROJECT_VERSION)', '"%s"' % version)
+header = header.replace('#pragma once\n', '', 1)
+
+# Everything the implementation #defines is #undefined again afterwards so
+# that nothing leaks into the including file.
+defined = []
+for macro in re.findall(r'^\s*#define\s+(\w+)', source, flags=re.M):
+    if macro not in defined:
+        defined.append(macro)
+
+out = []
+out.append("""\
+// {name} single-header distribution, version {version}.
+// Generated from {header} and {source}. Do not edit.
+//
+// Include this file wherever {name}.h would be included. In exactly one
+// source file, define {upper}_IMPLEMENTATION before including it to also
+// compile the library there.
+//
+// Defining {upper}_STATIC instead makes every function static inline and
+// implies {upper}_IMPLEMENTATION, so each including file gets a private copy
+// that the compiler is free to inline.
+
+#ifndef {guard}
+#define {guard}
+
+#ifdef {upper}_STATIC
+    #ifndef {upper}_IMPLEMENTATION
+        #define {upper}_IMPLEMENTATION
+    #endif
+    #undef {upper}_PUBLIC
+    #define {upper}_PUBLIC static inline
+#elif !defined({upper}_PUBLIC)
+    #define {upper}_PUBLIC
+#endif
+
+""".format(name=name, version=version, upper=upper, guard=guard,
+           header=name + '.h', source=os.path.basename(source_path)))
+out.append(header.strip('\n') + '\n')
+out.append("""
+#ifdef {upper}_IMPLEMENTATION
+
+#define KSLOG_DEBUG(...)
+#define KSLOG_TRACE(...)
+""".format(upper=upper))
+out.append(source.strip('\n') + '\n')
+out.append('\n#undef KSLOG_DEBUG\n#undef KSLOG_TRACE\n')
+out.extend('#undef %s\n' % macro for macro in defined)
+out.append("""
+#endif // {upper}_IMPLEMENTATION
+
+#endif // {guard}
+""".format(upper=upper, guard=guard))
+
+with open(output_path, 'w') as f:
+    f.write(''.join(out))
+
+if depfile_path:
+    with open(depfile_path, 'w') as f:
+        f.write('%s: %s\n' % (output_path, ' '.join([header_path, source_path] + inlined_paths)))
@@ -0,0 +1,132 @@
+#!/usr/bin/env python3
+#
+# Generates a safeXX codec's parameters and lookup tables (codec_tables.h)
+# from its description (codec.json), which contains:
+#
+#   alphabet:              The encoding characters, in order of value.
+#   whitespace:            Characters that are ignored when decoding.
+#   substitutions:         Pairs of characters, where the first character of
+#                          each pair decodes the same as the second.
+#   bytes_per_group:       The number of bytes that are encoded as a group.
+#   bits_per_length_chunk: The number of value bits in each length chunk.
+#
+# Usage: build_tables.py <codec.json> <output>
+
+import json
+import sys
+
+spec_path, output_path = sys.argv[1:3]
+
+with open(spec_path) as f:
+    spec = json.load(f)
+
+alphabet = spec["alphabet"]
+whitespace = spec["whitespace"]
+substitutions = spec["substitutions"]
+bytes_per_group = spec["bytes_per_group"]
+bits_per_length_chunk = spec["bits_per_length_chunk"]
+radix = len(alphabet)
+
+def fail(message):
+    sys.exit("%s: %s" % (spec_path, message))
+
+if len(set(alphabet)) != radix:
+    fail("alphabet contains duplicate characters")
+if radix > 0x80:
+    fail("alphabet is too big (chunk values must stay below 0x80)")
+if len(substitutions) % 2 != 0:
+    fail("substitutions must be pairs of characters")
+
+# The fewest chunks that can represent every value of byte_count bytes.
+def get_chunk_count(byte_count):
+    chunk_count = 0
+    while radix ** chunk_count < 256 ** byte_count:
+        chunk_count += 1
+    return chunk_count
+
+# The most bytes that chunk_count chunks can hold.
+def get_byte_count(chunk_count):
+    byte_count = 0
+    while 256 ** (byte_count + 1) <= radix ** chunk_count:
+        byte_count += 1
+    return byte_count
+
+chunks_per_group = get_chunk_count(bytes_per_group)
+byte_to_chunk_count = [get_chunk_count(i) for i in range(bytes_per_group + 1)]
+chunk_to_byte_count = [0] + [get_byte_count(i) for i in range(1, chunks_per_group + 1)]
+
+char_to_chunk = ["ERRR"] * 256
+for chunk, ch in enumerate(alphabet):
+    char_to_chunk[ord(ch)] = "0x%02x" % chunk
+for ch in whitespace:
+    if char_to_chunk[ord(ch)] != "ERRR":
+        fail("whitespace character %r is already in use" % ch)
+    char_to_chunk[ord(ch)] = "WHSP"
+for i in range(0, len(substitutions), 2):
+    from_char, to_char = substitutions[i], substitutions[i + 1]
+    if char_to_chunk[ord(from_char)] != "ERRR" or to_char not in alphabet:
+        fail("invalid substitution %r -> %r" % (from_char, to_char))
+    char_to_chunk[ord(from_char)] = "0x%02x" % alphabet.index(to_char)
+
+# A group must fit in the accumulator both as bytes and as chunks.
+group_bits = max(bytes_per_group * 8, (radix ** chunks_per_group - 1).bit_length())
+if group_bits > 128:
+    fail("groups are too big")
+
+out = []
+out.append("// Generated from codec.json by tools/build_tables.py. Do not edit.\n\n")
+if group_bits <= 64:
+    out.append("typedef uint64_t codec_accumulator;\n")
+else:
+    chunks_per_word = 0
+    while radix ** (chunks_per_word + 1) < 2 ** 64:
+        chunks_per_word += 1
+    out.append("""\
+// A group is %d bits wide. %d chunks (%d^%d) fit in a uint64_t.
+#ifndef ANSI_EXTENSION
+    #ifdef __GNUC__
+        #define ANSI_EXTENSION __extension__
+    #else
+        #define ANSI_EXTENSION
+    #endif
+#endif
+ANSI_EXTENSION typedef unsigned __int128 codec_accumulator;
+#define CODEC_CHUNKS_PER_WORD    %d
+#define CODEC_WORD_CHUNK_DIVISOR %du
+""" % (bytes_per_group * 8, chunks_per_word, radix, chunks_per_word,
+       chunks_per_word, radix ** chunks_per_word))
+
+out.append("""
+static const int g_bytes_per_group       = %d;
+static const int g_chunks_per_group      = %d;
+static const int g_chunk_radix           = %d;
+static const int g_bits_per_length_chunk = %d;
+
+static const uint8_t g_encode_char_to_chunk[] =
+{
+#define ERRR CHUNK_CODE_ERROR
+#define WHSP CHUNK_CODE_WHITESPACE
+""" % (bytes_per_group, chunks_per_group, radix, bits_per_length_chunk))
+out.append("".join("    %s,\n" % ",".join(char_to_chunk[i:i + 8]) for i in range(0, 256, 8)))
+out.append("""\
+#undef WHSP
+#undef ERRR
+};
+
+static const uint8_t g_chunk_to_encode_char[] =
+{
+""")
+out.append("".join("    %s,\n" % ", ".join("'%s'" % ch.replace("\\", "\\\\").replace("'", "\\'")
+                                             for ch in alphabet[i:i + 8])
+                   for i in range(0, radix, 8)))
+out.append("""\
+};
+
+static const int g_chunk_to_byte_count[]   = { %s };
+
+static const int g_byte_to_chunk_count[]   = { %s };
+""" % (", ".join(str(v) for v in chunk_to_byte_count),
+       ", ".join(str(v) for v in byte_to_chunk_count)))
+
+with open(output_path, "w") as f:
+    f.write("".join(out))
@@ -0,0 +1,1842 @@
+#pragma once
+
+#ifndef SAFE16_AMALGAMATED_H
+    #include <safe16/safe16.h>
+#endif
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstring>
+#include <iterator>
+#include <memory>
+#include <streambuf>
+#include <string>
+#include <utility>
+#include <vector>
+
+#if __cplusplus >= 201703L
+    #include <string_view>
+    #define SAFE16_HAS_CPP17 1
+#endif
+
+#if __cplusplus >= 202002L && defined(__has_include)
+    #if __has_include(<span>)
+        #include <span>
+        #define SAFE16_HAS_SPAN 1
+    #endif
+#endif
+
+#if __cplusplus >= 202002L && defined(__has_include)
+    #if __has_include(<ranges>)
+        #include <ranges>
+        #if defined(__cpp_lib_ranges)
+            #define SAFE16_HAS_RANGES 1
+        #endif
+    #endif
+#endif
+
+#if __cplusplus >= 202002L && defined(__has_include)
+    #if __has_include(<coroutine>) && defined(SAFE16_HAS_SPAN)
+        #include <coroutine>
+        #if defined(__cpp_impl_coroutine)
+            #define SAFE16_HAS_COROUTINES 1
+        #endif
+    #endif
+#endif
+
+#if __cplusplus >= 201703L && defined(__has_include)
+    #if __has_include(<memory_resource>)
+        #include <memory_resource>
+        #define SAFE16_HAS_PMR 1
+    #endif
+#endif
+
+namespace safe16
+{
+
+/**
+ * Orders safe16 sequences by the binary data they represent, without decoding
+ * them. Usable as the comparator for std::sort, std::map and friends.
+ *
+ * Works with any type that has data() and size(), such as std::string,
+ * std::string_view, and std::vector<uint8_t>.
+ *
+ * All sequences being compared must be valid safe16. Invalid sequences
+ * compare as equal to everything, which breaks the strict weak ordering.
+ */
+struct encoded_less
+{
+    template <typename A, typename B>
+    bool operator()(const A& a, const B& b) const
+    {
+        int result = 0;
+        safe16_compare_encoded(reinterpret_cast<const uint8_t*>(a.data()),
+                               static_cast<int64_t>(a.size()),
+                               reinterpret_cast<const uint8_t*>(b.data()),
+                               static_cast<int64_t>(b.size()),
+                               &result);
+        return result < 0;
+    }
+};
+
+namespace detail
+{
+// Called from C code, so nothing may be thrown through it.
+template <typename CONTAINER>
+void* resize_container(void* container, int64_t size)
+{
+    CONTAINER& c = *static_cast<CONTAINER*>(container);
+#if defined(__cpp_exceptions) || defined(__EXCEPTIONS)
+    try
+    {
+        c.resize(static_cast<size_t>(size));
+    }
+    catch(...)
+    {
+        return nullptr;
+    }
+#else
+    c.resize(static_cast<size_t>(size));
+#endif
+    return c.data();
+}
+
+template <typename CONTAINER, typename FUNCTION>
+int64_t alloc_into(FUNCTION function, const uint8_t* src, int64_t src_length, CONTAINER& dst)
+{
+    dst.clear();
+    uint8_t* unused = nullptr;
+    const int64_t result = function(src, src_length, resize_container<CONTAINER>, &dst, &unused);
+    if(result < 0)
+    {
+        dst.clear();
+    }
+    return result;
+}
+} // namespace detail
+
+#ifdef SAFE16_HAS_CPP17
+
+/**
+ * Carries a failure status into a result, like std::unexpected does for
+ * std::expected.
+ */
+struct unexpected
+{
+    safe16_status status;
+};
+
+/**
+ * Holds either a value or the status explaining why there isn't one.
+ * This is the subset of std::expected<T, safe16_status> that the wrappers
+ * below need, usable from C++17 onwards.
+ */
+template <typename T>
+class result
+{
+public:
+    result(T value) : m_value(std::move(value)), m_status(SAFE16_STATUS_OK) {}
+    result(unexpected error) : m_value(), m_status(error.status) {}
+
+    bool has_value() const noexcept { return m_status == SAFE16_STATUS_OK; }
+    explicit operator bool() const noexcept { return has_value(); }
+
+    // The value accessors must only be used when has_value() is true.
+    const T& value() const& noexcept { return m_value; }
+    T& value() & noexcept { return m_value; }
+    T&& value() && noexcept { return std::move(m_value); }
+    const T& operator*() const& noexcept { return m_value; }
+    T& operator*() & noexcept { return m_value; }
+    const T* operator->() const noexcept { return &m_value; }
+    T* operator->() noexcept { return &m_value; }
+
+    template <typename U>
+    T value_or(U&& fallback) const&
+    {
+        return has_value() ? m_value : static_cast<T>(std::forward<U>(fallback));
+    }
+
+    safe16_status error() const noexcept { return m_status; }
+
+private:
+    T m_value;
+    safe16_status m_status;
+};
+
+namespace detail
+{
+inline const uint8_t* as_bytes(const char* data) noexcept
+{
+    return reinterpret_cast<const uint8_t*>(data);
+}
+
+inline result<size_t> to_result(int64_t length) noexcept
+{
+    if(length < 0)
+    {
+        return unexpected{static_cast<safe16_status>(length)};
+    }
+    return static_cast<size_t>(length);
+}
+
+template <typename CONTAINER, typename FUNCTION>
+result<CONTAINER> alloc_result(FUNCTION function, const uint8_t* src, size_t src_length)
+{
+    CONTAINER dst;
+    const int64_t length = alloc_into(function, src, static_cast<int64_t>(src_length), dst);
+    if(length < 0)
+    {
+        return unexpected{static_cast<safe16_status>(length)};
+    }
+    return dst;
+}
+} // namespace detail
+
+/**
+ * Encodes binary data into a caller-supplied buffer, which must be at least
+ * safe16_get_encoded_length(src.size(), false) bytes long.
+ *
+ * @return the number of characters written, or the failure status.
+ */
+inline result<size_t> encode(std::string_view src, char* dst, size_t dst_length) noexcept
+{
+    return detail::to_result(safe16_encode(detail::as_bytes(src.data()),
+                                           static_cast<int64_t>(src.size()),
+                                           reinterpret_cast<uint8_t*>(dst),
+                                           static_cast<int64_t>(dst_length)));
+}
+
+/**
+ * Same as encode(), but with a length field.
+ */
+inline result<size_t> encode_with_length(std::string_view src, char* dst, size_t dst_length) noexcept
+{
+    return detail::to_result(safe16l_encode(detail::as_bytes(src.data()),
+                                            static_cast<int64_t>(src.size()),
+                                            reinterpret_cast<uint8_t*>(dst),
+                                            static_cast<int64_t>(dst_length)));
+}
+
+/**
+ * Decodes a safe16 sequence into a caller-supplied buffer.
+ *
+ * @return the number of bytes written, or the failure status.
+ */
+inline result<size_t> decode(std::string_view src, uint8_t* dst, size_t dst_length) noexcept
+{
+    return detail::to_result(safe16_decode(detail::as_bytes(src.data()),
+                                           static_cast<int64_t>(src.size()),
+                                           dst,
+                                           static_cast<int64_t>(dst_length)));
+}
+
+/**
+ * Same as decode(), but for a safe16L (safe16 + length) sequence.
+ */
+inline result<size_t> decode_with_length(std::string_view src, uint8_t* dst, size_t dst_length) noexcept
+{
+    return detail::to_result(safe16l_decode(detail::as_bytes(src.data()),
+                                            static_cast<int64_t>(src.size()),
+                                            dst,
+                                            static_cast<int64_t>(dst_length)));
+}
+
+/**
+ * Encodes binary data into a new container (std::string by default), which
+ * is sized exactly once.
+ */
+template <typename CONTAINER = std::string>
+result<CONTAINER> encode(std::string_view src)
+{
+    return detail::alloc_result<CONTAINER>(safe16_encode_alloc, detail::as_bytes(src.data()), src.size());
+}
+
+/**
+ * Same as encode(), but with a length field.
+ */
+template <typename CONTAINER = std::string>
+result<CONTAINER> encode_with_length(std::string_view src)
+{
+    return detail::alloc_result<CONTAINER>(safe16l_encode_alloc, detail::as_bytes(src.data()), src.size());
+}
+
+/**
+ * Decodes a safe16 sequence into a new container (std::string by default).
+ * The source is validated first, and the container is sized exactly once.
+ */
+template <typename CONTAINER = std::string>
+result<CONTAINER> decode(std::string_view src)
+{
+    return detail::alloc_result<CONTAINER>(safe16_decode_alloc, detail::as_bytes(src.data()), src.size());
+}
+
+/**
+ * Same as decode(), but for a safe16L (safe16 + length) sequence.
+ */
+template <typename CONTAINER = std::string>
+result<CONTAINER> decode_with_length(std::string_view src)
+{
+    return detail::alloc_result<CONTAINER>(safe16l_decode_alloc, detail::as_bytes(src.data()), src.size());
+}
+
+/**
+ * Appends binary data to a JSON document (std::string or similar) as an
+ * encoded string value, including the quotes. The document is resized once,
+ * and the data is encoded directly into it.
+ *
+ * @return the number of characters appended, or the failure status (in which
+ *         case the document is left unchanged).
+ */
+template <typename STRING>
+result<size_t> append_json_string(STRING& json, std::string_view src)
+{
+    const int64_t length = safe16_get_json_string_length(static_cast<int64_t>(src.size()));
+    if(length < 0)
+    {
+        return unexpected{static_cast<safe16_status>(length)};
+    }
+    const size_t offset = json.size();
+    json.resize(offset + static_cast<size_t>(length));
+    const int64_t used = safe16_encode_json_string(detail::as_bytes(src.data()),
+                                                   static_cast<int64_t>(src.size()),
+                                                   reinterpret_cast<uint8_t*>(&json[offset]),
+                                                   length);
+    if(used < 0)
+    {
+        json.resize(offset);
+    }
+    return detail::to_result(used);
+}
+
+#ifdef SAFE16_HAS_SPAN
+
+inline result<size_t> encode(std::span<const uint8_t> src, std::span<char> dst) noexcept
+{
+    return encode(std::string_view(reinterpret_cast<const char*>(src.data()), src.size()), dst.data(), dst.size());
+}
+
+inline result<size_t> encode_with_length(std::span<const uint8_t> src, std::span<char> dst) noexcept
+{
+    return encode_with_length(std::string_view(reinterpret_cast<const char*>(src.data()), src.size()), dst.data(), dst.size());
+}
+
+inline result<size_t> decode(std::string_view src, std::span<uint8_t> dst) noexcept
+{
+    return decode(src, dst.data(), dst.size());
+}
+
+inline result<size_t> decode_with_length(std::string_view src, std::span<uint8_t> dst) noexcept
+{
+    return decode_with_length(src, dst.data(), dst.size());
+}
+
+template <typename CONTAINER = std::string>
+result<CONTAINER> encode(std::span<const uint8_t> src)
+{
+    return detail::alloc_result<CONTAINER>(safe16_encode_alloc, src.data(), src.size());
+}
+
+template <typename CONTAINER = std::string>
+result<CONTAINER> encode_with_length(std::span<const uint8_t> src)
+{
+    return detail::alloc_result<CONTAINER>(safe16l_encode_alloc, src.data(), src.size());
+}
+
+#endif // SAFE16_HAS_SPAN
+
+
+// ---------------------------------------------------------------------------
+// Compile-time codec
+// ---------------------------------------------------------------------------
+//
+// An independent constexpr implementation of the codec, so that encoded
+// constants can be produced at compile time. It works one group at a time on
+// byte arrays (no wide accumulator), and produces the same output as the
+// library.
+
+namespace detail
+{
+// The codec definition, as found in src/codec.json.
+inline constexpr char g_ct_alphabet[] = "0123456789abcdef";
+inline constexpr int g_ct_radix = sizeof(g_ct_alphabet) - 1;
+inline constexpr int g_ct_bytes_per_group = 1;
+inline constexpr int g_ct_chunks_per_group = 2;
+inline constexpr int g_ct_bits_per_length_chunk = 3;
+inline constexpr int g_ct_chunk_to_byte_count[] = { 0, 0, 1 };
+inline constexpr int g_ct_byte_to_chunk_count[] = { 0, 2 };
+inline constexpr char g_ct_whitespace[] = "\t\n\r -";
+// Pairs of (accepted character, alphabet character) when decoding.
+inline constexpr char g_ct_substitutions[] = "AaBbCcDdEeFf";
+
+inline constexpr int g_ct_chunk_code_error = -1;
+inline constexpr int g_ct_chunk_code_whitespace = -2;
+
+constexpr int ct_find_chunk(const char ch)
+{
+    for(int i = 0; i < g_ct_radix; i++)
+    {
+        if(g_ct_alphabet[i] == ch)
+        {
+            return i;
+        }
+    }
+    for(size_t i = 0; i + 1 < sizeof(g_ct_substitutions); i += 2)
+    {
+        if(g_ct_substitutions[i] == ch)
+        {
+            return ct_find_chunk(g_ct_substitutions[i + 1]);
+        }
+    }
+    for(size_t i = 0; i + 1 < sizeof(g_ct_whitespace); i++)
+    {
+        if(g_ct_whitespace[i] == ch)
+        {
+            return g_ct_chunk_code_whitespace;
+        }
+    }
+    return g_ct_chunk_code_error;
+}
+
+constexpr std::array<int8_t, 256> ct_make_chunk_table()
+{
+    std::array<int8_t, 256> table = {};
+    for(int i = 0; i < 256; i++)
+    {
+        table[i] = static_cast<int8_t>(ct_find_chunk(static_cast<char>(i)));
+    }
+    return table;
+}
+
+inline constexpr std::array<int8_t, 256> g_ct_char_to_chunk = ct_make_chunk_table();
+
+constexpr int ct_char_to_chunk(const char ch)
+{
+    return g_ct_char_to_chunk[static_cast<uint8_t>(ch)];
+}
+
+// Encodes the group as a big-endian number in base radix, by repeated long
+// division of the group's bytes.
+constexpr void ct_encode_group(const uint8_t* const src, const int byte_count, char* const dst)
+{
+    uint8_t work[g_ct_bytes_per_group] = {};
+    for(int i = 0; i < byte_count; i++)
+    {
+        work[i] = src[i];
+    }
+    for(int i = g_ct_byte_to_chunk_count[byte_count] - 1; i >= 0; i--)
+    {
+        int remainder = 0;
+        for(int j = 0; j < byte_count; j++)
+        {
+            const int value = remainder * 256 + work[j];
+            work[j] = static_cast<uint8_t>(value / g_ct_radix);
+            remainder = value % g_ct_radix;
+        }
+        dst[i] = g_ct_alphabet[remainder];
+    }
+}
+
+// Decodes the group by multiply-accumulating each chunk into the group's
+// bytes. Anything that overflows the group is dropped, as in the library.
+constexpr void ct_decode_group(const int* const chunks, const int chunk_count, uint8_t* const dst)
+{
+    const int byte_count = g_ct_chunk_to_byte_count[chunk_count];
+    uint8_t work[g_ct_bytes_per_group] = {};
+    for(int i = 0; i < chunk_count; i++)
+    {
+        int carry = chunks[i];
+        for(int j = byte_count - 1; j >= 0; j--)
+        {
+            const int value = work[j] * g_ct_radix + carry;
+            work[j] = static_cast<uint8_t>(value & 0xff);
+            carry = value >> 8;
+        }
+    }
+    for(int i = 0; i < byte_count; i++)
+    {
+        dst[i] = work[i];
+    }
+}
+
+constexpr size_t ct_get_length_chunk_count(size_t length)
+{
+    size_t chunk_count = 1;
+    for(length >>= g_ct_bits_per_length_chunk; length; length >>= g_ct_bits_per_length_chunk)
+    {
+        chunk_count++;
+    }
+    return chunk_count;
+}
+
+// Not constexpr, so that an invalid literal fails to compile.
+inline void literal_is_not_valid_safe16() {}
+} // namespace detail
+
+namespace compile_time
+{
+constexpr size_t get_encoded_length(const size_t decoded_length, const bool include_length_field = false)
+{
+    return decoded_length / detail::g_ct_bytes_per_group * detail::g_ct_chunks_per_group +
+           detail::g_ct_byte_to_chunk_count[decoded_length % detail::g_ct_bytes_per_group] +
+           (include_length_field ? detail::ct_get_length_chunk_count(decoded_length) : 0);
+}
+
+/**
+ * Gets the decoded length of an encoded sequence that contains no whitespace
+ * and no length field (otherwise, this is an upper bound).
+ */
+constexpr size_t get_decoded_length(const size_t encoded_length)
+{
+    return encoded_length / detail::g_ct_chunks_per_group * detail::g_ct_bytes_per_group +
+           detail::g_ct_chunk_to_byte_count[encoded_length % detail::g_ct_chunks_per_group];
+}
+
+/**
+ * Encodes binary data. dst must have room for get_encoded_length(src_length).
+ *
+ * @return the number of characters written.
+ */
+constexpr size_t encode(const uint8_t* const src, const size_t src_length, char* const dst)
+{
+    size_t src_offset = 0;
+    size_t dst_offset = 0;
+    while(src_offset < src_length)
+    {
+        const size_t remaining = src_length - src_offset;
+        const int byte_count = remaining < detail::g_ct_bytes_per_group ?
+                               static_cast<int>(remaining) : detail::g_ct_bytes_per_group;
+        detail::ct_encode_group(src + src_offset, byte_count, dst + dst_offset);
+        src_offset += byte_count;
+        dst_offset += detail::g_ct_byte_to_chunk_count[byte_count];
+    }
+    return dst_offset;
+}
+
+/**
+ * Same as encode(), but with a length field. dst must have room for
+ * get_encoded_length(src_length, true).
+ */
+constexpr size_t encode_with_length(const uint8_t* const src, const size_t src_length, char* const dst)
+{
+    const int continuation_bit = 1 << detail::g_ct_bits_per_length_chunk;
+    const size_t length_chunk_count = detail::ct_get_length_chunk_count(src_length);
+    for(size_t i = 0; i < length_chunk_count; i++)
+    {
+        const size_t shift_amount = detail::g_ct_bits_per_length_chunk * (length_chunk_count - 1 - i);
+        const int chunk = static_cast<int>((src_length >> shift_amount) & (continuation_bit - 1));
+        dst[i] = detail::g_ct_alphabet[chunk + (i + 1 < length_chunk_count ? continuation_bit : 0)];
+    }
+    return length_chunk_count + encode(src, src_length, dst + length_chunk_count);
+}
+
+/**
+ * Decodes a safe16 sequence, skipping whitespace.
+ *
+ * @return the number of bytes written, or a safe16_status error code.
+ */
+constexpr int64_t decode(const char* const src, const size_t src_length, uint8_t* const dst, const size_t dst_length)
+{
+    int chunks[detail::g_ct_chunks_per_group] = {};
+    int chunk_count = 0;
+    size_t dst_offset = 0;
+    for(size_t i = 0; i <= src_length; i++)
+    {
+        if(i < src_length)
+        {
+            const int chunk = detail::ct_char_to_chunk(src[i]);
+            if(chunk == detail::g_ct_chunk_code_whitespace)
+            {
+                continue;
+            }
+            if(chunk == detail::g_ct_chunk_code_error)
+            {
+                return SAFE16_ERROR_INVALID_SOURCE_DATA;
+            }
+            chunks[chunk_count++] = chunk;
+            if(chunk_count < detail::g_ct_chunks_per_group)
+            {
+                continue;
+            }
+        }
+        const size_t byte_count = detail::g_ct_chunk_to_byte_count[chunk_count];
+        if(dst_offset + byte_count > dst_length)
+        {
+            return SAFE16_ERROR_NOT_ENOUGH_ROOM;
+        }
+        detail::ct_decode_group(chunks, chunk_count, dst + dst_offset);
+        dst_offset += byte_count;
+        chunk_count = 0;
+    }
+    return static_cast<int64_t>(dst_offset);
+}
+
+/**
+ * Same as decode(), but for a safe16L (safe16 + length) sequence. The
+ * decoded data must be exactly as long as the length field says.
+ */
+constexpr int64_t decode_with_length(const char* const src, const size_t src_length, uint8_t* const dst, const size_t dst_length)
+{
+    const int continuation_bit = 1 << detail::g_ct_bits_per_length_chunk;
+    uint64_t length = 0;
+    size_t offset = 0;
+    for(bool is_continued = true; is_continued; offset++)
+    {
+        if(offset >= src_length)
+        {
+            return SAFE16_ERROR_UNTERMINATED_LENGTH_FIELD;
+        }
+        const int chunk = detail::ct_char_to_chunk(src[offset]);
+        if(chunk == detail::g_ct_chunk_code_whitespace)
+        {
+            continue;
+        }
+        if(chunk == detail::g_ct_chunk_code_error || chunk >= continuation_bit * 2 ||
+           length > (static_cast<uint64_t>(INT64_MAX) >> detail::g_ct_bits_per_length_chunk))
+        {
+            return SAFE16_ERROR_INVALID_SOURCE_DATA;
+        }
+        length = (length << detail::g_ct_bits_per_length_chunk) | (chunk & (continuation_bit - 1));
+        is_continued = (chunk & continuation_bit) != 0;
+    }
+    const int64_t result = decode(src + offset, src_length - offset, dst, dst_length);
+    if(result >= 0 && static_cast<uint64_t>(result) < length)
+    {
+        return SAFE16_ERROR_TRUNCATED_DATA;
+    }
+    if(result >= 0 && static_cast<uint64_t>(result) > length)
+    {
+        return SAFE16_ERROR_TOO_MUCH_DATA;
+    }
+    return result;
+}
+} // namespace compile_time
+
+/**
+ * A fixed-size encoded string, produced by encode_literal().
+ */
+template <size_t N>
+struct encoded_string
+{
+    char chars[N + 1] = {};
+
+    static constexpr size_t size() { return N; }
+    constexpr const char* data() const { return chars; }
+    constexpr const char* c_str() const { return chars; }
+    constexpr char operator[](const size_t index) const { return chars[index]; }
+    constexpr operator std::string_view() const { return std::string_view(chars, N); }
+};
+
+/**
+ * Encodes bytes at compile time:
+ *
+ *     constexpr auto key = safe16::encode_literal<0xde, 0xad, 0xbe, 0xef>();
+ */
+template <uint8_t... BYTES>
+constexpr auto encode_literal()
+{
+    constexpr uint8_t bytes[sizeof...(BYTES) + 1] = {BYTES..., 0};
+    encoded_string<compile_time::get_encoded_length(sizeof...(BYTES))> result;
+    compile_time::encode(bytes, sizeof...(BYTES), result.chars);
+    return result;
+}
+
+/**
+ * Same as encode_literal(), but with a length field.
+ */
+template <uint8_t... BYTES>
+constexpr auto encode_literal_with_length()
+{
+    constexpr uint8_t bytes[sizeof...(BYTES) + 1] = {BYTES..., 0};
+    encoded_string<compile_time::get_encoded_length(sizeof...(BYTES), true)> result;
+    compile_time::encode_with_length(bytes, sizeof...(BYTES), result.chars);
+    return result;
+}
+
+/**
+ * Encodes the characters of a string literal (without its terminator) at
+ * compile time.
+ */
+template <size_t N>
+constexpr auto encode_literal(const char (&text)[N])
+{
+    uint8_t bytes[N] = {};
+    for(size_t i = 0; i < N; i++)
+    {
+        bytes[i] = static_cast<uint8_t>(text[i]);
+    }
+    encoded_string<compile_time::get_encoded_length(N - 1)> result;
+    compile_time::encode(bytes, N - 1, result.chars);
+    return result;
+}
+
+/**
+ * Decodes a safe16 string literal (which must not contain whitespace) at
+ * compile time. An invalid literal is a compile error when used in a
+ * constant expression.
+ */
+template <size_t N>
+constexpr auto decode_literal(const char (&encoded)[N])
+{
+    std::array<uint8_t, compile_time::get_decoded_length(N - 1)> result = {};
+    const int64_t length = compile_time::decode(encoded, N - 1, result.data(), result.size());
+    if(length != static_cast<int64_t>(result.size()))
+    {
+        detail::literal_is_not_valid_safe16();
+    }
+    return result;
+}
+
+#if defined(__cpp_nontype_template_args) && __cpp_nontype_template_args >= 201911L
+namespace detail
+{
+template <size_t N>
+struct literal_chars
+{
+    char chars[N] = {};
+
+    constexpr literal_chars(const char (&text)[N])
+    {
+        for(size_t i = 0; i < N; i++)
+        {
+            chars[i] = text[i];
+        }
+    }
+};
+} // namespace detail
+
+inline namespace literals
+{
+/**
+ * Decodes a safe16 string literal at compile time:
+ *
+ *     using namespace safe16::literals;
+ *     constexpr auto bytes = "391282e18139d98b394c639d048c"_safe16;
+ */
+template <detail::literal_chars TEXT>
+constexpr auto operator""_safe16()
+{
+    return decode_literal(TEXT.chars);
+}
+} // namespace literals
+#endif
+
+
+
+// ---------------------------------------------------------------------------
+// Stream buffers
+// ---------------------------------------------------------------------------
+
+/**
+ * An output stream buffer that encodes everything written to it and passes
+ * the result to another stream buffer:
+ *
+ *     safe16::encoding_streambuf encoder(std::cout.rdbuf(), {76, 2, false});
+ *     std::ostream out(&encoder);
+ *     out << my_data;
+ *
+ * Data is encoded a block at a time. Large writes are encoded straight from
+ * the caller's memory. The output can be laid out in lines with indentation,
+ * as done by safe16_encode_with_layout().
+ *
+ * The final partial group is only written by finish() (or the destructor),
+ * so the destination must outlive this object.
+ */
+class encoding_streambuf : public std::streambuf
+{
+public:
+    explicit encoding_streambuf(std::streambuf* const destination,
+                                const safe16_layout& layout = {0, 0, false},
+                                const size_t block_size = 65536)
+    : m_destination(destination)
+    , m_bytes(std::max(block_size / detail::g_ct_bytes_per_group, static_cast<size_t>(1)) * detail::g_ct_bytes_per_group)
+    , m_encoded(get_encoded_buffer_length(m_bytes.size(), layout))
+    {
+        m_is_ok = safe16_layout_encoder_init(&m_encoder, &layout) == SAFE16_STATUS_OK;
+        reset_put_area(0);
+    }
+
+    ~encoding_streambuf() override
+    {
+        finish();
+    }
+
+    encoding_streambuf(const encoding_streambuf&) = delete;
+    encoding_streambuf& operator=(const encoding_streambuf&) = delete;
+
+    /**
+     * Encodes and writes everything that's left, including the final partial
+     * group. Nothing more may be written afterwards.
+     *
+     * @return false if the destination could not be written to.
+     */
+    bool finish()
+    {
+        if(m_is_finished)
+        {
+            return m_is_ok;
+        }
+        m_is_ok = m_is_ok && flush(true);
+        m_is_finished = true;
+        setp(nullptr, nullptr);
+        return m_is_ok;
+    }
+
+protected:
+    int_type overflow(const int_type ch) override
+    {
+        if(m_is_finished || !m_is_ok || !flush(false))
+        {
+            return traits_type::eof();
+        }
+        if(!traits_type::eq_int_type(ch, traits_type::eof()))
+        {
+            *pptr() = traits_type::to_char_type(ch);
+            pbump(1);
+        }
+        return traits_type::not_eof(ch);
+    }
+
+    std::streamsize xsputn(const char* const data, const std::streamsize length) override
+    {
+        if(m_is_finished || !m_is_ok)
+        {
+            return 0;
+        }
+        const std::streamsize block_size = static_cast<std::streamsize>(m_bytes.size());
+        std::streamsize offset = 0;
+        while(offset < length)
+        {
+            if(pptr() == pbase() && length - offset >= block_size)
+            {
+                if(!encode_and_write(reinterpret_cast<const uint8_t*>(data + offset), block_size, false))
+                {
+                    return offset;
+                }
+                offset += block_size;
+                continue;
+            }
+            const std::streamsize count = std::min(static_cast<std::streamsize>(epptr() - pptr()), length - offset);
+            std::memcpy(pptr(), data + offset, static_cast<size_t>(count));
+            pbump(static_cast<int>(count));
+            offset += count;
+            if(pptr() == epptr() && !flush(false))
+            {
+                return offset;
+            }
+        }
+        return offset;
+    }
+
+    // Only whole groups can be written before the end of the data.
+    int sync() override
+    {
+        if(m_is_finished)
+        {
+            return m_is_ok ? 0 : -1;
+        }
+        return flush(false) && m_destination->pubsync() == 0 ? 0 : -1;
+    }
+
+private:
+    // Room for a block laid out, plus the line break that the previous block
+    // may have left pending.
+    static size_t get_encoded_buffer_length(const size_t block_size, const safe16_layout& layout)
+    {
+        const int64_t length = safe16_get_encoded_length_with_layout(static_cast<int64_t>(block_size), false, &layout);
+        return length < 0 ? 0 : static_cast<size_t>(length + 2 + layout.indent_length);
+    }
+
+    void reset_put_area(const size_t used)
+    {
+        char* const begin = reinterpret_cast<char*>(m_bytes.data());
+        setp(begin, begin + m_bytes.size());
+        pbump(static_cast<int>(used));
+    }
+
+    bool flush(const bool is_end)
+    {
+        const uint8_t* const begin = reinterpret_cast<const uint8_t*>(pbase());
+        const int64_t length = pptr() - pbase();
+        const int64_t used = encode_and_write(begin, length, is_end);
+        if(used < 0)
+        {
+            return false;
+        }
+        std::memmove(m_bytes.data(), begin + used, static_cast<size_t>(length - used));
+        reset_put_area(static_cast<size_t>(length - used));
+        return true;
+    }
+
+    // Returns the number of bytes encoded (whole groups unless is_end), or -1
+    // if the destination couldn't be written to. Line breaks and indentation
+    // are written by the encoder as it goes.
+    int64_t encode_and_write(const uint8_t* const src_begin, const int64_t src_length, const bool is_end)
+    {
+        const uint8_t* src = src_begin;
+        uint8_t* dst = m_encoded.data();
+        const safe16_status status = safe16_layout_encoder_feed(&m_encoder,
+                                                                &src,
+                                                                src_length,
+                                                                &dst,
+                                                                static_cast<int64_t>(m_encoded.size()),
+                                                                is_end);
+        const std::streamsize size = static_cast<std::streamsize>(dst - m_encoded.data());
+        if((status != SAFE16_STATUS_OK && status != SAFE16_STATUS_PARTIALLY_COMPLETE) ||
+           m_destination->sputn(reinterpret_cast<const char*>(m_encoded.data()), size) != size)
+        {
+            m_is_ok = false;
+            return -1;
+        }
+        return src - src_begin;
+    }
+
+    std::streambuf* m_destination;
+    safe16_layout_encoder m_encoder;
+    std::vector<uint8_t> m_bytes;
+    std::vector<uint8_t> m_encoded;
+    bool m_is_finished = false;
+    bool m_is_ok = true;
+};
+
+/**
+ * An input stream buffer that decodes the safe16 data read from another
+ * stream buffer, a block at a time. Whitespace is skipped.
+ *
+ * Invalid data ends the stream, after which status() reports the error.
+ */
+class decoding_streambuf : public std::streambuf
+{
+public:
+    explicit decoding_streambuf(std::streambuf* const source, const size_t block_size = 65536)
+    : m_source(source)
+    , m_encoded(std::max(block_size, static_cast<size_t>(detail::g_ct_chunks_per_group * 2)))
+    // The library only completes a group in the middle of a stream when
+    // there's room left over.
+    , m_decoded(static_cast<size_t>(safe16_get_decoded_length(static_cast<int64_t>(m_encoded.size()))) +
+                detail::g_ct_bytes_per_group + 1)
+    {
+        setg(nullptr, nullptr, nullptr);
+    }
+
+    decoding_streambuf(const decoding_streambuf&) = delete;
+    decoding_streambuf& operator=(const decoding_streambuf&) = delete;
+
+    safe16_status status() const { return m_status; }
+
+protected:
+    int_type underflow() override
+    {
+        while(!m_is_finished)
+        {
+            if(!m_is_source_at_end)
+            {
+                const std::streamsize count = m_source->sgetn(reinterpret_cast<char*>(m_encoded.data()) + m_encoded_length,
+                                                              static_cast<std::streamsize>(m_encoded.size() - m_encoded_length));
+                m_is_source_at_end = count <= 0;
+                m_encoded_length += count > 0 ? static_cast<size_t>(count) : 0;
+            }
+
+            const uint8_t* src = m_encoded.data();
+            uint8_t* dst = m_decoded.data();
+            const safe16_status status = safe16_decode_feed(&src,
+                                                            static_cast<int64_t>(m_encoded_length),
+                                                            &dst,
+                                                            static_cast<int64_t>(m_decoded.size()),
+                                                            m_is_source_at_end ? SAFE16_SRC_IS_AT_END_OF_STREAM : SAFE16_STREAM_STATE_NONE);
+            if(status != SAFE16_STATUS_OK && status != SAFE16_STATUS_PARTIALLY_COMPLETE)
+            {
+                m_status = status;
+                m_is_finished = true;
+            }
+            else if(m_is_source_at_end)
+            {
+                m_is_finished = true;
+            }
+            keep_unused(src);
+
+            if(dst > m_decoded.data())
+            {
+                char* const begin = reinterpret_cast<char*>(m_decoded.data());
+                setg(begin, begin, reinterpret_cast<char*>(dst));
+                return traits_type::to_int_type(*gptr());
+            }
+        }
+        return traits_type::eof();
+    }
+
+private:
+    // Moves the characters of the unfinished group to the front of the
+    // buffer, dropping whitespace so that they always fit.
+    void keep_unused(const uint8_t* const src)
+    {
+        const uint8_t* const end = m_encoded.data() + m_encoded_length;
+        size_t length = 0;
+        for(const uint8_t* ch = src; ch < end; ch++)
+        {
+            if(detail::ct_char_to_chunk(static_cast<char>(*ch)) != detail::g_ct_chunk_code_whitespace)
+            {
+                m_encoded[length++] = *ch;
+            }
+        }
+        m_encoded_length = length;
+    }
+
+    std::streambuf* m_source;
+    std::vector<uint8_t> m_encoded;
+    std::vector<uint8_t> m_decoded;
+    size_t m_encoded_length = 0;
+    bool m_is_source_at_end = false;
+    bool m_is_finished = false;
+    safe16_status m_status = SAFE16_STATUS_OK;
+};
+
+
+// ---------------------------------------------------------------------------
+// Range adaptors
+// ---------------------------------------------------------------------------
+
+#ifdef SAFE16_HAS_RANGES
+
+namespace detail
+{
+// When the underlying range is contiguous, this many groups at a time are
+// passed to the library in one call. Otherwise, groups go through the
+// compile-time engine one at a time.
+inline constexpr int g_view_groups_per_block = 32;
+
+template <typename V>
+inline constexpr bool g_view_is_contiguous = std::ranges::contiguous_range<V> &&
+                                             std::ranges::sized_range<V> &&
+                                             sizeof(std::ranges::range_value_t<V>) == 1;
+
+#if defined(__cpp_lib_ranges) && __cpp_lib_ranges >= 202202L
+template <typename T>
+using range_adaptor_closure = std::ranges::range_adaptor_closure<T>;
+#else
+template <typename T>
+struct range_adaptor_closure
+{
+    template <std::ranges::viewable_range R>
+    friend auto operator|(R&& range, const T& self)
+    {
+        return self(std::forward<R>(range));
+    }
+};
+#endif
+} // namespace detail
+
+/**
+ * A view of the safe16 encoding of a range of bytes, produced a block at a
+ * time as it is iterated. Over a sized random-access range, the view is
+ * itself random-access.
+ */
+template <std::ranges::view V>
+    requires std::ranges::forward_range<V> &&
+             std::convertible_to<std::ranges::range_reference_t<V>, uint8_t>
+class encode_view : public std::ranges::view_interface<encode_view<V>>
+{
+    static constexpr bool is_contiguous = detail::g_view_is_contiguous<V>;
+    static constexpr bool is_random_access = std::ranges::random_access_range<V> && std::ranges::sized_range<V>;
+    static constexpr int groups_per_block = is_contiguous ? detail::g_view_groups_per_block : 1;
+    static constexpr int block_bytes = groups_per_block * detail::g_ct_bytes_per_group;
+    static constexpr int block_chars = groups_per_block * detail::g_ct_chunks_per_group;
+
+    V m_base = V();
+
+public:
+    class iterator
+    {
+        using base_iterator = std::ranges::iterator_t<V>;
+
+        encode_view* m_parent = nullptr;
+        base_iterator m_next = base_iterator();
+        std::ptrdiff_t m_index = 0;
+        int m_offset = 0;
+        int m_block_length = 0;
+        char m_block[block_chars] = {};
+
+        void load_block()
+        {
+            const auto end = std::ranges::end(m_parent->m_base);
+            m_offset = 0;
+            m_block_length = 0;
+            if(m_next == end)
+            {
+                return;
+            }
+            if constexpr(is_contiguous)
+            {
+                const auto remaining = end - m_next;
+                const int64_t byte_count = remaining < block_bytes ? remaining : block_bytes;
+                m_block_length = static_cast<int>(safe16_encode(reinterpret_cast<const uint8_t*>(std::to_address(m_next)),
+                                                                byte_count,
+                                                                reinterpret_cast<uint8_t*>(m_block),
+                                                                block_chars));
+                m_next += byte_count;
+            }
+            else
+            {
+                uint8_t group[detail::g_ct_bytes_per_group] = {};
+                int byte_count = 0;
+                for(; byte_count < detail::g_ct_bytes_per_group && m_next != end; ++m_next)
+                {
+                    group[byte_count++] = static_cast<uint8_t>(*m_next);
+                }
+                detail::ct_encode_group(group, byte_count, m_block);
+                m_block_length = detail::g_ct_byte_to_chunk_count[byte_count];
+            }
+        }
+
+        void seek(const std::ptrdiff_t index)
+        {
+            const std::ptrdiff_t block_index = index / block_chars;
+            m_index = index;
+            m_next = std::ranges::begin(m_parent->m_base) + block_index * block_bytes;
+            load_block();
+            m_offset = static_cast<int>(index - block_index * block_chars);
+        }
+
+    public:
+        using iterator_concept = std::conditional_t<is_random_access,
+                                                    std::random_access_iterator_tag,
+                                                    std::forward_iterator_tag>;
+        using iterator_category = std::input_iterator_tag;
+        using value_type = char;
+        using difference_type = std::ptrdiff_t;
+
+        iterator() = default;
+
+        iterator(encode_view* const parent, const std::ptrdiff_t index)
+        : m_parent(parent)
+        , m_next(std::ranges::begin(parent->m_base))
+        {
+            if constexpr(is_random_access)
+            {
+                seek(index);
+            }
+            else
+            {
+                load_block();
+            }
+        }
+
+        char operator*() const { return m_block[m_offset]; }
+
+        iterator& operator++()
+        {
+            m_index++;
+            if(++m_offset == m_block_length)
+            {
+                load_block();
+            }
+            return *this;
+        }
+
+        iterator operator++(int)
+        {
+            iterator previous = *this;
+            ++*this;
+            return previous;
+        }
+
+        friend bool operator==(const iterator& a, const iterator& b) { return a.m_index == b.m_index; }
+        friend bool operator==(const iterator& a, std::default_sentinel_t) { return a.m_offset >= a.m_block_length; }
+
+        iterator& operator--() requires is_random_access
+        {
+            if(m_offset > 0 && m_offset <= m_block_length)
+            {
+                m_index--;
+                m_offset--;
+            }
+            else
+            {
+                seek(m_index - 1);
+            }
+            return *this;
+        }
+
+        iterator operator--(int) requires is_random_access
+        {
+            iterator previous = *this;
+            --*this;
+            return previous;
+        }
+
+        iterator& operator+=(const difference_type distance) requires is_random_access
+        {
+            const std::ptrdiff_t offset = m_offset + distance;
+            if(distance >= 0 && offset < m_block_length)
+            {
+                m_index += distance;
+                m_offset = static_cast<int>(offset);
+            }
+            else
+            {
+                seek(m_index + distance);
+            }
+            return *this;
+        }
+
+        iterator& operator-=(const difference_type distance) requires is_random_access
+        {
+            return *this += -distance;
+        }
+
+        char operator[](const difference_type distance) const requires is_random_access
+        {
+            return *(*this + distance);
+        }
+
+        friend iterator operator+(iterator it, const difference_type distance) requires is_random_access
+        {
+            return it += distance;
+        }
+
+        friend iterator operator+(const difference_type distance, iterator it) requires is_random_access
+        {
+            return it += distance;
+        }
+
+        friend iterator operator-(iterator it, const difference_type distance) requires is_random_access
+        {
+            return it -= distance;
+        }
+
+        friend difference_type operator-(const iterator& a, const iterator& b) requires is_random_access
+        {
+            return a.m_index - b.m_index;
+        }
+
+        friend auto operator<=>(const iterator& a, const iterator& b) requires is_random_access
+        {
+            return a.m_index <=> b.m_index;
+        }
+    };
+
+    encode_view() requires std::default_initializable<V> = default;
+    explicit encode_view(V base) : m_base(std::move(base)) {}
+
+    V base() const& requires std::copy_constructible<V> { return m_base; }
+    V base() && { return std::move(m_base); }
+
+    iterator begin() { return iterator(this, 0); }
+
+    auto end()
+    {
+        if constexpr(is_random_access)
+        {
+            return iterator(this, static_cast<std::ptrdiff_t>(size()));
+        }
+        else
+        {
+            return std::default_sentinel;
+        }
+    }
+
+    auto size() requires std::ranges::sized_range<V>
+    {
+        return static_cast<size_t>(safe16_get_encoded_length(static_cast<int64_t>(std::ranges::size(m_base)), false));
+    }
+};
+
+template <typename R>
+encode_view(R&&) -> encode_view<std::views::all_t<R>>;
+
+/**
+ * A view of the bytes decoded from a range of safe16 characters, produced a
+ * block at a time as it is iterated. Whitespace is skipped.
+ *
+ * Decoding stops at the first invalid character, after which status()
+ * reports SAFE16_ERROR_INVALID_SOURCE_DATA.
+ */
+template <std::ranges::view V>
+    requires std::ranges::forward_range<V> &&
+             std::convertible_to<std::ranges::range_reference_t<V>, char>
+class decode_view : public std::ranges::view_interface<decode_view<V>>
+{
+    static constexpr bool is_contiguous = detail::g_view_is_contiguous<V>;
+    static constexpr int groups_per_block = is_contiguous ? detail::g_view_groups_per_block : 1;
+    // The library may finish the last group in the block past the end of
+    // dst, so leave room for one more.
+    static constexpr int block_bytes = (groups_per_block + 1) * detail::g_ct_bytes_per_group;
+
+    V m_base = V();
+    safe16_status m_status = SAFE16_STATUS_OK;
+
+public:
+    class iterator
+    {
+        using base_iterator = std::ranges::iterator_t<V>;
+
+        decode_view* m_parent = nullptr;
+        base_iterator m_next = base_iterator();
+        std::ptrdiff_t m_index = 0;
+        int m_offset = 0;
+        int m_block_length = 0;
+        uint8_t m_block[block_bytes] = {};
+
+        void stop(const safe16_status status)
+        {
+            m_parent->m_status = status;
+            m_next = std::ranges::next(m_next, std::ranges::end(m_parent->m_base));
+        }
+
+        void load_block()
+        {
+            const auto end = std::ranges::end(m_parent->m_base);
+            m_offset = 0;
+            m_block_length = 0;
+            if(m_next == end)
+            {
+                return;
+            }
+            if constexpr(is_contiguous)
+            {
+                const uint8_t* const src_start = reinterpret_cast<const uint8_t*>(std::to_address(m_next));
+                const uint8_t* src = src_start;
+                uint8_t* dst = m_block;
+                const safe16_status status = safe16_decode_feed(&src, end - m_next, &dst, block_bytes, SAFE16_SRC_IS_AT_END_OF_STREAM);
+                m_block_length = static_cast<int>(dst - m_block);
+                m_next += src - src_start;
+                if(status != SAFE16_STATUS_OK && status != SAFE16_STATUS_PARTIALLY_COMPLETE)
+                {
+                    stop(status);
+                }
+            }
+            else
+            {
+                int chunks[detail::g_ct_chunks_per_group] = {};
+                int chunk_count = 0;
+                for(; chunk_count < detail::g_ct_chunks_per_group && m_next != end; ++m_next)
+                {
+                    const int chunk = detail::ct_char_to_chunk(static_cast<char>(*m_next));
+                    if(chunk == detail::g_ct_chunk_code_whitespace)
+                    {
+                        continue;
+                    }
+                    if(chunk == detail::g_ct_chunk_code_error)
+                    {
+                        stop(SAFE16_ERROR_INVALID_SOURCE_DATA);
+                        return;
+                    }
+                    chunks[chunk_count++] = chunk;
+                }
+                detail::ct_decode_group(chunks, chunk_count, m_block);
+                m_block_length = detail::g_ct_chunk_to_byte_count[chunk_count];
+            }
+        }
+
+    public:
+        using iterator_concept = std::forward_iterator_tag;
+        using iterator_category = std::input_iterator_tag;
+        using value_type = uint8_t;
+        using difference_type = std::ptrdiff_t;
+
+        iterator() = default;
+
+        explicit iterator(decode_view* const parent)
+        : m_parent(parent)
+        , m_next(std::ranges::begin(parent->m_base))
+        {
+            load_block();
+        }
+
+        uint8_t operator*() const { return m_block[m_offset]; }
+
+        iterator& operator++()
+        {
+            m_index++;
+            if(++m_offset == m_block_length)
+            {
+                load_block();
+            }
+            return *this;
+        }
+
+        iterator operator++(int)
+        {
+            iterator previous = *this;
+            ++*this;
+            return previous;
+        }
+
+        friend bool operator==(const iterator& a, const iterator& b) { return a.m_index == b.m_index; }
+        friend bool operator==(const iterator& a, std::default_sentinel_t) { return a.m_offset >= a.m_block_length; }
+    };
+
+    decode_view() requires std::default_initializable<V> = default;
+    explicit decode_view(V base) : m_base(std::move(base)) {}
+
+    V base() const& requires std::copy_constructible<V> { return m_base; }
+    V base() && { return std::move(m_base); }
+
+    iterator begin()
+    {
+        m_status = SAFE16_STATUS_OK;
+        return iterator(this);
+    }
+
+    std::default_sentinel_t end() { return std::default_sentinel; }
+
+    safe16_status status() const { return m_status; }
+};
+
+template <typename R>
+decode_view(R&&) -> decode_view<std::views::all_t<R>>;
+
+namespace views
+{
+struct encode_fn : detail::range_adaptor_closure<encode_fn>
+{
+    template <std::ranges::viewable_range R>
+    auto operator()(R&& range) const
+    {
+        return encode_view(std::forward<R>(range));
+    }
+};
+
+struct decode_fn : detail::range_adaptor_closure<decode_fn>
+{
+    template <std::ranges::viewable_range R>
+    auto operator()(R&& range) const
+    {
+        return decode_view(std::forward<R>(range));
+    }
+};
+
+/**
+ * Range adaptors:
+ *
+ *     auto encoded = my_bytes | safe16::views::encode;
+ *     auto decoded = my_text | safe16::views::decode;
+ */
+inline constexpr encode_fn encode;
+inline constexpr decode_fn decode;
+} // namespace views
+
+#endif // SAFE16_HAS_RANGES
+
+
+// ---------------------------------------------------------------------------
+// Coroutines
+// ---------------------------------------------------------------------------
+
+#ifdef SAFE16_HAS_COROUTINES
+
+namespace detail
+{
+struct async_encode_policy
+{
+    using block_type = std::string_view;
+    static constexpr int input_group = g_ct_bytes_per_group;
+    static constexpr int output_group = g_ct_chunks_per_group;
+
+    static bool is_skipped(uint8_t) { return false; }
+
+    static safe16_status feed(const uint8_t** src, int64_t src_length, uint8_t** dst, int64_t dst_length, bool is_end)
+    {
+        return safe16_encode_feed(src, src_length, dst, dst_length, is_end);
+    }
+
+    static block_type make_block(const uint8_t* data, size_t length)
+    {
+        return block_type(reinterpret_cast<const char*>(data), length);
+    }
+};
+
+struct async_decode_policy
+{
+    using block_type = std::span<const uint8_t>;
+    static constexpr int input_group = g_ct_chunks_per_group;
+    // The library only completes a group in the middle of a stream when
+    // there's room left over.
+    static constexpr int output_group = g_ct_bytes_per_group + 1;
+
+    static bool is_skipped(uint8_t ch) { return ct_char_to_chunk(static_cast<char>(ch)) == g_ct_chunk_code_whitespace; }
+
+    static safe16_status feed(const uint8_t** src, int64_t src_length, uint8_t** dst, int64_t dst_length, bool is_end)
+    {
+        return safe16_decode_feed(src, src_length, dst, dst_length,
+                                  is_end ? SAFE16_SRC_IS_AT_END_OF_STREAM : SAFE16_STREAM_STATE_NONE);
+    }
+
+    static block_type make_block(const uint8_t* data, size_t length)
+    {
+        return block_type(data, length);
+    }
+};
+
+/**
+ * A single-producer, single-consumer channel that converts data on its way
+ * through a fixed-size output window.
+ *
+ * The producer's feed() suspends while its data doesn't fit in the window,
+ * and the consumer's next() suspends while there's nothing to read. Each side
+ * resumes the other directly (on the same thread) once it can continue, so
+ * both coroutines must be driven from the same thread or strand.
+ */
+template <typename POLICY>
+class async_codec
+{
+public:
+    using block_type = typename POLICY::block_type;
+
+    explicit async_codec(const size_t window_size)
+    : m_window(std::max(window_size, static_cast<size_t>(POLICY::output_group * 2)))
+    {
+    }
+
+    async_codec(const async_codec&) = delete;
+    async_codec& operator=(const async_codec&) = delete;
+
+    class feed_awaiter
+    {
+    public:
+        feed_awaiter(async_codec* const codec, const std::span<const uint8_t> data)
+        : m_codec(codec)
+        , m_data(data)
+        {
+        }
+
+        bool await_ready()
+        {
+            if(m_codec->m_is_finishing)
+            {
+                return true;
+            }
+            m_codec->m_pending = m_data;
+            m_codec->make_progress();
+            m_codec->wake_consumer_if_ready();
+            return !m_codec->is_producer_blocked();
+        }
+
+        void await_suspend(std::coroutine_handle<> handle) { m_codec->m_producer = handle; }
+        safe16_status await_resume() const { return m_codec->m_status; }
+
+    private:
+        async_codec* m_codec;
+        std::span<const uint8_t> m_data;
+    };
+
+    class finish_awaiter
+    {
+    public:
+        explicit finish_awaiter(async_codec* const codec) : m_codec(codec) {}
+
+        bool await_ready()
+        {
+            m_codec->m_is_finishing = true;
+            m_codec->make_progress();
+            m_codec->wake_consumer_if_ready();
+            return !m_codec->is_producer_blocked();
+        }
+
+        void await_suspend(std::coroutine_handle<> handle) { m_codec->m_producer = handle; }
+        safe16_status await_resume() const { return m_codec->m_status; }
+
+    private:
+        async_codec* m_codec;
+    };
+
+    class next_awaiter
+    {
+    public:
+        explicit next_awaiter(async_codec* const codec) : m_codec(codec) {}
+
+        bool await_ready()
+        {
+            m_codec->release_block();
+            m_codec->make_progress();
+            if(m_codec->m_producer && !m_codec->is_producer_blocked())
+            {
+                resume(m_codec->m_producer);
+            }
+            return m_codec->is_consumer_ready();
+        }
+
+        void await_suspend(std::coroutine_handle<> handle) { m_codec->m_consumer = handle; }
+        block_type await_resume() { return m_codec->take_block(); }
+
+    private:
+        async_codec* m_codec;
+    };
+
+    /**
+     * Feeds data in. Suspends until all of it has been taken, and returns the
+     * status so far.
+     */
+    feed_awaiter feed(const std::span<const uint8_t> data) { return feed_awaiter(this, data); }
+
+    feed_awaiter feed(const std::string_view data)
+    {
+        return feed(std::span<const uint8_t>(reinterpret_cast<const uint8_t*>(data.data()), data.size()));
+    }
+
+    /**
+     * Marks the end of the data, suspending until the last of it is in the
+     * window.
+     */
+    finish_awaiter finish() { return finish_awaiter(this); }
+
+    /**
+     * Gets the next block of output, suspending until there is some. The
+     * block stays valid until the next call to next(). An empty block marks
+     * the end of the output.
+     */
+    next_awaiter next() { return next_awaiter(this); }
+
+    safe16_status status() const { return m_status; }
+
+private:
+    static void resume(std::coroutine_handle<>& handle)
+    {
+        std::coroutine_handle<> to_resume = handle;
+        handle = nullptr;
+        to_resume.resume();
+    }
+
+    bool is_producer_blocked() const
+    {
+        return !m_pending.empty() || (m_is_finishing && !m_is_finished);
+    }
+
+    bool is_consumer_ready() const
+    {
+        return m_window_length > m_delivered_length || m_is_finished;
+    }
+
+    void wake_consumer_if_ready()
+    {
+        if(m_consumer && is_consumer_ready())
+        {
+            resume(m_consumer);
+        }
+    }
+
+    int64_t get_room() const
+    {
+        return static_cast<int64_t>(m_window.size() - m_window_length);
+    }
+
+    void fail(const safe16_status status)
+    {
+        m_status = status;
+        m_pending = {};
+        m_carry_length = 0;
+        m_is_finished = true;
+    }
+
+    void move_pending_to_carry()
+    {
+        while(m_carry_length < POLICY::input_group && !m_pending.empty())
+        {
+            const uint8_t next = m_pending.front();
+            m_pending = m_pending.subspan(1);
+            if(!POLICY::is_skipped(next))
+            {
+                m_carry[m_carry_length++] = next;
+            }
+        }
+    }
+
+    bool is_pending_partial() const
+    {
+        int count = 0;
+        for(size_t i = 0; i < m_pending.size() && count < POLICY::input_group; i++)
+        {
+            if(!POLICY::is_skipped(m_pending[i]))
+            {
+                count++;
+            }
+        }
+        return count < POLICY::input_group;
+    }
+
+    // Returns true if all of src was taken.
+    bool convert(const uint8_t* const src, const int64_t src_length, const bool is_end)
+    {
+        const uint8_t* src_ptr = src;
+        uint8_t* dst = m_window.data() + m_window_length;
+        const safe16_status status = POLICY::feed(&src_ptr, src_length, &dst, get_room(), is_end);
+        m_window_length = dst - m_window.data();
+        if(status != SAFE16_STATUS_OK && status != SAFE16_STATUS_PARTIALLY_COMPLETE)
+        {
+            fail(status);
+            return false;
+        }
+        m_pending_taken = src_ptr - src;
+        return src_ptr == src + src_length;
+    }
+
+    // Moves as much pending data into the window as fits. Whole groups are
+    // converted straight from the producer's buffer, and a trailing partial
+    // group is carried over so that the producer's buffer can be released.
+    void make_progress()
+    {
+        if(m_is_finished)
+        {
+            m_pending = {};
+            return;
+        }
+        if(m_carry_length > 0)
+        {
+            move_pending_to_carry();
+            if(m_carry_length == POLICY::input_group)
+            {
+                if(get_room() < POLICY::output_group || !convert(m_carry, m_carry_length, false))
+                {
+                    return;
+                }
+                m_carry_length = 0;
+            }
+        }
+        if(!m_pending.empty() && get_room() >= POLICY::output_group)
+        {
+            convert(m_pending.data(), static_cast<int64_t>(m_pending.size()), false);
+            if(m_is_finished)
+            {
+                return;
+            }
+            m_pending = m_pending.subspan(m_pending_taken);
+        }
+        if(!m_pending.empty() && is_pending_partial())
+        {
+            move_pending_to_carry();
+        }
+        if(m_pending.empty() && m_is_finishing)
+        {
+            finish_carry();
+        }
+    }
+
+    void finish_carry()
+    {
+        if(get_room() < POLICY::output_group)
+        {
+            return;
+        }
+        if(m_carry_length == 0 || convert(m_carry, m_carry_length, true))
+        {
+            m_carry_length = 0;
+            m_is_finished = true;
+        }
+    }
+
+    void release_block()
+    {
+        if(m_delivered_length > 0)
+        {
+            std::copy(m_window.begin() + m_delivered_length,
+                      m_window.begin() + m_window_length,
+                      m_window.begin());
+            m_window_length -= m_delivered_length;
+            m_delivered_length = 0;
+        }
+    }
+
+    block_type take_block()
+    {
+        m_delivered_length = m_window_length;
+        return POLICY::make_block(m_window.data(), m_delivered_length);
+    }
+
+    std::vector<uint8_t> m_window;
+    size_t m_window_length = 0;
+    size_t m_delivered_length = 0;
+    std::span<const uint8_t> m_pending;
+    size_t m_pending_taken = 0;
+    uint8_t m_carry[POLICY::input_group] = {};
+    int m_carry_length = 0;
+    bool m_is_finishing = false;
+    bool m_is_finished = false;
+    safe16_status m_status = SAFE16_STATUS_OK;
+    std::coroutine_handle<> m_producer = nullptr;
+    std::coroutine_handle<> m_consumer = nullptr;
+};
+} // namespace detail
+
+/**
+ * Encodes data passing from a producer coroutine to a consumer coroutine:
+ *
+ *     // Producer
+ *     co_await encoder.feed(chunk);
+ *     ...
+ *     co_await encoder.finish();
+ *
+ *     // Consumer
+ *     for(auto block = co_await encoder.next(); !block.empty(); block = co_await encoder.next())
+ *     {
+ *         co_await write(block);
+ *     }
+ *
+ * At most window_size encoded characters are buffered, so a producer that
+ * outpaces the consumer is suspended until the consumer catches up.
+ */
+class async_encoder : public detail::async_codec<detail::async_encode_policy>
+{
+public:
+    explicit async_encoder(const size_t window_size = 65536) : async_codec(window_size) {}
+};
+
+/**
+ * Same as async_encoder, but decodes. Blocks are spans of bytes.
+ * Whitespace is skipped, and invalid data ends the output, with the error
+ * returned from feed() and finish() and available from status().
+ */
+class async_decoder : public detail::async_codec<detail::async_decode_policy>
+{
+public:
+    explicit async_decoder(const size_t window_size = 65536) : async_codec(window_size) {}
+};
+
+#endif // SAFE16_HAS_COROUTINES
+
+#endif // SAFE16_HAS_CPP17
+
+#ifdef SAFE16_HAS_PMR
+
+/**
+ * Encodes some binary data into a string whose memory comes from its
+ * polymorphic allocator (for example a std::pmr::monotonic_buffer_resource).
+ * The string is resized exactly once, to the exact encoded length.
+ *
+ * @return the number of bytes written, or a status code (in which case dst is cleared).
+ */
+inline int64_t encode(const uint8_t* src, int64_t src_length, std::pmr::string& dst)
+{
+    return detail::alloc_into(safe16_encode_alloc, src, src_length, dst);
+}
+
+/**
+ * Same as encode(), but with a length field.
+ */
+inline int64_t encode_with_length(const uint8_t* src, int64_t src_length, std::pmr::string& dst)
+{
+    return detail::alloc_into(safe16l_encode_alloc, src, src_length, dst);
+}
+
+/**
+ * Decodes a safe16 sequence into a vector whose memory comes from its
+ * polymorphic allocator. The source is validated first, and the vector is
+ * resized exactly once, to the exact decoded length.
+ *
+ * @return the number of bytes written, or a status code (in which case dst is cleared).
+ */
+inline int64_t decode(const uint8_t* src, int64_t src_length, std::pmr::vector<uint8_t>& dst)
+{
+    return detail::alloc_into(safe16_decode_alloc, src, src_length, dst);
+}
+
+/**
+ * Same as decode(), but for a safe16L (safe16 + length) sequence.
+ */
+inline int64_t decode_with_length(const uint8_t* src, int64_t src_length, std::pmr::vector<uint8_t>& dst)
+{
+    return detail::alloc_into(safe16l_decode_alloc, src, src_length, dst);
+}
+
+#endif // SAFE16_HAS_PMR
+
+} // namespace safe16
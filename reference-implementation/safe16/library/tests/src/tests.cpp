@@ -1,11 +1,24 @@
+#include <algorithm>
+#include <deque>
+#include <list>
+#include <sstream>
 #include <gtest/gtest.h>
 #include <safe16/safe16.h>
+#include <safe16/safe16.hpp>
 
 // #define KSLogger_LocalLevel TRACE
 #include "kslogger.h"
 
+#if defined(SAFE16_EXPECT_RANGES) && !defined(SAFE16_HAS_RANGES)
+    #error "This test build expects safe16.hpp to provide the range adaptors"
+#endif
+#if defined(SAFE16_EXPECT_COROUTINES) && !defined(SAFE16_HAS_COROUTINES)
+    #error "This test build expects safe16.hpp to provide the coroutine adaptors"
+#endif
+
 static const int g_bytes_per_group  = 1;
 static const int g_chunks_per_group = 2;
+static const int g_radix            = 16;
 
 
 // ----------
@@ -214,6 +227,38 @@ void assert_chunked_decode_dst_packeted(int length)
     }
 }
 
+void assert_chunked_decode_dst_limited(int length)
+{
+    KSLOG_DEBUG("Length %d", length);
+    std::vector<uint8_t> data = make_bytes(length, length);
+    std::vector<uint8_t> encode_buffer(length * 2);
+    int64_t encoded_length = safe16_encode(data.data(), data.size(), encode_buffer.data(), encode_buffer.size());
+    ASSERT_GT(encoded_length, 0);
+    const uint8_t* encoded_end = (uint8_t*)encode_buffer.data() + encoded_length;
+
+    for(int packet_size=length-1; packet_size > g_bytes_per_group; packet_size--)
+    {
+        KSLOG_DEBUG("packet size %d", packet_size);
+        safe16_status status = SAFE16_STATUS_PARTIALLY_COMPLETE;
+        const uint8_t* d_src = (uint8_t*)encode_buffer.data();
+        std::vector<uint8_t> decoded;
+
+        while(status == SAFE16_STATUS_PARTIALLY_COMPLETE)
+        {
+            std::vector<uint8_t> packet(packet_size);
+            uint8_t* d_dst = packet.data();
+            status = safe16_decode_feed(&d_src,
+                                        encoded_end - d_src,
+                                        &d_dst,
+                                        packet.size(),
+                                        SAFE16_SRC_IS_AT_END_OF_STREAM);
+            decoded.insert(decoded.end(), packet.data(), d_dst);
+        }
+        ASSERT_EQ(SAFE16_STATUS_OK, status);
+        ASSERT_EQ(data, decoded);
+    }
+}
+
 void assert_decode(std::string expected_encoded, std::vector<uint8_t> expected_decoded)
 {
     int64_t decoded_length = safe16_get_decoded_length(expected_encoded.size());
@@ -280,7 +325,817 @@ void assert_decode_length(std::string encoded, int64_t expected_length, int64_t
     }
 }
 
+void assert_encode_decode_batch(std::vector<int> record_lengths)
+{
+    std::vector<std::vector<uint8_t>> records;
+    std::vector<const uint8_t*> src_buffers;
+    std::vector<int64_t> src_lengths;
+    int64_t expected_encoded_length = 0;
+    for(size_t i = 0; i < record_lengths.size(); i++)
+    {
+        records.push_back(make_bytes(record_lengths[i], (int)i * 7));
+        expected_encoded_length += safe16_get_encoded_length(record_lengths[i], false);
+    }
+    for(auto& record: records)
+    {
+        src_buffers.push_back(record.data());
+        src_lengths.push_back(record.size());
+    }
+
+    std::vector<uint8_t> encode_buffer(expected_encoded_length);
+    std::vector<int64_t> encoded_offsets(records.size() + 1);
+    int64_t actual_encoded_length = safe16_encode_batch(src_buffers.data(),
+                                                        src_lengths.data(),
+                                                        records.size(),
+                                                        encode_buffer.data(),
+                                                        encode_buffer.size(),
+                                                        encoded_offsets.data());
+    ASSERT_EQ(expected_encoded_length, actual_encoded_length);
+    ASSERT_EQ(expected_encoded_length, encoded_offsets[records.size()]);
+
+    std::vector<const uint8_t*> encoded_buffers;
+    std::vector<int64_t> encoded_lengths;
+    for(size_t i = 0; i < records.size(); i++)
+    {
+        std::vector<uint8_t> expected_encoded(safe16_get_encoded_length(records[i].size(), false));
+        int64_t used_bytes = safe16_encode(records[i].data(),
+                                           records[i].size(),
+                                           expected_encoded.data(),
+                                           expected_encoded.size());
+        ASSERT_EQ(encoded_offsets[i+1] - encoded_offsets[i], used_bytes);
+        std::vector<uint8_t> actual_encoded(encode_buffer.begin() + encoded_offsets[i],
+                                            encode_buffer.begin() + encoded_offsets[i+1]);
+        ASSERT_EQ(expected_encoded, actual_encoded);
+        encoded_buffers.push_back(encode_buffer.data() + encoded_offsets[i]);
+        encoded_lengths.push_back(encoded_offsets[i+1] - encoded_offsets[i]);
+    }
+
+    std::vector<uint8_t> decode_buffer(safe16_get_decoded_length(expected_encoded_length));
+    std::vector<int64_t> decoded_offsets(records.size() + 1);
+    int64_t actual_decoded_length = safe16_decode_batch(encoded_buffers.data(),
+                                                        encoded_lengths.data(),
+                                                        records.size(),
+                                                        decode_buffer.data(),
+                                                        decode_buffer.size(),
+                                                        decoded_offsets.data());
+    ASSERT_EQ(decoded_offsets[records.size()], actual_decoded_length);
+    for(size_t i = 0; i < records.size(); i++)
+    {
+        std::vector<uint8_t> actual_decoded(decode_buffer.begin() + decoded_offsets[i],
+                                            decode_buffer.begin() + decoded_offsets[i+1]);
+        ASSERT_EQ(records[i], actual_decoded);
+    }
+}
+
+std::string encode_to_string(const std::vector<uint8_t>& data)
+{
+    std::vector<uint8_t> encode_buffer(safe16_get_encoded_length(data.size(), false));
+    int64_t used_bytes = safe16_encode(data.data(), data.size(), encode_buffer.data(), encode_buffer.size());
+    return std::string(encode_buffer.begin(), encode_buffer.begin() + used_bytes);
+}
+
+std::string add_whitespace(const std::string& encoded)
+{
+    std::string result = "\n";
+    for(size_t i = 0; i < encoded.size(); i++)
+    {
+        result += encoded[i];
+        if(i % 3 == 1)
+        {
+            result += " \t";
+        }
+    }
+    return result;
+}
+
+std::string skip_whitespace(const std::string& str)
+{
+    return str.substr(std::min(str.find_first_not_of(" \t\r\n"), str.size()));
+}
+
+// Keys with lots of shared prefixes, covering full and partial groups.
+std::vector<std::vector<uint8_t>> make_sort_keys(int key_count)
+{
+    const uint8_t interesting_values[] = {0x00, 0x01, 0x7f, 0x80, 0xfe, 0xff};
+    uint32_t random = 12345;
+    auto next_random = [&random]() { random = random * 1103515245 + 12345; return (random >> 16) & 0x7fff; };
+
+    std::vector<uint8_t> base;
+    for(int i = 0; i < g_bytes_per_group * 3; i++)
+    {
+        base.push_back(interesting_values[next_random() % sizeof(interesting_values)]);
+    }
+
+    std::vector<std::vector<uint8_t>> keys;
+    for(int i = 0; i < key_count; i++)
+    {
+        std::vector<uint8_t> key(base.begin(), base.begin() + next_random() % base.size());
+        int tail_length = next_random() % (g_bytes_per_group + 2);
+        for(int j = 0; j < tail_length; j++)
+        {
+            key.push_back(interesting_values[next_random() % sizeof(interesting_values)]);
+        }
+        keys.push_back(key);
+    }
+    return keys;
+}
+
+int sign_of(int value)
+{
+    return (value > 0) - (value < 0);
+}
+
+void assert_compare_encoded(const std::vector<uint8_t>& a, const std::vector<uint8_t>& b)
+{
+    int expected = (a < b) ? -1 : (b < a) ? 1 : 0;
+    std::string a_encoded = encode_to_string(a);
+    std::string b_encoded = encode_to_string(b);
+    std::string a_spaced = add_whitespace(a_encoded);
+    int actual = 100;
+
+    ASSERT_EQ(SAFE16_STATUS_OK, safe16_compare_encoded((uint8_t*)a_encoded.data(), a_encoded.size(),
+                                                       (uint8_t*)b_encoded.data(), b_encoded.size(),
+                                                       &actual));
+    ASSERT_EQ(expected, sign_of(actual)) << a_encoded << " vs " << b_encoded;
+    ASSERT_EQ(SAFE16_STATUS_OK, safe16_compare_encoded((uint8_t*)a_spaced.data(), a_spaced.size(),
+                                                       (uint8_t*)b_encoded.data(), b_encoded.size(),
+                                                       &actual));
+    ASSERT_EQ(expected, sign_of(actual)) << a_spaced << " vs " << b_encoded;
+    ASSERT_EQ(SAFE16_STATUS_OK, safe16_compare_encoded_to_binary((uint8_t*)a_spaced.data(), a_spaced.size(),
+                                                                 b.data(), b.size(),
+                                                                 &actual));
+    ASSERT_EQ(expected, sign_of(actual)) << a_spaced << " vs binary";
+}
+
+void assert_encoded_range_for_prefix(const std::vector<uint8_t>& prefix)
+{
+    std::vector<uint8_t> lo(safe16_get_encoded_length(prefix.size(), false) + g_chunks_per_group);
+    std::vector<uint8_t> hi(lo.size());
+    int64_t lo_length = lo.size();
+    int64_t hi_length = hi.size();
+    ASSERT_EQ(SAFE16_STATUS_OK, safe16_encoded_range_for_prefix(prefix.data(), prefix.size(),
+                                                                lo.data(), &lo_length,
+                                                                hi.data(), &hi_length));
+    std::string lo_bound(lo.begin(), lo.begin() + lo_length);
+    std::string hi_bound(hi.begin(), hi.begin() + hi_length);
+
+    // Every key with the prefix, including the extremes at each length.
+    std::vector<std::vector<uint8_t>> keys;
+    std::vector<std::vector<uint8_t>> tails = {{}};
+    for(int length = 1; length <= g_bytes_per_group + 1; length++)
+    {
+        tails.push_back(std::vector<uint8_t>(length, 0x00));
+        tails.push_back(std::vector<uint8_t>(length, 0xff));
+        tails.push_back(make_bytes(length, length * 31));
+    }
+    for(auto& tail: tails)
+    {
+        std::vector<uint8_t> key = prefix;
+        key.insert(key.end(), tail.begin(), tail.end());
+        keys.push_back(key);
+    }
+
+    std::string lowest_encoded;
+    bool is_first = true;
+    for(auto& key: keys)
+    {
+        std::string encoded = encode_to_string(key);
+        ASSERT_LE(lo_bound, encoded);
+        if(hi_length > 0)
+        {
+            ASSERT_LT(encoded, hi_bound);
+        }
+        if(is_first || encoded < lowest_encoded)
+        {
+            lowest_encoded = encoded;
+            is_first = false;
+        }
+    }
+    ASSERT_EQ(lowest_encoded, lo_bound);
+}
+
+
+void assert_encode_decode_alloc(int length)
+{
+    std::vector<uint8_t> data = make_bytes(length, length);
+    std::vector<uint8_t> arena_buffer(2000);
+    safe16_arena arena = {arena_buffer.data(), (int64_t)arena_buffer.size(), 0};
+
+    uint8_t* encoded = nullptr;
+    int64_t encoded_length = safe16_encode_alloc(data.data(), data.size(), safe16_arena_allocate, &arena, &encoded);
+    ASSERT_EQ(safe16_get_encoded_length(length, false), encoded_length);
+    ASSERT_EQ(encoded_length, arena.used);
+    ASSERT_EQ(encode_to_string(data), std::string(encoded, encoded + encoded_length));
+
+    std::string spaced = add_whitespace(std::string(encoded, encoded + encoded_length));
+    ASSERT_EQ(length, safe16_get_decoded_length_exact((const uint8_t*)spaced.data(), spaced.size()));
+    arena.used = 0;
+    uint8_t* decoded = nullptr;
+    int64_t decoded_length = safe16_decode_alloc((const uint8_t*)spaced.data(), spaced.size(), safe16_arena_allocate, &arena, &decoded);
+    ASSERT_EQ(length, decoded_length);
+    ASSERT_EQ(length, arena.used);
+    ASSERT_EQ(data, std::vector<uint8_t>(decoded, decoded + decoded_length));
+
+    arena.used = 0;
+    encoded_length = safe16l_encode_alloc(data.data(), data.size(), safe16_arena_allocate, &arena, &encoded);
+    ASSERT_EQ(safe16_get_encoded_length(length, true), encoded_length);
+    ASSERT_EQ(encoded_length, arena.used);
+    arena.used = 0;
+    spaced = add_whitespace(std::string(encoded, encoded + encoded_length));
+    decoded_length = safe16l_decode_alloc((const uint8_t*)spaced.data(), spaced.size(), safe16_arena_allocate, &arena, &decoded);
+    ASSERT_EQ(length, decoded_length);
+    ASSERT_EQ(length, arena.used);
+    ASSERT_EQ(data, std::vector<uint8_t>(decoded, decoded + decoded_length));
+}
+
+void assert_chunked_decode_with_length(int length)
+{
+    KSLOG_DEBUG("Length %d", length);
+    std::vector<uint8_t> data = make_bytes(length, length);
+    std::vector<uint8_t> encode_buffer(safe16_get_encoded_length(length, true));
+    int64_t encoded_length = safe16l_encode(data.data(), data.size(), encode_buffer.data(), encode_buffer.size());
+    ASSERT_EQ((int64_t)encode_buffer.size(), encoded_length);
+    std::string trailer = encode_to_string(make_bytes(10, 1));
+    std::string encoded = add_whitespace(std::string(encode_buffer.begin(), encode_buffer.end())) + trailer;
+    const uint8_t* encoded_end = (const uint8_t*)encoded.data() + encoded.size();
+
+    for(int packet_size = 1; packet_size <= (int)encoded.size(); packet_size += packet_size / 4 + 1)
+    {
+        KSLOG_DEBUG("src packet size %d", packet_size);
+        safe16l_decoder decoder;
+        safe16l_decoder_init(&decoder);
+        std::vector<uint8_t> decoded(length);
+        uint8_t* d_dst = decoded.data();
+        const uint8_t* d_src = (const uint8_t*)encoded.data();
+        const uint8_t* d_src_end = d_src;
+        safe16_status status = SAFE16_STATUS_PARTIALLY_COMPLETE;
+        while(status == SAFE16_STATUS_PARTIALLY_COMPLETE)
+        {
+            d_src_end += packet_size;
+            if(d_src_end > encoded_end)
+            {
+                d_src_end = encoded_end;
+            }
+            status = safe16l_decode_feed(&decoder,
+                                         &d_src,
+                                         d_src_end - d_src,
+                                         &d_dst,
+                                         decoded.data() + decoded.size() - d_dst,
+                                         d_src_end == encoded_end);
+        }
+        ASSERT_EQ(SAFE16_STATUS_OK, status);
+        ASSERT_EQ(length, decoder.declared_length);
+        ASSERT_EQ(length, decoder.decoded_length);
+        ASSERT_EQ(data, decoded);
+        ASSERT_EQ(trailer, skip_whitespace(std::string((const char*)d_src, (const char*)encoded_end)));
+    }
+
+    for(int packet_size = g_bytes_per_group + 1; packet_size <= length + 1; packet_size++)
+    {
+        KSLOG_DEBUG("dst packet size %d", packet_size);
+        safe16l_decoder decoder;
+        safe16l_decoder_init(&decoder);
+        std::vector<uint8_t> decoded;
+        const uint8_t* d_src = (const uint8_t*)encoded.data();
+        safe16_status status = SAFE16_STATUS_PARTIALLY_COMPLETE;
+        while(status == SAFE16_STATUS_PARTIALLY_COMPLETE)
+        {
+            std::vector<uint8_t> packet(packet_size);
+            uint8_t* d_dst = packet.data();
+            status = safe16l_decode_feed(&decoder, &d_src, encoded_end - d_src, &d_dst, packet.size(), true);
+            decoded.insert(decoded.end(), packet.data(), d_dst);
+        }
+        ASSERT_EQ(SAFE16_STATUS_OK, status);
+        ASSERT_EQ(data, decoded);
+        ASSERT_EQ(trailer, skip_whitespace(std::string((const char*)d_src, (const char*)encoded_end)));
+    }
+}
+
+void assert_chunked_encode_with_length(int length)
+{
+    KSLOG_DEBUG("Length %d", length);
+    std::vector<uint8_t> data = make_bytes(length, length);
+    std::vector<uint8_t> expected(safe16_get_encoded_length(length, true));
+    ASSERT_EQ((int64_t)expected.size(), safe16l_encode(data.data(), data.size(), expected.data(), expected.size()));
+    const uint8_t* data_end = data.data() + data.size();
+
+    for(int packet_size = 1; packet_size <= length + 1; packet_size += packet_size / 4 + 1)
+    {
+        KSLOG_DEBUG("packet size %d", packet_size);
+        safe16l_encoder encoder;
+        ASSERT_EQ(SAFE16_STATUS_OK, safe16l_encoder_init(&encoder, length));
+        std::vector<uint8_t> encoded;
+        const uint8_t* e_src = data.data();
+        const uint8_t* e_src_end = e_src;
+        safe16_status status = SAFE16_STATUS_PARTIALLY_COMPLETE;
+        while(status == SAFE16_STATUS_PARTIALLY_COMPLETE)
+        {
+            e_src_end += packet_size;
+            if(e_src_end > data_end)
+            {
+                e_src_end = data_end;
+            }
+            std::vector<uint8_t> packet(packet_size + g_chunks_per_group + 10);
+            uint8_t* e_dst = packet.data();
+            status = safe16l_encode_feed(&encoder, &e_src, e_src_end - e_src, &e_dst, packet.size(), e_src_end == data_end);
+            encoded.insert(encoded.end(), packet.data(), e_dst);
+        }
+        ASSERT_EQ(SAFE16_STATUS_OK, status);
+        ASSERT_EQ(data_end, e_src);
+        ASSERT_EQ(length, encoder.encoded_length);
+        ASSERT_EQ(expected, encoded);
+    }
+}
+
+void assert_index_records(std::vector<int> record_lengths, bool use_whitespace)
+{
+    std::string stream;
+    std::vector<safe16l_record_span> expected_spans;
+    for(size_t i = 0; i < record_lengths.size(); i++)
+    {
+        std::vector<uint8_t> data = make_bytes(record_lengths[i], i);
+        std::vector<uint8_t> encoded(safe16_get_encoded_length(data.size(), true));
+        ASSERT_EQ((int64_t)encoded.size(), safe16l_encode(data.data(), data.size(), encoded.data(), encoded.size()));
+        std::string record(encoded.begin(), encoded.end());
+        if(use_whitespace)
+        {
+            record = add_whitespace(record);
+            stream += "\r\n";
+            record = skip_whitespace(record);
+            record.erase(record.find_last_not_of(" \t\r\n") + 1);
+        }
+        safe16l_record_span span = {(int64_t)stream.size(), (int64_t)record.size(), record_lengths[i]};
+        expected_spans.push_back(span);
+        stream += record;
+    }
+    if(use_whitespace)
+    {
+        stream += " \n";
+    }
+
+    const uint8_t* src = (const uint8_t*)stream.data();
+    ASSERT_EQ((int64_t)record_lengths.size(), safe16l_index_records(src, stream.size(), use_whitespace, NULL, 0));
+    std::vector<safe16l_record_span> spans(record_lengths.size() + 1);
+    ASSERT_EQ((int64_t)record_lengths.size(), safe16l_index_records(src, stream.size(), use_whitespace, spans.data(), spans.size()));
+    for(size_t i = 0; i < record_lengths.size(); i++)
+    {
+        ASSERT_EQ(expected_spans[i].offset, spans[i].offset);
+        ASSERT_EQ(expected_spans[i].encoded_length, spans[i].encoded_length);
+        ASSERT_EQ(expected_spans[i].decoded_length, spans[i].decoded_length);
+
+        std::vector<uint8_t> decoded(spans[i].decoded_length);
+        ASSERT_EQ(spans[i].decoded_length, safe16l_decode(src + spans[i].offset, spans[i].encoded_length, decoded.data(), decoded.size()));
+        ASSERT_EQ(make_bytes(record_lengths[i], i), decoded);
+    }
+}
+
+// Lays out encoded text the same way as the command line tool's -n and -i options.
+std::string apply_layout(const std::string& encoded, const safe16_layout& layout)
+{
+    std::string indent(layout.indent_length, ' ');
+    std::string line_break = layout.use_crlf ? "\r\n" : "\n";
+    std::string result = indent;
+    for(size_t i = 0; i < encoded.size(); i++)
+    {
+        result += encoded[i];
+        if(layout.line_length > 0 && (int64_t)(i + 1) % layout.line_length == 0)
+        {
+            result += line_break + indent;
+        }
+    }
+    return result;
+}
+
+void assert_decode_range(int length, const safe16_layout* layout)
+{
+    std::vector<uint8_t> data = make_bytes(length, length);
+    std::string encoded = encode_to_string(data);
+    if(layout != NULL)
+    {
+        encoded = apply_layout(encoded, *layout);
+    }
+    const uint8_t* src = (const uint8_t*)encoded.data();
+
+    for(int offset = 0; offset <= length + 1; offset += offset / 8 + 1)
+    {
+        for(int count = 0; count <= length + 1; count += count / 4 + 1)
+        {
+            KSLOG_DEBUG("Offset %d, count %d", offset, count);
+            std::vector<uint8_t> decoded(count);
+            int64_t expected_count = std::max(0, std::min(count, length - offset));
+            ASSERT_EQ(expected_count, safe16_decode_range(src, encoded.size(), offset, count, decoded.data(), decoded.size(), layout));
+            decoded.resize(expected_count);
+            ASSERT_EQ(std::vector<uint8_t>(data.begin() + std::min(offset, length), data.begin() + std::min(offset, length) + expected_count), decoded);
+
+            // Decoding only the located part gives the same range.
+            int64_t src_offset = 0;
+            int64_t src_length = 0;
+            int64_t skip_count = 0;
+            ASSERT_EQ(SAFE16_STATUS_OK, safe16_locate_range(offset, count, layout, &src_offset, &src_length, &skip_count));
+            src_offset = std::min(src_offset, (int64_t)encoded.size());
+            src_length = std::min(src_length, (int64_t)encoded.size() - src_offset);
+            std::vector<uint8_t> part(src_length);
+            int64_t part_length = safe16_decode(src + src_offset, src_length, part.data(), part.size());
+            ASSERT_GE(part_length, 0);
+            part.resize(std::max(skip_count, part_length));
+            ASSERT_EQ(decoded, std::vector<uint8_t>(part.begin() + skip_count, part.begin() + std::max(skip_count, std::min(part_length, skip_count + expected_count))));
+        }
+    }
+}
+
+void assert_container(int length, int segment_length, const safe16_layout* layout)
+{
+    KSLOG_DEBUG("Length %d, segment length %d", length, segment_length);
+    std::vector<uint8_t> data = make_bytes(length, length);
+    int64_t encoded_length = safe16_container_get_encoded_length(length, segment_length, layout);
+    ASSERT_GT(encoded_length, 0);
+    std::vector<uint8_t> encoded(encoded_length + 2);
+    ASSERT_EQ(encoded_length, safe16_container_encode(data.data(), data.size(), segment_length, encoded.data(), encoded_length, layout));
+    if(layout != NULL)
+    {
+        std::string text(encoded.begin(), encoded.begin() + encoded_length);
+        std::string chars;
+        std::copy_if(text.begin(), text.end(), std::back_inserter(chars), [](char ch) { return ch != ' ' && ch != '\r' && ch != '\n'; });
+        ASSERT_EQ(apply_layout(chars, *layout), text);
+    }
+    encoded[encoded_length] = '\r';
+    encoded[encoded_length + 1] = '\n';
+
+    safe16_container container;
+    ASSERT_EQ(SAFE16_STATUS_OK, safe16_container_open(encoded.data(), encoded.size(), &container));
+    ASSERT_EQ(length, container.data_length);
+    ASSERT_EQ(segment_length, container.segment_length);
+    ASSERT_EQ((length + segment_length - 1) / segment_length, container.segment_count);
+
+    std::vector<uint8_t> decoded;
+    for(int64_t i = 0; i < container.segment_count; i++)
+    {
+        std::vector<uint8_t> segment(segment_length);
+        int64_t segment_decoded_length = safe16_container_decode_segment(encoded.data(), encoded.size(), &container, i, segment.data(), segment.size());
+        ASSERT_EQ(std::min(segment_length, length - (int)i * segment_length), segment_decoded_length);
+        decoded.insert(decoded.end(), segment.begin(), segment.begin() + segment_decoded_length);
+    }
+    ASSERT_EQ(data, decoded);
+
+    // Opening from just the end and the index, and decoding each segment
+    // from only its own part, as is done when reading from a file.
+    int64_t trailer_offset = 0;
+    int64_t index_offset = SAFE16_ERROR_TRUNCATED_DATA;
+    for(int64_t end_length = 1; index_offset == SAFE16_ERROR_TRUNCATED_DATA; end_length++)
+    {
+        index_offset = safe16_container_find_index(encoded.data() + encoded.size() - end_length, end_length, encoded.size(), &trailer_offset);
+    }
+    ASSERT_EQ(container.index_offset, index_offset);
+    const uint8_t* index = encoded.data() + index_offset;
+    const int64_t index_length = trailer_offset - index_offset;
+    safe16_container index_container;
+    ASSERT_EQ(SAFE16_STATUS_OK, safe16_container_open_index(index, index_length, index_offset, &index_container));
+    ASSERT_EQ(container.data_length, index_container.data_length);
+    ASSERT_EQ(container.segment_count, index_container.segment_count);
+    ASSERT_EQ(container.trailer_offset, index_container.trailer_offset);
+    decoded.clear();
+    for(int64_t i = 0; i < container.segment_count; i++)
+    {
+        int64_t segment_offset = 0;
+        int64_t segment_encoded_length = 0;
+        ASSERT_EQ(SAFE16_STATUS_OK, safe16_container_locate_segment(index, index_length, &index_container, i, &segment_offset, &segment_encoded_length));
+        std::vector<uint8_t> segment(segment_length);
+        int64_t segment_decoded_length = safe16l_decode(encoded.data() + segment_offset, segment_encoded_length, segment.data(), segment.size());
+        ASSERT_EQ(std::min(segment_length, length - (int)i * segment_length), segment_decoded_length);
+        decoded.insert(decoded.end(), segment.begin(), segment.begin() + segment_decoded_length);
+    }
+    ASSERT_EQ(data, decoded);
+
+    for(int offset = 0; offset <= length + 1; offset += offset / 4 + 1)
+    {
+        for(int count = 0; count <= length + 1; count += count / 2 + 1)
+        {
+            std::vector<uint8_t> range(count);
+            int64_t expected_count = std::max(0, std::min(count, length - offset));
+            ASSERT_EQ(expected_count, safe16_container_decode_range(encoded.data(), encoded.size(), &container, offset, count, range.data(), range.size()));
+            range.resize(expected_count);
+            ASSERT_EQ(std::vector<uint8_t>(data.begin() + std::min(offset, length), data.begin() + std::min(offset, length) + expected_count), range);
+        }
+    }
+}
+
+#ifdef SAFE16_HAS_CPP17
+void assert_compile_time_matches_runtime(const std::vector<uint8_t>& data)
+{
+    std::string expected_encoded = encode_to_string(data);
+    std::string encoded(safe16::compile_time::get_encoded_length(data.size()), 0);
+    ASSERT_EQ(encoded.size(), safe16::compile_time::encode(data.data(), data.size(), encoded.data()));
+    ASSERT_EQ(expected_encoded, encoded);
+
+    std::vector<uint8_t> expected_encoded_l(safe16_get_encoded_length(data.size(), true));
+    ASSERT_EQ((int64_t)expected_encoded_l.size(), safe16l_encode(data.data(), data.size(), expected_encoded_l.data(), expected_encoded_l.size()));
+    std::string encoded_l(safe16::compile_time::get_encoded_length(data.size(), true), 0);
+    ASSERT_EQ(expected_encoded_l.size(), safe16::compile_time::encode_with_length(data.data(), data.size(), encoded_l.data()));
+    ASSERT_EQ(std::string(expected_encoded_l.begin(), expected_encoded_l.end()), encoded_l);
+
+    std::vector<uint8_t> decoded(data.size());
+    std::string whitespaced = add_whitespace(encoded);
+    ASSERT_EQ((int64_t)data.size(), safe16::compile_time::decode(whitespaced.data(), whitespaced.size(), decoded.data(), decoded.size()));
+    ASSERT_EQ(data, decoded);
+    ASSERT_EQ((int64_t)data.size(), safe16::compile_time::decode_with_length(encoded_l.data(), encoded_l.size(), decoded.data(), decoded.size()));
+    ASSERT_EQ(data, decoded);
+}
+#endif
+
+#ifdef SAFE16_HAS_RANGES
+template <typename R>
+std::string collect_chars(R&& range)
+{
+    std::string result;
+    std::ranges::copy(range, std::back_inserter(result));
+    return result;
+}
+
+template <typename R>
+std::vector<uint8_t> collect_bytes(R&& range)
+{
+    std::vector<uint8_t> result;
+    std::ranges::copy(range, std::back_inserter(result));
+    return result;
+}
+
+void assert_range_encode_decode(int length)
+{
+    std::vector<uint8_t> data = make_bytes(length, length * 11);
+    std::string expected = encode_to_string(data);
+
+    auto encoded = data | safe16::views::encode;
+    static_assert(std::ranges::random_access_range<decltype(encoded)>);
+    ASSERT_EQ(expected.size(), encoded.size());
+    ASSERT_EQ(expected, std::string(encoded.begin(), encoded.end()));
+    for(size_t i = 0; i < expected.size(); i += 7)
+    {
+        ASSERT_EQ(expected[i], encoded[i]);
+        ASSERT_EQ(expected[expected.size() - 1 - i], *(encoded.end() - 1 - i));
+    }
+
+    auto transformed = data | std::views::transform([](uint8_t v) { return v; }) | safe16::views::encode;
+    ASSERT_EQ(expected, std::string(transformed.begin(), transformed.end()));
+    std::list<uint8_t> list_data(data.begin(), data.end());
+    ASSERT_EQ(expected, collect_chars(list_data | safe16::views::encode));
+
+    std::string whitespaced = add_whitespace(expected);
+    ASSERT_EQ(data, collect_bytes(whitespaced | safe16::views::decode));
+    std::list<char> list_encoded(whitespaced.begin(), whitespaced.end());
+    ASSERT_EQ(data, collect_bytes(list_encoded | safe16::views::decode));
+    ASSERT_EQ(data, collect_bytes(data | safe16::views::encode | safe16::views::decode));
+}
+#endif
+
+#ifdef SAFE16_HAS_COROUTINES
+// A coroutine that starts immediately and cleans up after itself.
+struct test_task
+{
+    struct promise_type
+    {
+        test_task get_return_object() { return {}; }
+        std::suspend_never initial_suspend() { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { std::terminate(); }
+    };
+};
+
+// Stands in for an I/O event loop: coroutines yield to it as if waiting on a
+// socket, and get resumed in order.
+class test_executor
+{
+public:
+    auto yield()
+    {
+        struct awaiter
+        {
+            test_executor* executor;
+            bool await_ready() { return false; }
+            void await_suspend(std::coroutine_handle<> handle) { executor->m_queue.push_back(handle); }
+            void await_resume() {}
+        };
+        return awaiter{this};
+    }
+
+    void run()
+    {
+        while(!m_queue.empty())
+        {
+            std::coroutine_handle<> handle = m_queue.front();
+            m_queue.pop_front();
+            handle.resume();
+        }
+    }
+
+private:
+    std::deque<std::coroutine_handle<>> m_queue;
+};
+
+template <typename CODEC, typename DATA>
+test_task produce_async(CODEC& codec, test_executor& executor, const DATA& data, size_t chunk_size, safe16_status& status, bool& is_done)
+{
+    const std::span<const uint8_t> bytes(reinterpret_cast<const uint8_t*>(data.data()), data.size());
+    for(size_t offset = 0; offset < bytes.size(); offset += chunk_size)
+    {
+        co_await executor.yield();
+        status = co_await codec.feed(bytes.subspan(offset, std::min(chunk_size, bytes.size() - offset)));
+    }
+    status = co_await codec.finish();
+    is_done = true;
+}
+
+template <typename CODEC, typename RESULT>
+test_task consume_async(CODEC& codec, test_executor& executor, RESULT& result, bool& is_done)
+{
+    for(auto block = co_await codec.next(); !block.empty(); block = co_await codec.next())
+    {
+        result.insert(result.end(), block.begin(), block.end());
+        co_await executor.yield();
+    }
+    is_done = true;
+}
+
+void assert_async_encode_decode(int length, size_t chunk_size, size_t window_size, bool consumer_first)
+{
+    std::vector<uint8_t> data = make_bytes(length, length);
+    test_executor executor;
+    safe16_status status = SAFE16_STATUS_OK;
+    bool is_producer_done = false;
+    bool is_consumer_done = false;
+
+    safe16::async_encoder encoder(window_size);
+    std::string encoded;
+    if(consumer_first)
+    {
+        consume_async(encoder, executor, encoded, is_consumer_done);
+    }
+    produce_async(encoder, executor, data, chunk_size, status, is_producer_done);
+    if(!consumer_first)
+    {
+        consume_async(encoder, executor, encoded, is_consumer_done);
+    }
+    executor.run();
+    ASSERT_TRUE(is_producer_done);
+    ASSERT_TRUE(is_consumer_done);
+    ASSERT_EQ(SAFE16_STATUS_OK, status);
+    ASSERT_EQ(encode_to_string(data), encoded);
+
+    safe16::async_decoder decoder(window_size);
+    std::string whitespaced = add_whitespace(encoded);
+    std::vector<uint8_t> decoded;
+    is_producer_done = is_consumer_done = false;
+    consume_async(decoder, executor, decoded, is_consumer_done);
+    produce_async(decoder, executor, whitespaced, chunk_size, status, is_producer_done);
+    executor.run();
+    ASSERT_TRUE(is_producer_done);
+    ASSERT_TRUE(is_consumer_done);
+    ASSERT_EQ(SAFE16_STATUS_OK, status);
+    ASSERT_EQ(data, decoded);
+}
+#endif
+
+#ifdef SAFE16_HAS_CPP17
+void assert_streambuf_encode_decode(int length, const safe16_layout& layout, size_t write_size, size_t block_size)
+{
+    std::vector<uint8_t> data = make_bytes(length, length);
+    std::ostringstream out;
+    {
+        safe16::encoding_streambuf encoder(out.rdbuf(), layout, block_size);
+        std::ostream stream(&encoder);
+        for(size_t offset = 0; offset < data.size(); offset += write_size)
+        {
+            stream.write((const char*)data.data() + offset, std::min(write_size, data.size() - offset));
+        }
+        stream.flush();
+    }
+    ASSERT_EQ(apply_layout(encode_to_string(data), layout), out.str());
+
+    std::istringstream in(out.str());
+    safe16::decoding_streambuf decoder(in.rdbuf(), block_size);
+    std::istream stream(&decoder);
+    std::vector<uint8_t> decoded((std::istreambuf_iterator<char>(stream)), std::istreambuf_iterator<char>());
+    ASSERT_EQ(SAFE16_STATUS_OK, decoder.status());
+    ASSERT_EQ(data, decoded);
+}
+#endif
+
+// The built-in alphabet, recovered by encoding a group holding each chunk value.
+std::string get_builtin_alphabet()
+{
+    std::string alphabet;
+    for(int chunk = 0; chunk < g_radix; chunk++)
+    {
+        std::vector<uint8_t> group(g_bytes_per_group, 0);
+        group.back() = (uint8_t)chunk;
+        alphabet += encode_to_string(group).back();
+    }
+    return alphabet;
+}
+
+safe16_alphabet make_alphabet(const std::string& chars, const char* whitespace, const char* substitutions)
+{
+    safe16_alphabet alphabet;
+    EXPECT_EQ(SAFE16_STATUS_OK, safe16_alphabet_init(&alphabet, chars.c_str(), whitespace, substitutions));
+    return alphabet;
+}
+
+std::string alphabet_encode_to_string(const safe16_alphabet& alphabet, const std::vector<uint8_t>& data)
+{
+    std::vector<uint8_t> encode_buffer(safe16_get_encoded_length(data.size(), false));
+    int64_t used_bytes = safe16_alphabet_encode(&alphabet, data.data(), data.size(), encode_buffer.data(), encode_buffer.size());
+    EXPECT_EQ((int64_t)encode_buffer.size(), used_bytes);
+    return std::string(encode_buffer.begin(), encode_buffer.end());
+}
+
+std::vector<uint8_t> alphabet_decode_to_vector(const safe16_alphabet& alphabet, const std::string& encoded)
+{
+    std::vector<uint8_t> decode_buffer(encoded.size());
+    int64_t used_bytes = safe16_alphabet_decode(&alphabet, (const uint8_t*)encoded.data(), encoded.size(), decode_buffer.data(), decode_buffer.size());
+    EXPECT_LE(0, used_bytes);
+    decode_buffer.resize(used_bytes < 0 ? 0 : used_bytes);
+    return decode_buffer;
+}
+
+void assert_checksum_encode_decode(int length)
+{
+    std::vector<uint8_t> data = make_bytes(length, length * 7);
+    uint32_t expected_crc = safe16_crc32c(0, data.data(), data.size());
+    std::string expected_encoded = encode_to_string(data);
+
+    std::vector<uint8_t> encode_buffer(expected_encoded.size());
+    uint32_t crc = 0;
+    int64_t used_bytes = safe16_encode_crc32c(data.data(), data.size(), encode_buffer.data(), encode_buffer.size(), &crc);
+    ASSERT_EQ((int64_t)expected_encoded.size(), used_bytes);
+    ASSERT_EQ(expected_encoded, std::string(encode_buffer.begin(), encode_buffer.end()));
+    ASSERT_EQ(expected_crc, crc);
+
+    for(const std::string& encoded: {expected_encoded, add_whitespace(expected_encoded)})
+    {
+        std::vector<uint8_t> decode_buffer(data.size());
+        crc = 0;
+        used_bytes = safe16_decode_crc32c((const uint8_t*)encoded.data(), encoded.size(), decode_buffer.data(), decode_buffer.size(), &crc);
+        ASSERT_EQ((int64_t)data.size(), used_bytes);
+        ASSERT_EQ(data, decode_buffer);
+        ASSERT_EQ(expected_crc, crc);
+    }
+}
+
+// Feeds the data through the checksummed encoder and then the decoder in
+// packets, with a long run of whitespace in the middle of the encoded data.
+void assert_checksum_feed(int length, int packet_size)
+{
+    std::vector<uint8_t> data = make_bytes(length, length * 3);
+    uint32_t expected_crc = safe16_crc32c(0, data.data(), data.size());
+    std::vector<uint8_t> encode_buffer(safe16_get_encoded_length(length, false));
+
+    const uint8_t* e_src = data.data();
+    const uint8_t* e_src_end = data.data() + data.size();
+    uint8_t* e_dst = encode_buffer.data();
+    uint32_t crc = 0;
+    safe16_status status = SAFE16_STATUS_OK;
+    do
+    {
+        int64_t src_length = std::min<int64_t>(e_src_end - e_src, packet_size);
+        bool is_end = src_length == e_src_end - e_src;
+        status = safe16_encode_feed_crc32c(&e_src, src_length, &e_dst, encode_buffer.data() + encode_buffer.size() - e_dst, is_end, &crc);
+        ASSERT_EQ(SAFE16_STATUS_OK, status);
+    } while(e_src < e_src_end);
+    ASSERT_EQ(encode_to_string(data), std::string(encode_buffer.begin(), encode_buffer.end()));
+    ASSERT_EQ(expected_crc, crc);
+
+    std::string encoded(encode_buffer.begin(), encode_buffer.end());
+    encoded.insert(encoded.size() / 2, std::string(packet_size * 3, ' '));
+    std::vector<uint8_t> decode_buffer(data.size());
+    const uint8_t* d_src = (const uint8_t*)encoded.data();
+    const uint8_t* d_src_end = d_src + encoded.size();
+    const uint8_t* d_packet_end = d_src;
+    uint8_t* d_dst = decode_buffer.data();
+    crc = 0;
+    do
+    {
+        // Unread source data stays in the buffer, and the next packet is added to it.
+        d_packet_end = std::min(d_packet_end + packet_size, d_src_end);
+        safe16_stream_state stream_state = d_packet_end == d_src_end ? SAFE16_SRC_IS_AT_END_OF_STREAM : SAFE16_STREAM_STATE_NONE;
+        status = safe16_decode_feed_crc32c(&d_src, d_packet_end - d_src, &d_dst, decode_buffer.data() + decode_buffer.size() - d_dst, stream_state, &crc);
+        ASSERT_TRUE(status == SAFE16_STATUS_OK || status == SAFE16_STATUS_PARTIALLY_COMPLETE);
+    } while(status == SAFE16_STATUS_PARTIALLY_COMPLETE);
+    ASSERT_EQ(data, decode_buffer);
+    ASSERT_EQ(expected_crc, crc);
+}
+
+std::string get_content_name(const std::vector<uint8_t>& data, int directory_count, int directory_length)
+{
+    std::vector<uint8_t> name(safe16_get_content_name_length(directory_count, directory_length));
+    int64_t used_bytes = safe16_content_name(data.data(), data.size(), directory_count, directory_length, name.data(), name.size());
+    EXPECT_EQ((int64_t)name.size(), used_bytes);
+    return std::string(name.begin(), name.end());
+}
 
+void assert_content_name(const std::string& data, std::vector<uint8_t> expected_hash)
+{
+    ASSERT_EQ(encode_to_string(expected_hash), get_content_name(std::vector<uint8_t>(data.begin(), data.end()), 0, 0));
+}
 
 // --------------------
 // Common Test Patterns
@@ -384,6 +1239,13 @@ TEST(Packetized, decode_dst_packeted)
     assert_chunked_decode_dst_packeted(250);
 }
 
+TEST(Packetized, decode_dst_limited)
+{
+    assert_chunked_decode_dst_limited(102);
+    assert_chunked_decode_dst_limited(20);
+    assert_chunked_decode_dst_limited(250);
+}
+
 TEST_ENCODE_LENGTH(_0, 0, "0")
 TEST_ENCODE_LENGTH(_1, 1, "1")
 TEST_ENCODE_LENGTH(_5, 5, "5")
@@ -460,6 +1322,1503 @@ TEST(Length, invalid)
     ASSERT_EQ(SAFE16_ERROR_INVALID_LENGTH, safe16_encode_feed(&const_decoded_ptr, 1, &encoded_ptr, -1, true));
 }
 
+TEST(Batch, encode_decode)
+{
+    assert_encode_decode_batch({1, 2, 3, 4, 5, 6, 7, 8, 9, 10});
+    assert_encode_decode_batch({0, 100, 0, 31, 1});
+    assert_encode_decode_batch({250});
+    assert_encode_decode_batch({});
+}
+
+TEST(Batch, errors)
+{
+    std::vector<uint8_t> record = make_bytes(20, 1);
+    const uint8_t* src_buffers[] = {record.data(), record.data()};
+    int64_t src_lengths[] = {(int64_t)record.size(), 10};
+    std::vector<uint8_t> dst_buffer(100);
+    int64_t dst_offsets[3];
+    int64_t required_length = safe16_get_encoded_length(20, false) + safe16_get_encoded_length(10, false);
+
+    ASSERT_EQ(SAFE16_ERROR_INVALID_LENGTH, safe16_encode_batch(src_buffers, src_lengths, -1, dst_buffer.data(), dst_buffer.size(), dst_offsets));
+    ASSERT_EQ(SAFE16_ERROR_INVALID_LENGTH, safe16_encode_batch(src_buffers, src_lengths, 2, dst_buffer.data(), -1, dst_offsets));
+    ASSERT_EQ(SAFE16_ERROR_NOT_ENOUGH_ROOM, safe16_encode_batch(src_buffers, src_lengths, 2, dst_buffer.data(), required_length - 1, dst_offsets));
+    ASSERT_EQ(required_length, safe16_encode_batch(src_buffers, src_lengths, 2, dst_buffer.data(), required_length, dst_offsets));
+
+    const uint8_t* encoded_buffers[] = {dst_buffer.data(), dst_buffer.data() + dst_offsets[1]};
+    int64_t encoded_lengths[] = {dst_offsets[1], dst_offsets[2] - dst_offsets[1]};
+    std::vector<uint8_t> decode_buffer(30);
+    ASSERT_EQ(30, safe16_decode_batch(encoded_buffers, encoded_lengths, 2, decode_buffer.data(), decode_buffer.size(), dst_offsets));
+    ASSERT_EQ(SAFE16_ERROR_NOT_ENOUGH_ROOM, safe16_decode_batch(encoded_buffers, encoded_lengths, 2, decode_buffer.data(), 29, dst_offsets));
+
+    src_lengths[1] = -1;
+    ASSERT_EQ(SAFE16_ERROR_INVALID_LENGTH, safe16_encode_batch(src_buffers, src_lengths, 2, dst_buffer.data(), dst_buffer.size(), dst_offsets));
+    encoded_lengths[1] = -1;
+    ASSERT_EQ(SAFE16_ERROR_INVALID_LENGTH, safe16_decode_batch(encoded_buffers, encoded_lengths, 2, decode_buffer.data(), decode_buffer.size(), dst_offsets));
+
+    const uint8_t invalid_data[] = {'"', '"', '"', '"'};
+    const uint8_t* invalid_buffers[] = {invalid_data};
+    int64_t invalid_lengths[] = {sizeof(invalid_data)};
+    ASSERT_EQ(SAFE16_ERROR_INVALID_SOURCE_DATA, safe16_decode_batch(invalid_buffers, invalid_lengths, 1, decode_buffer.data(), decode_buffer.size(), dst_offsets));
+}
+
+TEST(Batch, failure_writes_nothing)
+{
+    std::vector<uint8_t> record = make_bytes(20, 1);
+    const uint8_t* src_buffers[] = {record.data(), record.data(), record.data(), record.data()};
+    int64_t src_lengths[] = {20, 20, -1, 20};
+    std::vector<uint8_t> dst_buffer(200);
+    int64_t dst_offsets[] = {-5, -5, -5, -5, -5};
+
+    ASSERT_EQ(SAFE16_ERROR_INVALID_LENGTH, safe16_encode_batch(src_buffers, src_lengths, 4, dst_buffer.data(), dst_buffer.size(), dst_offsets));
+    ASSERT_EQ(-5, dst_offsets[0]);
+    ASSERT_EQ(-5, dst_offsets[1]);
+
+    // The total encoded length doesn't fit in an int64_t.
+    const int64_t huge_length = INT64_MAX / 4;
+    int64_t huge_lengths[] = {huge_length, huge_length, huge_length, huge_length};
+    ASSERT_EQ(SAFE16_ERROR_NOT_ENOUGH_ROOM, safe16_encode_batch(src_buffers, huge_lengths, 4, dst_buffer.data(), INT64_MAX, dst_offsets));
+    ASSERT_EQ(-5, dst_offsets[0]);
+    ASSERT_EQ(-5, dst_offsets[1]);
+}
+
+TEST(Compare, encoded)
+{
+    std::vector<std::vector<uint8_t>> keys = make_sort_keys(150);
+    for(auto& a: keys)
+    {
+        for(auto& b: keys)
+        {
+            assert_compare_encoded(a, b);
+        }
+    }
+}
+
+TEST(Compare, encoded_long)
+{
+    std::vector<uint8_t> a = make_bytes(1000, 5);
+    std::vector<uint8_t> b = a;
+    assert_compare_encoded(a, b);
+    b[700]++;
+    assert_compare_encoded(a, b);
+    b.resize(999);
+    assert_compare_encoded(a, b);
+}
+
+TEST(Compare, empty_binary)
+{
+    std::string encoded = encode_to_string(make_bytes(10, 1));
+    std::string empty;
+    int result = 0;
+    ASSERT_EQ(SAFE16_STATUS_OK, safe16_compare_encoded_to_binary((uint8_t*)encoded.data(), encoded.size(), NULL, 0, &result));
+    ASSERT_EQ(1, result);
+    ASSERT_EQ(SAFE16_STATUS_OK, safe16_compare_encoded_to_binary((uint8_t*)empty.data(), empty.size(), NULL, 0, &result));
+    ASSERT_EQ(0, result);
+}
+
+TEST(Compare, errors)
+{
+    std::string valid = encode_to_string(make_bytes(10, 1));
+    std::string invalid = valid;
+    invalid[5] = '"';
+    int result = 0;
+    ASSERT_EQ(SAFE16_ERROR_INVALID_SOURCE_DATA, safe16_compare_encoded((uint8_t*)valid.data(), valid.size(), (uint8_t*)invalid.data(), invalid.size(), &result));
+    ASSERT_EQ(SAFE16_ERROR_INVALID_SOURCE_DATA, safe16_compare_encoded((uint8_t*)invalid.data(), invalid.size(), (uint8_t*)invalid.data(), invalid.size(), &result));
+    ASSERT_EQ(SAFE16_ERROR_INVALID_SOURCE_DATA, safe16_compare_encoded_to_binary((uint8_t*)invalid.data(), invalid.size(), (uint8_t*)valid.data(), valid.size(), &result));
+    ASSERT_EQ(SAFE16_ERROR_INVALID_LENGTH, safe16_compare_encoded((uint8_t*)valid.data(), -1, (uint8_t*)valid.data(), valid.size(), &result));
+    ASSERT_EQ(SAFE16_ERROR_INVALID_LENGTH, safe16_compare_encoded_to_binary((uint8_t*)valid.data(), valid.size(), (uint8_t*)valid.data(), -1, &result));
+}
+
+TEST(Compare, sort)
+{
+    std::vector<std::vector<uint8_t>> keys = make_sort_keys(500);
+    std::vector<std::string> encoded_keys;
+    for(auto& key: keys)
+    {
+        encoded_keys.push_back(encode_to_string(key));
+    }
+
+    std::sort(keys.begin(), keys.end());
+    std::sort(encoded_keys.begin(), encoded_keys.end(), safe16::encoded_less());
+
+    for(size_t i = 0; i < keys.size(); i++)
+    {
+        ASSERT_EQ(encode_to_string(keys[i]), encoded_keys[i]);
+    }
+}
+
+TEST(RangeForPrefix, prefixes)
+{
+    for(int length = 0; length <= g_bytes_per_group * 2 + 1; length++)
+    {
+        assert_encoded_range_for_prefix(make_bytes(length, 0x31));
+        assert_encoded_range_for_prefix(std::vector<uint8_t>(length, 0x00));
+        assert_encoded_range_for_prefix(std::vector<uint8_t>(length, 0x01));
+        assert_encoded_range_for_prefix(std::vector<uint8_t>(length, 0xfe));
+        assert_encoded_range_for_prefix(std::vector<uint8_t>(length, 0xff));
+    }
+}
+
+TEST(RangeForPrefix, unbounded)
+{
+    uint8_t lo[100] = {0};
+    uint8_t hi[100] = {0};
+    int64_t lo_length = sizeof(lo);
+    int64_t hi_length = sizeof(hi);
+    ASSERT_EQ(SAFE16_STATUS_OK, safe16_encoded_range_for_prefix(lo, 0, lo, &lo_length, hi, &hi_length));
+    ASSERT_EQ(0, lo_length);
+    ASSERT_EQ(0, hi_length);
+}
+
+TEST(RangeForPrefix, errors)
+{
+    std::vector<uint8_t> prefix = make_bytes(g_bytes_per_group + 1, 1);
+    int64_t required_length = safe16_get_encoded_length(g_bytes_per_group, false) + g_chunks_per_group;
+    std::vector<uint8_t> lo(required_length);
+    std::vector<uint8_t> hi(required_length);
+    int64_t lo_length = required_length - 1;
+    int64_t hi_length = required_length;
+    ASSERT_EQ(SAFE16_ERROR_NOT_ENOUGH_ROOM, safe16_encoded_range_for_prefix(prefix.data(), prefix.size(), lo.data(), &lo_length, hi.data(), &hi_length));
+    lo_length = required_length;
+    hi_length = required_length - 1;
+    ASSERT_EQ(SAFE16_ERROR_NOT_ENOUGH_ROOM, safe16_encoded_range_for_prefix(prefix.data(), prefix.size(), lo.data(), &lo_length, hi.data(), &hi_length));
+    hi_length = required_length;
+    ASSERT_EQ(SAFE16_STATUS_OK, safe16_encoded_range_for_prefix(prefix.data(), prefix.size(), lo.data(), &lo_length, hi.data(), &hi_length));
+    lo_length = -1;
+    ASSERT_EQ(SAFE16_ERROR_INVALID_LENGTH, safe16_encoded_range_for_prefix(prefix.data(), prefix.size(), lo.data(), &lo_length, hi.data(), &hi_length));
+    lo_length = required_length;
+    ASSERT_EQ(SAFE16_ERROR_INVALID_LENGTH, safe16_encoded_range_for_prefix(prefix.data(), -1, lo.data(), &lo_length, hi.data(), &hi_length));
+}
+
+
+
+TEST(Alloc, encode_decode)
+{
+    for(int length = 0; length < 50; length++)
+    {
+        assert_encode_decode_alloc(length);
+    }
+    assert_encode_decode_alloc(500);
+}
+
+TEST(Alloc, errors)
+{
+    std::vector<uint8_t> data = make_bytes(20, 1);
+    std::vector<uint8_t> arena_buffer(100);
+    safe16_arena arena = {arena_buffer.data(), safe16_get_encoded_length(20, false) - 1, 0};
+    uint8_t* result = nullptr;
+    ASSERT_EQ(SAFE16_ERROR_ALLOCATION_FAILED, safe16_encode_alloc(data.data(), data.size(), safe16_arena_allocate, &arena, &result));
+    ASSERT_EQ(0, arena.used);
+    ASSERT_EQ(SAFE16_ERROR_INVALID_LENGTH, safe16_encode_alloc(data.data(), -1, safe16_arena_allocate, &arena, &result));
+
+    std::string encoded = encode_to_string(data);
+    arena.length = 19;
+    ASSERT_EQ(SAFE16_ERROR_ALLOCATION_FAILED, safe16_decode_alloc((const uint8_t*)encoded.data(), encoded.size(), safe16_arena_allocate, &arena, &result));
+    ASSERT_EQ(0, arena.used);
+
+    arena.length = arena_buffer.size();
+    encoded[encoded.size() / 2] = '"';
+    ASSERT_EQ(SAFE16_ERROR_INVALID_SOURCE_DATA, safe16_get_decoded_length_exact((const uint8_t*)encoded.data(), encoded.size()));
+    ASSERT_EQ(SAFE16_ERROR_INVALID_SOURCE_DATA, safe16_decode_alloc((const uint8_t*)encoded.data(), encoded.size(), safe16_arena_allocate, &arena, &result));
+    ASSERT_EQ(0, arena.used);
+
+    uint8_t* with_length = nullptr;
+    int64_t with_length_size = safe16l_encode_alloc(data.data(), data.size(), safe16_arena_allocate, &arena, &with_length);
+    ASSERT_EQ(safe16_get_encoded_length(20, true), with_length_size);
+    int64_t used = arena.used;
+    ASSERT_EQ(SAFE16_ERROR_TRUNCATED_DATA, safe16l_decode_alloc(with_length, with_length_size - 1, safe16_arena_allocate, &arena, &result));
+    ASSERT_EQ(used, arena.used);
+
+    ASSERT_EQ(0, safe16_decode_alloc(with_length, 0, safe16_arena_allocate, &arena, &result));
+    ASSERT_EQ(nullptr, result);
+}
+
+#ifdef SAFE16_HAS_PMR
+TEST(Alloc, pmr)
+{
+    std::vector<uint8_t> data = make_bytes(100, 1);
+    uint8_t backing[1000];
+    std::pmr::monotonic_buffer_resource resource(backing, sizeof(backing), std::pmr::null_memory_resource());
+
+    std::pmr::string encoded(&resource);
+    ASSERT_EQ(safe16_get_encoded_length(data.size(), false), safe16::encode(data.data(), data.size(), encoded));
+    ASSERT_EQ(encode_to_string(data), std::string(encoded.begin(), encoded.end()));
+
+    std::pmr::vector<uint8_t> decoded(&resource);
+    ASSERT_EQ((int64_t)data.size(), safe16::decode((const uint8_t*)encoded.data(), encoded.size(), decoded));
+    ASSERT_EQ(data, std::vector<uint8_t>(decoded.begin(), decoded.end()));
+
+    ASSERT_EQ(safe16_get_encoded_length(data.size(), true), safe16::encode_with_length(data.data(), data.size(), encoded));
+    ASSERT_EQ((int64_t)data.size(), safe16::decode_with_length((const uint8_t*)encoded.data(), encoded.size(), decoded));
+    ASSERT_EQ(data, std::vector<uint8_t>(decoded.begin(), decoded.end()));
+
+    encoded[0] = '"';
+    ASSERT_EQ(SAFE16_ERROR_INVALID_SOURCE_DATA, safe16::decode((const uint8_t*)encoded.data(), encoded.size(), decoded));
+    ASSERT_TRUE(decoded.empty());
+}
+#endif
+
+TEST(Packetized, decode_with_length)
+{
+    assert_chunked_decode_with_length(0);
+    assert_chunked_decode_with_length(1);
+    assert_chunked_decode_with_length(102);
+    assert_chunked_decode_with_length(250);
+}
+
+TEST(Packetized, decode_with_length_errors)
+{
+    std::vector<uint8_t> data = make_bytes(100, 1);
+    std::vector<uint8_t> encoded(safe16_get_encoded_length(data.size(), true));
+    ASSERT_EQ((int64_t)encoded.size(), safe16l_encode(data.data(), data.size(), encoded.data(), encoded.size()));
+    int64_t length_field_length = safe16_write_length_field(data.size(), encoded.data(), encoded.size());
+    ASSERT_GT(length_field_length, 1);
+    std::vector<uint8_t> decoded(data.size());
+
+    safe16l_decoder decoder;
+    safe16l_decoder_init(&decoder);
+    const uint8_t* src = encoded.data();
+    uint8_t* dst = decoded.data();
+    ASSERT_EQ(SAFE16_STATUS_PARTIALLY_COMPLETE, safe16l_decode_feed(&decoder, &src, 1, &dst, decoded.size(), false));
+    ASSERT_EQ(-1, decoder.declared_length);
+    ASSERT_EQ(SAFE16_STATUS_PARTIALLY_COMPLETE, safe16l_decode_feed(&decoder, &src, encoded.size() - 1, &dst, 0, false));
+    ASSERT_EQ((int64_t)data.size(), decoder.declared_length);
+    ASSERT_EQ(encoded.data() + length_field_length, src);
+    ASSERT_EQ(decoded.data(), dst);
+    ASSERT_EQ(SAFE16_ERROR_TRUNCATED_DATA, safe16l_decode_feed(&decoder, &src, encoded.data() + encoded.size() - 1 - src, &dst, decoded.size(), true));
+
+    safe16l_decoder_init(&decoder);
+    src = encoded.data();
+    ASSERT_EQ(SAFE16_ERROR_UNTERMINATED_LENGTH_FIELD, safe16l_decode_feed(&decoder, &src, 1, &dst, decoded.size(), true));
+
+    safe16l_decoder_init(&decoder);
+    const uint8_t invalid_data[] = {'"'};
+    src = invalid_data;
+    ASSERT_EQ(SAFE16_ERROR_INVALID_SOURCE_DATA, safe16l_decode_feed(&decoder, &src, 1, &dst, decoded.size(), true));
+    ASSERT_EQ(SAFE16_ERROR_INVALID_LENGTH, safe16l_decode_feed(&decoder, &src, -1, &dst, decoded.size(), true));
+}
+
+TEST(Packetized, encode_with_length)
+{
+    assert_chunked_encode_with_length(0);
+    assert_chunked_encode_with_length(1);
+    assert_chunked_encode_with_length(102);
+    assert_chunked_encode_with_length(250);
+}
+
+TEST(Packetized, encode_with_length_errors)
+{
+    std::vector<uint8_t> data = make_bytes(100, 1);
+    std::vector<uint8_t> encoded(safe16_get_encoded_length(data.size(), true));
+    safe16l_encoder encoder;
+    ASSERT_EQ(SAFE16_ERROR_INVALID_LENGTH, safe16l_encoder_init(&encoder, -1));
+
+    ASSERT_EQ(SAFE16_STATUS_OK, safe16l_encoder_init(&encoder, data.size() - 1));
+    const uint8_t* src = data.data();
+    uint8_t* dst = encoded.data();
+    ASSERT_EQ(SAFE16_ERROR_TOO_MUCH_DATA, safe16l_encode_feed(&encoder, &src, data.size(), &dst, encoded.size(), false));
+    ASSERT_EQ(data.data(), src);
+    ASSERT_EQ(encoded.data(), dst);
+
+    ASSERT_EQ(SAFE16_STATUS_OK, safe16l_encoder_init(&encoder, data.size() + 1));
+    ASSERT_EQ(SAFE16_STATUS_PARTIALLY_COMPLETE, safe16l_encode_feed(&encoder, &src, 10, &dst, encoded.size(), false));
+    ASSERT_EQ(SAFE16_ERROR_TRUNCATED_DATA, safe16l_encode_feed(&encoder, &src, data.data() + data.size() - src, &dst, encoded.size(), true));
+
+    ASSERT_EQ(SAFE16_STATUS_OK, safe16l_encoder_init(&encoder, data.size()));
+    src = data.data();
+    dst = encoded.data();
+    ASSERT_EQ(SAFE16_ERROR_NOT_ENOUGH_ROOM, safe16l_encode_feed(&encoder, &src, data.size(), &dst, 0, true));
+    ASSERT_EQ(SAFE16_ERROR_INVALID_LENGTH, safe16l_encode_feed(&encoder, &src, -1, &dst, encoded.size(), true));
+    ASSERT_EQ(SAFE16_STATUS_OK, safe16l_encode_feed(&encoder, &src, data.size(), &dst, encoded.size(), true));
+    ASSERT_EQ(encoded.data() + encoded.size(), dst);
+}
+
+TEST(IndexRecords, records)
+{
+    assert_index_records({1, 2, 3, 4, 5, 6, 7, 8, 9, 10}, false);
+    assert_index_records({0, 100, 0, 31, 1, 1000}, false);
+    assert_index_records({}, false);
+    assert_index_records({1, 2, 3, 4, 5, 6, 7, 8, 9, 10}, true);
+    assert_index_records({0, 100, 0, 31, 1, 1000}, true);
+    assert_index_records({}, true);
+}
+
+TEST(IndexRecords, errors)
+{
+    std::vector<uint8_t> data = make_bytes(100, 1);
+    std::vector<uint8_t> encoded(safe16_get_encoded_length(data.size(), true) * 2);
+    int64_t record_length = safe16l_encode(data.data(), data.size(), encoded.data(), encoded.size());
+    ASSERT_GT(record_length, 0);
+    ASSERT_EQ(record_length, safe16l_encode(data.data(), data.size(), encoded.data() + record_length, record_length));
+    safe16l_record_span spans[2];
+
+    ASSERT_EQ(record_length, safe16l_scan_record(encoded.data(), encoded.size(), false, spans));
+    ASSERT_EQ(SAFE16_ERROR_NOT_ENOUGH_ROOM, safe16l_index_records(encoded.data(), encoded.size(), false, spans, 1));
+    ASSERT_EQ(SAFE16_ERROR_TRUNCATED_DATA, safe16l_index_records(encoded.data(), encoded.size() - 1, false, spans, 2));
+    ASSERT_EQ(SAFE16_ERROR_TRUNCATED_DATA, safe16l_index_records(encoded.data(), encoded.size() - 1, true, spans, 2));
+    ASSERT_EQ(SAFE16_ERROR_UNTERMINATED_LENGTH_FIELD, safe16l_scan_record(encoded.data(), 0, false, spans));
+    ASSERT_EQ(SAFE16_ERROR_INVALID_LENGTH, safe16l_index_records(encoded.data(), -1, false, spans, 2));
+    ASSERT_EQ(SAFE16_ERROR_INVALID_LENGTH, safe16l_index_records(encoded.data(), encoded.size(), false, spans, -1));
+
+    encoded[record_length / 2] = '"';
+    ASSERT_EQ(record_length, safe16l_scan_record(encoded.data(), encoded.size(), false, spans));
+    ASSERT_EQ(SAFE16_ERROR_INVALID_SOURCE_DATA, safe16l_scan_record(encoded.data(), encoded.size(), true, spans));
+}
+
+TEST(DecodeRange, no_whitespace)
+{
+    assert_decode_range(0, NULL);
+    assert_decode_range(1, NULL);
+    assert_decode_range(100, NULL);
+    assert_decode_range(1001, NULL);
+}
+
+TEST(DecodeRange, layout)
+{
+    const safe16_layout layouts[] =
+    {
+        {0, 0, false},
+        {0, 4, false},
+        {1, 0, false},
+        {76, 0, false},
+        {64, 4, true},
+        {17, 3, false},
+    };
+    for(const safe16_layout& layout: layouts)
+    {
+        assert_decode_range(0, &layout);
+        assert_decode_range(100, &layout);
+        assert_decode_range(1001, &layout);
+    }
+}
+
+TEST(DecodeRange, errors)
+{
+    std::vector<uint8_t> data = make_bytes(100, 1);
+    std::string encoded = encode_to_string(data);
+    const uint8_t* src = (const uint8_t*)encoded.data();
+    std::vector<uint8_t> decoded(10);
+    const safe16_layout bad_layout = {-1, 0, false};
+    ASSERT_EQ(SAFE16_ERROR_NOT_ENOUGH_ROOM, safe16_decode_range(src, encoded.size(), 0, 11, decoded.data(), decoded.size(), NULL));
+    ASSERT_EQ(SAFE16_ERROR_INVALID_LENGTH, safe16_decode_range(src, encoded.size(), -1, 10, decoded.data(), decoded.size(), NULL));
+    ASSERT_EQ(SAFE16_ERROR_INVALID_LENGTH, safe16_decode_range(src, encoded.size(), 0, -1, decoded.data(), decoded.size(), NULL));
+    ASSERT_EQ(SAFE16_ERROR_INVALID_LENGTH, safe16_decode_range(src, encoded.size(), 0, 10, decoded.data(), decoded.size(), &bad_layout));
+    encoded[encoded.size() / 2] = '"';
+    ASSERT_EQ(10, safe16_decode_range(src, encoded.size(), 0, 10, decoded.data(), decoded.size(), NULL));
+    ASSERT_EQ(SAFE16_ERROR_INVALID_SOURCE_DATA, safe16_decode_range(src, encoded.size(), 45, 10, decoded.data(), decoded.size(), NULL));
+}
+
+TEST(Container, encode_decode)
+{
+    assert_container(0, 1, NULL);
+    assert_container(1, 1, NULL);
+    assert_container(100, 1, NULL);
+    assert_container(100, 7, NULL);
+    assert_container(100, 100, NULL);
+    assert_container(1000, 64, NULL);
+    assert_container(1000, 1000000, NULL);
+}
+
+TEST(Container, layout)
+{
+    const safe16_layout layouts[] =
+    {
+        {0, 3, false},
+        {1, 0, false},
+        {7, 2, true},
+        {76, 4, false},
+    };
+    for(const safe16_layout& layout: layouts)
+    {
+        assert_container(0, 1, &layout);
+        assert_container(100, 7, &layout);
+        assert_container(1000, 64, &layout);
+    }
+}
+
+static std::string write_container_in_pieces(const std::vector<uint8_t>& data, int64_t segment_length, const safe16_layout* layout, size_t dst_window)
+{
+    std::string result;
+    safe16_container_writer writer;
+    EXPECT_EQ(SAFE16_STATUS_OK, safe16_container_writer_init(&writer, segment_length, layout));
+    // The source buffer only has room for one segment at a time.
+    std::vector<uint8_t> dst_buffer(dst_window);
+    size_t offset = 0;
+    safe16_status status = SAFE16_STATUS_PARTIALLY_COMPLETE;
+    for(int i = 0; i < 1000000 && status == SAFE16_STATUS_PARTIALLY_COMPLETE; i++)
+    {
+        const size_t src_length = std::min((size_t)segment_length, data.size() - offset);
+        const uint8_t* src = data.data() + offset;
+        uint8_t* dst = dst_buffer.data();
+        status = safe16_container_writer_feed(&writer, &src, src_length, &dst, dst_buffer.size(), offset + src_length == data.size());
+        EXPECT_TRUE(status == SAFE16_STATUS_OK || status == SAFE16_STATUS_PARTIALLY_COMPLETE);
+        offset = src - data.data();
+        result.append(dst_buffer.data(), dst);
+    }
+    EXPECT_EQ(SAFE16_STATUS_OK, status);
+    return result;
+}
+
+TEST(Container, writer)
+{
+    const safe16_layout layout = {7, 2, true};
+    for(const safe16_layout* layout_ptr: {(const safe16_layout*)NULL, &layout})
+    {
+        for(int length: {0, 1, 100, 1000})
+        {
+            for(int segment_length: {1, 7, 64})
+            {
+                std::vector<uint8_t> data = make_bytes(length, 4);
+                std::string expected(safe16_container_get_encoded_length(length, segment_length, layout_ptr), 0);
+                ASSERT_EQ((int64_t)expected.size(), safe16_container_encode(data.data(), data.size(), segment_length, (uint8_t*)&expected[0], expected.size(), layout_ptr));
+                for(size_t dst_window: {1, 7, 100})
+                {
+                    ASSERT_EQ(expected, write_container_in_pieces(data, segment_length, layout_ptr, dst_window));
+                }
+            }
+        }
+    }
+
+    safe16_container_writer writer;
+    const safe16_layout bad_layout = {-1, 0, false};
+    ASSERT_EQ(SAFE16_ERROR_INVALID_LENGTH, safe16_container_writer_init(&writer, 0, NULL));
+    ASSERT_EQ(SAFE16_ERROR_INVALID_LENGTH, safe16_container_writer_init(&writer, 10, &bad_layout));
+}
+
+TEST(Container, errors)
+{
+    std::vector<uint8_t> data = make_bytes(100, 1);
+    const safe16_layout bad_layout = {-1, 0, false};
+    int64_t encoded_length = safe16_container_get_encoded_length(data.size(), 10, NULL);
+    std::vector<uint8_t> encoded(encoded_length);
+    ASSERT_EQ(SAFE16_ERROR_INVALID_LENGTH, safe16_container_get_encoded_length(data.size(), 0, NULL));
+    ASSERT_EQ(SAFE16_ERROR_INVALID_LENGTH, safe16_container_get_encoded_length(-1, 10, NULL));
+    ASSERT_EQ(SAFE16_ERROR_INVALID_LENGTH, safe16_container_get_encoded_length(data.size(), 10, &bad_layout));
+    ASSERT_EQ(SAFE16_ERROR_INVALID_LENGTH, safe16_container_encode(data.data(), data.size(), 0, encoded.data(), encoded.size(), NULL));
+    ASSERT_EQ(SAFE16_ERROR_NOT_ENOUGH_ROOM, safe16_container_encode(data.data(), data.size(), 10, encoded.data(), encoded.size() - 1, NULL));
+    ASSERT_EQ(encoded_length, safe16_container_encode(data.data(), data.size(), 10, encoded.data(), encoded.size(), NULL));
+
+    safe16_container container;
+    ASSERT_EQ(SAFE16_ERROR_TRUNCATED_DATA, safe16_container_open(encoded.data(), 2, &container));
+    ASSERT_EQ(SAFE16_ERROR_INVALID_SOURCE_DATA, safe16_container_open(encoded.data(), encoded.size() - 1, &container));
+    ASSERT_EQ(SAFE16_ERROR_INVALID_LENGTH, safe16_container_open(encoded.data(), -1, &container));
+    ASSERT_EQ(SAFE16_STATUS_OK, safe16_container_open(encoded.data(), encoded.size(), &container));
+
+    int64_t trailer_offset = 0;
+    int64_t offset = 0;
+    int64_t length = 0;
+    ASSERT_EQ(SAFE16_ERROR_TRUNCATED_DATA, safe16_container_find_index(encoded.data() + encoded.size() - 2, 2, encoded.size(), &trailer_offset));
+    ASSERT_EQ(SAFE16_ERROR_INVALID_LENGTH, safe16_container_find_index(encoded.data(), encoded.size(), encoded.size() - 1, &trailer_offset));
+    ASSERT_EQ(SAFE16_ERROR_INVALID_LENGTH, safe16_container_open_index(encoded.data(), -1, 0, &container));
+    ASSERT_EQ(SAFE16_ERROR_INVALID_LENGTH, safe16_container_locate_segment(encoded.data() + container.index_offset, encoded.size(), &container, 10, &offset, &length));
+    ASSERT_EQ(SAFE16_ERROR_TRUNCATED_DATA, safe16_container_locate_segment(encoded.data() + container.index_offset, 1, &container, 0, &offset, &length));
+    ASSERT_EQ(SAFE16_ERROR_INVALID_LENGTH, safe16_locate_range(-1, 10, NULL, &offset, &length, &trailer_offset));
+
+    std::vector<uint8_t> decoded(10);
+    ASSERT_EQ(SAFE16_ERROR_INVALID_LENGTH, safe16_container_decode_segment(encoded.data(), encoded.size(), &container, 10, decoded.data(), decoded.size()));
+    ASSERT_EQ(SAFE16_ERROR_INVALID_LENGTH, safe16_container_decode_segment(encoded.data(), encoded.size(), &container, -1, decoded.data(), decoded.size()));
+    ASSERT_EQ(SAFE16_ERROR_NOT_ENOUGH_ROOM, safe16_container_decode_segment(encoded.data(), encoded.size(), &container, 0, decoded.data(), 9));
+    ASSERT_EQ(SAFE16_ERROR_NOT_ENOUGH_ROOM, safe16_container_decode_range(encoded.data(), encoded.size(), &container, 0, 10, decoded.data(), 9));
+    ASSERT_EQ(SAFE16_ERROR_INVALID_LENGTH, safe16_container_decode_range(encoded.data(), encoded.size(), &container, -1, 10, decoded.data(), decoded.size()));
+
+    int64_t segment_1_offset = safe16_get_encoded_length(10, true);
+    encoded[segment_1_offset + 3] = '"';
+    ASSERT_EQ(10, safe16_container_decode_segment(encoded.data(), encoded.size(), &container, 0, decoded.data(), decoded.size()));
+    ASSERT_EQ(SAFE16_ERROR_INVALID_SOURCE_DATA, safe16_container_decode_segment(encoded.data(), encoded.size(), &container, 1, decoded.data(), decoded.size()));
+    ASSERT_EQ(SAFE16_ERROR_INVALID_SOURCE_DATA, safe16_container_decode_range(encoded.data(), encoded.size(), &container, 5, 10, decoded.data(), decoded.size()));
+}
+
+
+#ifdef SAFE16_HAS_CPP17
+TEST(Cpp, encode_decode)
+{
+    std::vector<uint8_t> data = make_bytes(100, 1);
+    std::string_view data_view(reinterpret_cast<const char*>(data.data()), data.size());
+    std::string expected_encoded = encode_to_string(data);
+
+    char encoded_buffer[200];
+    safe16::result<size_t> encoded_length = safe16::encode(data_view, encoded_buffer, sizeof(encoded_buffer));
+    ASSERT_TRUE(encoded_length);
+    ASSERT_EQ(expected_encoded, std::string(encoded_buffer, *encoded_length));
+
+    uint8_t decoded_buffer[100];
+    safe16::result<size_t> decoded_length = safe16::decode(expected_encoded, decoded_buffer, sizeof(decoded_buffer));
+    ASSERT_TRUE(decoded_length);
+    ASSERT_EQ(data, std::vector<uint8_t>(decoded_buffer, decoded_buffer + *decoded_length));
+
+    safe16::result<std::string> encoded = safe16::encode(data_view);
+    ASSERT_TRUE(encoded);
+    ASSERT_EQ(expected_encoded, *encoded);
+
+    safe16::result<std::vector<uint8_t>> decoded = safe16::decode<std::vector<uint8_t>>(*encoded);
+    ASSERT_TRUE(decoded);
+    ASSERT_EQ(data, *decoded);
+
+    encoded = safe16::encode_with_length(data_view);
+    ASSERT_TRUE(encoded);
+    ASSERT_EQ(safe16_get_encoded_length(data.size(), true), (int64_t)encoded->size());
+    safe16::result<std::string> decoded_string = safe16::decode_with_length(*encoded);
+    ASSERT_TRUE(decoded_string);
+    ASSERT_EQ(data_view, *decoded_string);
+
+#ifdef SAFE16_HAS_SPAN
+    encoded_length = safe16::encode(std::span<const uint8_t>(data), std::span<char>(encoded_buffer));
+    ASSERT_TRUE(encoded_length);
+    ASSERT_EQ(expected_encoded, std::string(encoded_buffer, *encoded_length));
+    decoded_length = safe16::decode(expected_encoded, std::span<uint8_t>(decoded_buffer));
+    ASSERT_TRUE(decoded_length);
+    ASSERT_EQ(data.size(), *decoded_length);
+    ASSERT_EQ(expected_encoded, safe16::encode(data).value());
+#endif
+}
+
+TEST(Cpp, errors)
+{
+    std::string_view data = "some data";
+    char encoded_buffer[5];
+    safe16::result<size_t> length = safe16::encode(data, encoded_buffer, sizeof(encoded_buffer));
+    ASSERT_FALSE(length);
+    ASSERT_EQ(SAFE16_ERROR_NOT_ENOUGH_ROOM, length.error());
+    ASSERT_EQ(0u, length.value_or(0));
+
+    uint8_t decoded_buffer[10];
+    length = safe16::decode("\"", decoded_buffer, sizeof(decoded_buffer));
+    ASSERT_EQ(SAFE16_ERROR_INVALID_SOURCE_DATA, length.error());
+
+    safe16::result<std::string> decoded = safe16::decode("\"");
+    ASSERT_FALSE(decoded.has_value());
+    ASSERT_EQ(SAFE16_ERROR_INVALID_SOURCE_DATA, decoded.error());
+
+    std::string encoded = *safe16::encode_with_length(data);
+    decoded = safe16::decode_with_length(std::string_view(encoded).substr(0, encoded.size() - 2));
+    ASSERT_FALSE(decoded.has_value());
+}
+#endif
+
+#ifdef SAFE16_HAS_CPP17
+TEST(CompileTime, literals)
+{
+    constexpr auto encoded = safe16::encode_literal<0x39, 0x12, 0x82, 0xe1, 0x81>();
+    static_assert(encoded.size() == safe16::compile_time::get_encoded_length(5));
+    constexpr auto decoded = safe16::decode_literal(encoded.chars);
+    static_assert(decoded.size() == 5 && decoded[0] == 0x39 && decoded[4] == 0x81);
+    ASSERT_EQ(encode_to_string({0x39, 0x12, 0x82, 0xe1, 0x81}), std::string_view(encoded));
+
+    constexpr auto encoded_l = safe16::encode_literal_with_length<0x39, 0x12, 0x82, 0xe1, 0x81>();
+    static_assert(encoded_l.size() == safe16::compile_time::get_encoded_length(5, true));
+    std::vector<uint8_t> decoded_l(5);
+    ASSERT_EQ(5, safe16l_decode((const uint8_t*)encoded_l.data(), encoded_l.size(), decoded_l.data(), decoded_l.size()));
+    ASSERT_EQ(std::vector<uint8_t>(decoded.begin(), decoded.end()), decoded_l);
+
+    constexpr auto text = safe16::encode_literal("prefix");
+    ASSERT_EQ(encode_to_string({'p', 'r', 'e', 'f', 'i', 'x'}), std::string(text.c_str()));
+
+#if defined(__cpp_nontype_template_args) && __cpp_nontype_template_args >= 201911L
+    using namespace safe16::literals;
+    constexpr auto from_udl = "0000"_safe16;
+    std::vector<uint8_t> expected(from_udl.size());
+    ASSERT_EQ((int64_t)expected.size(), safe16_decode((const uint8_t*)"0000", 4, expected.data(), expected.size()));
+    ASSERT_EQ(expected, std::vector<uint8_t>(from_udl.begin(), from_udl.end()));
+#endif
+}
+
+TEST(CompileTime, matches_runtime)
+{
+    for(int length = 0; length < 100; length++)
+    {
+        assert_compile_time_matches_runtime(make_bytes(length, length * 37));
+        assert_compile_time_matches_runtime(std::vector<uint8_t>(length, 0xff));
+    }
+}
+
+TEST(CompileTime, errors)
+{
+    uint8_t decoded[20] = {};
+    ASSERT_EQ(SAFE16_ERROR_INVALID_SOURCE_DATA, safe16::compile_time::decode("00\"0", 4, decoded, sizeof(decoded)));
+    ASSERT_EQ(SAFE16_ERROR_NOT_ENOUGH_ROOM, safe16::compile_time::decode("0000000000", 10, decoded, 1));
+
+    std::vector<uint8_t> data = make_bytes(10, 1);
+    std::string encoded(safe16::compile_time::get_encoded_length(data.size(), true), 0);
+    safe16::compile_time::encode_with_length(data.data(), data.size(), encoded.data());
+    ASSERT_EQ(SAFE16_ERROR_TRUNCATED_DATA, safe16::compile_time::decode_with_length(encoded.data(), encoded.size() - 2, decoded, sizeof(decoded)));
+    ASSERT_EQ(SAFE16_ERROR_UNTERMINATED_LENGTH_FIELD, safe16::compile_time::decode_with_length(encoded.data(), 0, decoded, sizeof(decoded)));
+}
+#endif
+
+#ifdef SAFE16_HAS_RANGES
+TEST(Ranges, encode_decode)
+{
+    for(int length = 0; length < 300; length++)
+    {
+        assert_range_encode_decode(length);
+    }
+}
+
+TEST(Ranges, composition)
+{
+    std::vector<uint8_t> data = make_bytes(50, 1);
+    std::string expected = encode_to_string(data);
+    ASSERT_EQ(expected.substr(0, 10), collect_chars(data | safe16::views::encode | std::views::take(10)));
+    ASSERT_EQ(expected.substr(5), collect_chars(data | safe16::views::encode | std::views::drop(5)));
+}
+
+TEST(Ranges, invalid_data)
+{
+    std::vector<uint8_t> data = make_bytes(g_bytes_per_group * 40, 1);
+    std::string encoded = encode_to_string(data);
+    const int bad_group = 10;
+    encoded[bad_group * g_chunks_per_group + 1] = '"';
+    std::vector<uint8_t> expected(data.begin(), data.begin() + bad_group * g_bytes_per_group);
+
+    auto decoded = encoded | safe16::views::decode;
+    ASSERT_EQ(expected, collect_bytes(decoded));
+    ASSERT_EQ(SAFE16_ERROR_INVALID_SOURCE_DATA, decoded.status());
+
+    std::list<char> list_encoded(encoded.begin(), encoded.end());
+    auto list_decoded = list_encoded | safe16::views::decode;
+    ASSERT_EQ(expected, collect_bytes(list_decoded));
+    ASSERT_EQ(SAFE16_ERROR_INVALID_SOURCE_DATA, list_decoded.status());
+}
+#endif
+
+#ifdef SAFE16_HAS_COROUTINES
+TEST(Async, encode_decode)
+{
+    for(int length : {0, 1, 2, 50, 1000, 5000})
+    {
+        for(size_t chunk_size : {1, 7, 100, 10000})
+        {
+            for(size_t window_size : {1, 50, 65536})
+            {
+                assert_async_encode_decode(length, chunk_size, window_size, true);
+                assert_async_encode_decode(length, chunk_size, window_size, false);
+            }
+        }
+    }
+}
+
+TEST(Async, invalid_data)
+{
+    std::vector<uint8_t> data = make_bytes(g_bytes_per_group * 40, 1);
+    std::string encoded = encode_to_string(data);
+    const int bad_group = 10;
+    encoded[bad_group * g_chunks_per_group + 1] = '"';
+
+    test_executor executor;
+    safe16::async_decoder decoder(64);
+    std::vector<uint8_t> decoded;
+    safe16_status status = SAFE16_STATUS_OK;
+    bool is_producer_done = false;
+    bool is_consumer_done = false;
+    consume_async(decoder, executor, decoded, is_consumer_done);
+    produce_async(decoder, executor, encoded, 13, status, is_producer_done);
+    executor.run();
+    ASSERT_TRUE(is_producer_done);
+    ASSERT_TRUE(is_consumer_done);
+    ASSERT_EQ(SAFE16_ERROR_INVALID_SOURCE_DATA, status);
+    ASSERT_EQ(SAFE16_ERROR_INVALID_SOURCE_DATA, decoder.status());
+    ASSERT_EQ(std::vector<uint8_t>(data.begin(), data.begin() + bad_group * g_bytes_per_group), decoded);
+}
+#endif
+
+#ifdef SAFE16_HAS_CPP17
+TEST(Streambuf, encode_decode)
+{
+    const safe16_layout layouts[] = {{0, 0, false}, {0, 3, false}, {10, 0, false}, {76, 2, false}, {7, 3, true}};
+    for(int length : {0, 1, 2, 100, 5000})
+    {
+        for(const safe16_layout& layout : layouts)
+        {
+            for(size_t write_size : {1, 13, 10000})
+            {
+                assert_streambuf_encode_decode(length, layout, write_size, 100);
+                assert_streambuf_encode_decode(length, layout, write_size, 65536);
+            }
+        }
+    }
+}
+
+TEST(Streambuf, invalid_data)
+{
+    std::vector<uint8_t> data = make_bytes(g_bytes_per_group * 40, 1);
+    std::string encoded = encode_to_string(data);
+    const int bad_group = 10;
+    encoded[bad_group * g_chunks_per_group + 1] = '"';
+
+    std::istringstream in(encoded);
+    safe16::decoding_streambuf decoder(in.rdbuf(), 16);
+    std::istream stream(&decoder);
+    std::vector<uint8_t> decoded((std::istreambuf_iterator<char>(stream)), std::istreambuf_iterator<char>());
+    ASSERT_EQ(SAFE16_ERROR_INVALID_SOURCE_DATA, decoder.status());
+    ASSERT_EQ(std::vector<uint8_t>(data.begin(), data.begin() + bad_group * g_bytes_per_group), decoded);
+}
+#endif
+
+TEST(Alphabet, builtin)
+{
+    safe16_alphabet alphabet = make_alphabet(get_builtin_alphabet(), "\t\n\r ", NULL);
+    for(int length = 0; length < g_bytes_per_group * 20; length++)
+    {
+        std::vector<uint8_t> data = make_bytes(length, length * 13);
+        std::string encoded = alphabet_encode_to_string(alphabet, data);
+        ASSERT_EQ(encode_to_string(data), encoded);
+        ASSERT_EQ(data, alphabet_decode_to_vector(alphabet, encoded));
+        ASSERT_EQ(data, alphabet_decode_to_vector(alphabet, add_whitespace(encoded)));
+    }
+}
+
+TEST(Alphabet, reordered)
+{
+    std::string builtin = get_builtin_alphabet();
+    std::string reversed(builtin.rbegin(), builtin.rend());
+    std::string substitutions = std::string("\"") + reversed[0];
+    safe16_alphabet alphabet = make_alphabet(reversed, " ", substitutions.c_str());
+
+    std::vector<uint8_t> data = make_bytes(g_bytes_per_group * 40 + 1, 1);
+    std::string encoded = alphabet_encode_to_string(alphabet, data);
+    std::string translated = encoded;
+    for(char& ch: translated)
+    {
+        ch = builtin[g_radix - 1 - builtin.find(ch)];
+    }
+    ASSERT_EQ(encode_to_string(data), translated);
+    ASSERT_EQ(data, alphabet_decode_to_vector(alphabet, encoded));
+
+    std::string substituted = encoded;
+    std::replace(substituted.begin(), substituted.end(), reversed[0], '"');
+    ASSERT_EQ(data, alphabet_decode_to_vector(alphabet, substituted));
+
+    std::string invalid = encoded;
+    invalid[10] = '\n';
+    int64_t result = safe16_alphabet_decode(&alphabet, (const uint8_t*)invalid.data(), invalid.size(), data.data(), data.size());
+    ASSERT_EQ(SAFE16_ERROR_INVALID_SOURCE_DATA, result);
+
+    std::vector<uint8_t> encode_buffer(encoded.size() - 1);
+    result = safe16_alphabet_encode(&alphabet, data.data(), data.size(), encode_buffer.data(), encode_buffer.size());
+    ASSERT_EQ(SAFE16_ERROR_NOT_ENOUGH_ROOM, result);
+}
+
+TEST(Alphabet, invalid)
+{
+    std::string builtin = get_builtin_alphabet();
+    std::string extra_char = std::string("\"");
+    std::string duplicated = builtin;
+    duplicated[1] = duplicated[0];
+    safe16_alphabet alphabet;
+
+    ASSERT_EQ(SAFE16_ERROR_INVALID_ALPHABET, safe16_alphabet_init(&alphabet, builtin.substr(1).c_str(), NULL, NULL));
+    ASSERT_EQ(SAFE16_ERROR_INVALID_ALPHABET, safe16_alphabet_init(&alphabet, (builtin + extra_char).c_str(), NULL, NULL));
+    ASSERT_EQ(SAFE16_ERROR_INVALID_ALPHABET, safe16_alphabet_init(&alphabet, duplicated.c_str(), NULL, NULL));
+    ASSERT_EQ(SAFE16_ERROR_INVALID_ALPHABET, safe16_alphabet_init(&alphabet, builtin.c_str(), builtin.substr(5, 1).c_str(), NULL));
+    ASSERT_EQ(SAFE16_ERROR_INVALID_ALPHABET, safe16_alphabet_init(&alphabet, builtin.c_str(), "  ", NULL));
+    ASSERT_EQ(SAFE16_ERROR_INVALID_ALPHABET, safe16_alphabet_init(&alphabet, builtin.c_str(), NULL, "\""));
+    ASSERT_EQ(SAFE16_ERROR_INVALID_ALPHABET, safe16_alphabet_init(&alphabet, builtin.c_str(), " ", "\" "));
+    ASSERT_EQ(SAFE16_ERROR_INVALID_ALPHABET, safe16_alphabet_init(&alphabet, builtin.c_str(), NULL, (builtin.substr(0, 2)).c_str()));
+    ASSERT_EQ(SAFE16_STATUS_OK, safe16_alphabet_init(&alphabet, builtin.c_str(), " ", (extra_char + builtin[2]).c_str()));
+}
+
+TEST(Checksum, crc32c)
+{
+    const std::string check = "123456789";
+    const uint8_t* check_data = (const uint8_t*)check.data();
+    ASSERT_EQ(0xe3069283u, safe16_crc32c(0, check_data, check.size()));
+    ASSERT_EQ(0xe3069283u, safe16_crc32c(safe16_crc32c(0, check_data, 4), check_data + 4, check.size() - 4));
+    ASSERT_EQ(0u, safe16_crc32c(0, NULL, 0));
+}
+
+TEST(Checksum, encode_decode)
+{
+    for(int length = 0; length < g_bytes_per_group * 20; length++)
+    {
+        assert_checksum_encode_decode(length);
+    }
+    assert_checksum_encode_decode(g_bytes_per_group * 5000 + 1);
+}
+
+TEST(Checksum, feed)
+{
+    assert_checksum_feed(g_bytes_per_group * 10 + 1, g_chunks_per_group * 2 + 1);
+    assert_checksum_feed(g_bytes_per_group * 5000 + 1, g_chunks_per_group * 1500 + 1);
+    assert_checksum_feed(g_bytes_per_group * 5000 + 2, 100000);
+}
+
+TEST(Checksum, errors)
+{
+    std::vector<uint8_t> data = make_bytes(g_bytes_per_group * 5000, 1);
+    std::string encoded = encode_to_string(data);
+    uint32_t crc = 0;
+    ASSERT_EQ(SAFE16_ERROR_NOT_ENOUGH_ROOM, safe16_encode_crc32c(data.data(), data.size(), (uint8_t*)&encoded[0], encoded.size() - 1, &crc));
+    ASSERT_EQ(SAFE16_ERROR_NOT_ENOUGH_ROOM, safe16_decode_crc32c((const uint8_t*)encoded.data(), encoded.size(), data.data(), data.size() - 1, &crc));
+    ASSERT_EQ(SAFE16_ERROR_INVALID_LENGTH, safe16_decode_crc32c((const uint8_t*)encoded.data(), -1, data.data(), data.size(), &crc));
+    encoded[encoded.size() - 10] = '"';
+    ASSERT_EQ(SAFE16_ERROR_INVALID_SOURCE_DATA, safe16_decode_crc32c((const uint8_t*)encoded.data(), encoded.size(), data.data(), data.size(), &crc));
+}
+
+TEST(ContentName, sha256)
+{
+    assert_content_name("", {0xe3, 0xb0, 0xc4, 0x42, 0x98, 0xfc, 0x1c, 0x14, 0x9a, 0xfb, 0xf4, 0xc8, 0x99, 0x6f, 0xb9, 0x24,
+                             0x27, 0xae, 0x41, 0xe4, 0x64, 0x9b, 0x93, 0x4c, 0xa4, 0x95, 0x99, 0x1b, 0x78, 0x52, 0xb8, 0x55});
+    assert_content_name("abc", {0xba, 0x78, 0x16, 0xbf, 0x8f, 0x01, 0xcf, 0xea, 0x41, 0x41, 0x40, 0xde, 0x5d, 0xae, 0x22, 0x23,
+                                0xb0, 0x03, 0x61, 0xa3, 0x96, 0x17, 0x7a, 0x9c, 0xb4, 0x10, 0xff, 0x61, 0xf2, 0x00, 0x15, 0xad});
+    assert_content_name("abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq",
+                        {0x24, 0x8d, 0x6a, 0x61, 0xd2, 0x06, 0x38, 0xb8, 0xe5, 0xc0, 0x26, 0x93, 0x0c, 0x3e, 0x60, 0x39,
+                         0xa3, 0x3c, 0xe4, 0x59, 0x64, 0xff, 0x21, 0x67, 0xf6, 0xec, 0xed, 0xd4, 0x19, 0xdb, 0x06, 0xc1});
+    assert_content_name(std::string(1000000, 'a'),
+                        {0xcd, 0xc7, 0x6e, 0x5c, 0x99, 0x14, 0xfb, 0x92, 0x81, 0xa1, 0xc7, 0xe2, 0x84, 0xd7, 0x3e, 0x67,
+                         0xf1, 0x80, 0x9a, 0x48, 0xa4, 0x97, 0x20, 0x0e, 0x04, 0x6d, 0x39, 0xcc, 0xc7, 0x11, 0x2c, 0xd0});
+}
+
+TEST(ContentName, pieces)
+{
+    std::vector<uint8_t> data = make_bytes(1000, 5);
+    std::string expected = get_content_name(data, 0, 0);
+    for(int piece_length: {1, 7, 63, 64, 65, 200})
+    {
+        safe16_content_hasher hasher;
+        safe16_content_name_init(&hasher);
+        for(size_t offset = 0; offset < data.size(); offset += piece_length)
+        {
+            int64_t length = std::min<int64_t>(piece_length, data.size() - offset);
+            ASSERT_EQ(SAFE16_STATUS_OK, safe16_content_name_update(&hasher, data.data() + offset, length));
+        }
+        std::vector<uint8_t> name(expected.size());
+        ASSERT_EQ((int64_t)name.size(), safe16_content_name_finish(&hasher, 0, 0, name.data(), name.size()));
+        ASSERT_EQ(expected, std::string(name.begin(), name.end()));
+    }
+}
+
+TEST(ContentName, directories)
+{
+    std::vector<uint8_t> data = make_bytes(100, 1);
+    std::string name = get_content_name(data, 0, 0);
+    std::string split_name = get_content_name(data, 2, 3);
+    ASSERT_EQ(name.size() + 2, split_name.size());
+    ASSERT_EQ(name.substr(0, 3) + "/" + name.substr(3, 3) + "/" + name.substr(6), split_name);
+
+    std::vector<std::vector<uint8_t>> records = {make_bytes(0, 0), make_bytes(10, 1), make_bytes(100, 2)};
+    std::vector<const uint8_t*> src_buffers;
+    std::vector<int64_t> src_lengths;
+    std::string expected;
+    for(const auto& record: records)
+    {
+        src_buffers.push_back(record.data());
+        src_lengths.push_back(record.size());
+        expected += get_content_name(record, 1, 2);
+    }
+    std::vector<uint8_t> names(expected.size());
+    ASSERT_EQ((int64_t)expected.size(), safe16_content_name_batch(src_buffers.data(), src_lengths.data(), records.size(), 1, 2, names.data(), names.size()));
+    ASSERT_EQ(expected, std::string(names.begin(), names.end()));
+}
+
+TEST(ContentName, errors)
+{
+    int64_t name_length = safe16_get_content_name_length(0, 0);
+    ASSERT_EQ(safe16_get_encoded_length(32, false), name_length);
+    ASSERT_EQ(SAFE16_ERROR_INVALID_LENGTH, safe16_get_content_name_length(-1, 2));
+    ASSERT_EQ(SAFE16_ERROR_INVALID_LENGTH, safe16_get_content_name_length(1, -1));
+    ASSERT_EQ(SAFE16_ERROR_INVALID_LENGTH, safe16_get_content_name_length(1, 0));
+    ASSERT_EQ(SAFE16_ERROR_INVALID_LENGTH, safe16_get_content_name_length(1, name_length));
+    ASSERT_EQ(name_length + 1, safe16_get_content_name_length(1, name_length - 1));
+    ASSERT_EQ(SAFE16_ERROR_INVALID_LENGTH, safe16_get_content_name_length(2, (int64_t)1 << 62));
+
+    std::vector<uint8_t> data = make_bytes(10, 1);
+    std::vector<uint8_t> name(name_length);
+    ASSERT_EQ(SAFE16_ERROR_NOT_ENOUGH_ROOM, safe16_content_name(data.data(), data.size(), 0, 0, name.data(), name.size() - 1));
+    ASSERT_EQ(SAFE16_ERROR_NOT_ENOUGH_ROOM, safe16_content_name(data.data(), data.size(), 1, 2, name.data(), name.size()));
+    ASSERT_EQ(SAFE16_ERROR_INVALID_LENGTH, safe16_content_name(data.data(), -1, 0, 0, name.data(), name.size()));
+
+    const uint8_t* src_buffers[] = {data.data(), data.data()};
+    int64_t src_lengths[] = {10, -1};
+    ASSERT_EQ(SAFE16_ERROR_INVALID_LENGTH, safe16_content_name_batch(src_buffers, src_lengths, 2, 0, 0, name.data(), name.size()));
+    src_lengths[1] = 10;
+    ASSERT_EQ(SAFE16_ERROR_NOT_ENOUGH_ROOM, safe16_content_name_batch(src_buffers, src_lengths, 2, 0, 0, name.data(), name.size()));
+}
+
+TEST(Json, encode)
+{
+    for(int length = 0; length < g_bytes_per_group * 10; length++)
+    {
+        std::vector<uint8_t> data = make_bytes(length, length);
+        std::string expected = "\"" + encode_to_string(data) + "\"";
+        ASSERT_EQ((int64_t)expected.size(), safe16_get_json_string_length(length));
+        std::vector<uint8_t> buffer(expected.size());
+        ASSERT_EQ((int64_t)expected.size(), safe16_encode_json_string(data.data(), data.size(), buffer.data(), buffer.size()));
+        ASSERT_EQ(expected, std::string(buffer.begin(), buffer.end()));
+        ASSERT_EQ(SAFE16_ERROR_NOT_ENOUGH_ROOM, safe16_encode_json_string(data.data(), data.size(), buffer.data(), buffer.size() - 1));
+    }
+    ASSERT_EQ(SAFE16_ERROR_INVALID_LENGTH, safe16_get_json_string_length(-1));
+}
+
+TEST(Json, decode_in_place)
+{
+    std::vector<uint8_t> data = make_bytes(g_bytes_per_group * 10 + 1, 3);
+    std::string encoded = encode_to_string(data);
+    for(const std::string& value: {encoded, encoded.substr(0, 5) + "  " + encoded.substr(5)})
+    {
+        std::string document = "{\"data\": \"" + value + "\", \"next\": 1}";
+        size_t value_offset = document.find(value) - 1;
+        int64_t string_length = 0;
+        int64_t decoded_length = safe16_decode_json_string_in_place((uint8_t*)&document[value_offset], document.size() - value_offset, &string_length);
+        ASSERT_EQ((int64_t)data.size(), decoded_length);
+        ASSERT_EQ(data, std::vector<uint8_t>(document.begin() + value_offset, document.begin() + value_offset + decoded_length));
+        ASSERT_EQ((int64_t)value.size() + 2, string_length);
+        ASSERT_EQ(", \"next\": 1}", document.substr(value_offset + string_length));
+    }
+
+    std::string empty = "\"\"";
+    int64_t string_length = 0;
+    ASSERT_EQ(0, safe16_decode_json_string_in_place((uint8_t*)&empty[0], empty.size(), &string_length));
+    ASSERT_EQ(2, string_length);
+
+    std::string unquoted = encoded + "\"";
+    std::string unterminated = "\"" + encoded;
+    std::string escaped = "\"" + encoded.substr(0, 5) + "\\u0041" + encoded.substr(5) + "\"";
+    ASSERT_EQ(SAFE16_ERROR_INVALID_SOURCE_DATA, safe16_decode_json_string_in_place((uint8_t*)&unquoted[0], unquoted.size(), &string_length));
+    ASSERT_EQ(SAFE16_ERROR_TRUNCATED_DATA, safe16_decode_json_string_in_place((uint8_t*)&unterminated[0], unterminated.size(), &string_length));
+    ASSERT_EQ(SAFE16_ERROR_INVALID_SOURCE_DATA, safe16_decode_json_string_in_place((uint8_t*)&escaped[0], escaped.size(), &string_length));
+    ASSERT_EQ(SAFE16_ERROR_INVALID_SOURCE_DATA, safe16_decode_json_string_in_place((uint8_t*)&empty[0], 0, &string_length));
+    ASSERT_EQ(SAFE16_ERROR_INVALID_LENGTH, safe16_decode_json_string_in_place((uint8_t*)&empty[0], -1, &string_length));
+}
+
+#ifdef SAFE16_HAS_CPP17
+TEST(Json, append)
+{
+    std::vector<uint8_t> data = make_bytes(g_bytes_per_group * 4 + 2, 9);
+    std::string_view view(reinterpret_cast<const char*>(data.data()), data.size());
+    std::string json = "{\"data\":";
+    safe16::result<size_t> length = safe16::append_json_string(json, view);
+    json += "}";
+    ASSERT_TRUE(length);
+    ASSERT_EQ((size_t)safe16_get_json_string_length(data.size()), *length);
+    ASSERT_EQ("{\"data\":\"" + encode_to_string(data) + "\"}", json);
+}
+#endif
+
+static std::string transcode_from_standard(safe16_standard_format format, const std::string& src)
+{
+    std::vector<uint8_t> buffer(safe16_get_transcoded_length_from_standard(format, src.size()));
+    int64_t length = safe16_transcode_from_standard(format, (const uint8_t*)src.data(), src.size(), buffer.data(), buffer.size());
+    if(length < 0)
+    {
+        return "error " + std::to_string(length);
+    }
+    return std::string(buffer.begin(), buffer.begin() + length);
+}
+
+static std::string transcode_to_standard(safe16_standard_format format, bool use_padding, const std::string& src)
+{
+    std::vector<uint8_t> buffer(safe16_get_transcoded_length_to_standard(format, src.size(), use_padding));
+    int64_t length = safe16_transcode_to_standard(format, use_padding, (const uint8_t*)src.data(), src.size(), buffer.data(), buffer.size());
+    if(length < 0)
+    {
+        return "error " + std::to_string(length);
+    }
+    return std::string(buffer.begin(), buffer.begin() + length);
+}
+
+TEST(Transcode, rfc4648)
+{
+    // Test vectors from RFC 4648 section 10
+    const std::string text = "foobar";
+    const char* base64[] = {"", "Zg==", "Zm8=", "Zm9v", "Zm9vYg==", "Zm9vYmE=", "Zm9vYmFy"};
+    const char* base32[] = {"", "MY======", "MZXQ====", "MZXW6===", "MZXW6YQ=", "MZXW6YTB", "MZXW6YTBOI======"};
+    const char* base16[] = {"", "66", "666F", "666F6F", "666F6F62", "666F6F6261", "666F6F626172"};
+    for(size_t length = 0; length <= text.size(); length++)
+    {
+        std::vector<uint8_t> data(text.begin(), text.begin() + length);
+        std::string encoded = encode_to_string(data);
+        ASSERT_EQ(encoded, transcode_from_standard(SAFE16_FORMAT_BASE64, base64[length]));
+        ASSERT_EQ(encoded, transcode_from_standard(SAFE16_FORMAT_BASE32, base32[length]));
+        ASSERT_EQ(encoded, transcode_from_standard(SAFE16_FORMAT_BASE16, base16[length]));
+        ASSERT_EQ(base64[length], transcode_to_standard(SAFE16_FORMAT_BASE64, true, encoded));
+        ASSERT_EQ(base32[length], transcode_to_standard(SAFE16_FORMAT_BASE32, true, encoded));
+        ASSERT_EQ(base16[length], transcode_to_standard(SAFE16_FORMAT_BASE16, true, encoded));
+
+        std::string unpadded = base64[length];
+        unpadded.erase(unpadded.find_last_not_of('=') + 1);
+        ASSERT_EQ(encoded, transcode_from_standard(SAFE16_FORMAT_BASE64, unpadded));
+        ASSERT_EQ(unpadded, transcode_to_standard(SAFE16_FORMAT_BASE64, false, encoded));
+    }
+    ASSERT_EQ(encode_to_string({0xfb, 0xff}), transcode_from_standard(SAFE16_FORMAT_BASE64, "+/8="));
+    ASSERT_EQ(encode_to_string({0xfb, 0xff}), transcode_from_standard(SAFE16_FORMAT_BASE64URL, "-_8="));
+    ASSERT_EQ(encode_to_string({0xab, 0xcd}), transcode_from_standard(SAFE16_FORMAT_BASE16, "aBcD"));
+    ASSERT_EQ(encode_to_string({0x66, 0x6f, 0x6f}), transcode_from_standard(SAFE16_FORMAT_BASE64, " Zm\r\n9v\t"));
+}
+
+TEST(Transcode, round_trip)
+{
+    // Long enough to pass through several tiles
+    for(int length: {1, g_bytes_per_group * 100 + 1, 12345})
+    {
+        std::vector<uint8_t> data = make_bytes(length, length);
+        std::string encoded = encode_to_string(data);
+        std::string hex;
+        for(uint8_t byte: data)
+        {
+            hex += "0123456789ABCDEF"[byte >> 4];
+            hex += "0123456789ABCDEF"[byte & 15];
+        }
+        ASSERT_EQ(hex, transcode_to_standard(SAFE16_FORMAT_BASE16, true, encoded));
+        ASSERT_EQ(hex, transcode_to_standard(SAFE16_FORMAT_BASE16, true, add_whitespace(encoded)));
+        ASSERT_EQ(encoded, transcode_from_standard(SAFE16_FORMAT_BASE16, hex));
+        for(safe16_standard_format format: {SAFE16_FORMAT_BASE64, SAFE16_FORMAT_BASE64URL, SAFE16_FORMAT_BASE32})
+        {
+            ASSERT_EQ(encoded, transcode_from_standard(format, transcode_to_standard(format, true, encoded)));
+            ASSERT_EQ(encoded, transcode_from_standard(format, transcode_to_standard(format, false, encoded)));
+        }
+    }
+}
+
+TEST(Transcode, errors)
+{
+    std::string encoded = encode_to_string(make_bytes(10, 0));
+    uint8_t buffer[100];
+    const uint8_t* src = (const uint8_t*)encoded.data();
+    ASSERT_EQ("error " + std::to_string(SAFE16_ERROR_INVALID_SOURCE_DATA), transcode_from_standard(SAFE16_FORMAT_BASE64, "Zm9v!"));
+    ASSERT_EQ("error " + std::to_string(SAFE16_ERROR_INVALID_SOURCE_DATA), transcode_from_standard(SAFE16_FORMAT_BASE64, "Zg==Zg=="));
+    ASSERT_EQ("error " + std::to_string(SAFE16_ERROR_INVALID_SOURCE_DATA), transcode_from_standard(SAFE16_FORMAT_BASE64URL, "+/8="));
+    ASSERT_EQ("error " + std::to_string(SAFE16_ERROR_TRUNCATED_DATA), transcode_from_standard(SAFE16_FORMAT_BASE64, "Zm9vY"));
+    ASSERT_EQ("error " + std::to_string(SAFE16_ERROR_TRUNCATED_DATA), transcode_from_standard(SAFE16_FORMAT_BASE16, "666"));
+    ASSERT_EQ("error " + std::to_string(SAFE16_ERROR_INVALID_SOURCE_DATA), transcode_to_standard(SAFE16_FORMAT_BASE64, true, encoded + "\""));
+    ASSERT_EQ(SAFE16_ERROR_NOT_ENOUGH_ROOM, safe16_transcode_to_standard(SAFE16_FORMAT_BASE64, true, src, encoded.size(), buffer, 15));
+    ASSERT_EQ(SAFE16_ERROR_NOT_ENOUGH_ROOM, safe16_transcode_from_standard(SAFE16_FORMAT_BASE16, (const uint8_t*)"666F6F", 6, buffer, 1));
+    ASSERT_EQ(SAFE16_ERROR_INVALID_ALPHABET, safe16_transcode_to_standard((safe16_standard_format)4, true, src, encoded.size(), buffer, sizeof(buffer)));
+    ASSERT_EQ(SAFE16_ERROR_INVALID_ALPHABET, safe16_get_transcoded_length_from_standard((safe16_standard_format)-1, 10));
+    ASSERT_EQ(SAFE16_ERROR_INVALID_LENGTH, safe16_transcode_from_standard(SAFE16_FORMAT_BASE64, src, -1, buffer, sizeof(buffer)));
+    ASSERT_EQ(SAFE16_ERROR_INVALID_LENGTH, safe16_get_transcoded_length_to_standard(SAFE16_FORMAT_BASE64, -1, true));
+}
+
+static std::string standard_transcode_in_pieces(safe16_standard_transcoder& transcoder, const std::string& src_data, size_t src_window, size_t dst_window)
+{
+    std::string result;
+    std::vector<uint8_t> dst_buffer(dst_window);
+    size_t offset = 0;
+    size_t packet_end = 0;
+    safe16_status status = SAFE16_STATUS_PARTIALLY_COMPLETE;
+    for(int iteration = 0; status == SAFE16_STATUS_PARTIALLY_COMPLETE && iteration < 1000000; iteration++)
+    {
+        packet_end = std::min(std::max(packet_end, offset) + src_window, src_data.size());
+        const uint8_t* src = (const uint8_t*)src_data.data() + offset;
+        uint8_t* dst = dst_buffer.data();
+        status = safe16_standard_transcoder_feed(&transcoder, &src, packet_end - offset, &dst, dst_buffer.size(), packet_end == src_data.size());
+        offset = src - (const uint8_t*)src_data.data();
+        result.append(dst_buffer.data(), dst);
+    }
+    if(status != SAFE16_STATUS_OK)
+    {
+        return "error " + std::to_string(status);
+    }
+    return result;
+}
+
+static std::string from_standard_in_pieces(safe16_standard_format format, const std::string& src, size_t src_window, size_t dst_window)
+{
+    safe16_standard_transcoder transcoder;
+    EXPECT_EQ(SAFE16_STATUS_OK, safe16_standard_transcoder_init_from_standard(&transcoder, format));
+    return standard_transcode_in_pieces(transcoder, src, src_window, dst_window);
+}
+
+static std::string to_standard_in_pieces(safe16_standard_format format, bool use_padding, const std::string& src, size_t src_window, size_t dst_window)
+{
+    safe16_standard_transcoder transcoder;
+    EXPECT_EQ(SAFE16_STATUS_OK, safe16_standard_transcoder_init_to_standard(&transcoder, format, use_padding));
+    return standard_transcode_in_pieces(transcoder, src, src_window, dst_window);
+}
+
+TEST(Transcode, standard_in_pieces)
+{
+    for(int length: {0, 1, 2, g_bytes_per_group * 7 + 1, 5000})
+    {
+        std::string encoded = encode_to_string(make_bytes(length, length));
+        std::string spaced = add_whitespace(encoded);
+        for(safe16_standard_format format: {SAFE16_FORMAT_BASE64, SAFE16_FORMAT_BASE64URL, SAFE16_FORMAT_BASE32, SAFE16_FORMAT_BASE16})
+        {
+            for(bool use_padding: {false, true})
+            {
+                std::string standard = transcode_to_standard(format, use_padding, encoded);
+                for(size_t src_window: {(size_t)g_chunks_per_group, (size_t)97, (size_t)10000})
+                {
+                    for(size_t dst_window: {(size_t)1, (size_t)3, (size_t)1000})
+                    {
+                        ASSERT_EQ(standard, to_standard_in_pieces(format, use_padding, spaced, src_window, dst_window));
+                    }
+                }
+                for(size_t src_window: {(size_t)1, (size_t)7, (size_t)10000})
+                {
+                    for(size_t dst_window: {(size_t)g_chunks_per_group, (size_t)g_chunks_per_group + 1, (size_t)1000})
+                    {
+                        ASSERT_EQ(encoded, from_standard_in_pieces(format, standard, src_window, dst_window));
+                    }
+                }
+            }
+        }
+    }
+
+    // Errors that span feeds
+    ASSERT_EQ("error " + std::to_string(SAFE16_ERROR_INVALID_SOURCE_DATA), from_standard_in_pieces(SAFE16_FORMAT_BASE64, "Zg==Zg==", 3, 100));
+    ASSERT_EQ("error " + std::to_string(SAFE16_ERROR_TRUNCATED_DATA), from_standard_in_pieces(SAFE16_FORMAT_BASE64, "Zm9vY", 1, 100));
+    ASSERT_EQ("error " + std::to_string(SAFE16_ERROR_INVALID_SOURCE_DATA), to_standard_in_pieces(SAFE16_FORMAT_BASE16, true, encode_to_string(make_bytes(100, 0)) + "\"", 7, 3));
+
+    safe16_standard_transcoder transcoder;
+    ASSERT_EQ(SAFE16_ERROR_INVALID_ALPHABET, safe16_standard_transcoder_init_from_standard(&transcoder, (safe16_standard_format)4));
+    ASSERT_EQ(SAFE16_ERROR_INVALID_ALPHABET, safe16_standard_transcoder_init_to_standard(&transcoder, (safe16_standard_format)-1, true));
+    ASSERT_EQ(SAFE16_STATUS_OK, safe16_standard_transcoder_init_to_standard(&transcoder, SAFE16_FORMAT_BASE64, true));
+    const uint8_t* src = (const uint8_t*)"";
+    uint8_t buffer[10];
+    uint8_t* dst = buffer;
+    ASSERT_EQ(SAFE16_ERROR_INVALID_LENGTH, safe16_standard_transcoder_feed(&transcoder, &src, -1, &dst, sizeof(buffer), true));
+}
+
+// Stands in for another codec when transcoding: copies the binary data
+// through, and checks that only the final piece is not whole groups.
+static bool g_copy_encode_saw_partial_group;
+
+static int64_t copy_encode(const uint8_t* src_buffer, int64_t src_buffer_length, uint8_t* dst_buffer, int64_t dst_buffer_length)
+{
+    if(src_buffer_length > dst_buffer_length)
+    {
+        return SAFE16_ERROR_NOT_ENOUGH_ROOM;
+    }
+    EXPECT_FALSE(g_copy_encode_saw_partial_group);
+    if(src_buffer_length % 60 != 0)
+    {
+        g_copy_encode_saw_partial_group = true;
+    }
+    memcpy(dst_buffer, src_buffer, src_buffer_length);
+    return src_buffer_length;
+}
+
+static std::vector<uint8_t> transcode_in_pieces(safe16_encode_function encode, const std::string& encoded, int src_window, int dst_window)
+{
+    std::vector<uint8_t> result;
+    std::vector<uint8_t> dst_buffer(dst_window);
+    safe16_transcoder transcoder;
+    safe16_transcoder_init(&transcoder, encode);
+    g_copy_encode_saw_partial_group = false;
+    size_t offset = 0;
+    size_t packet_end = 0;
+    safe16_status status = SAFE16_STATUS_PARTIALLY_COMPLETE;
+    while(status == SAFE16_STATUS_PARTIALLY_COMPLETE)
+    {
+        packet_end = std::min(std::max(packet_end, offset) + src_window, encoded.size());
+        const uint8_t* src = (const uint8_t*)encoded.data() + offset;
+        uint8_t* dst = dst_buffer.data();
+        status = safe16_transcoder_feed(&transcoder, &src, packet_end - offset, &dst, dst_buffer.size(), packet_end == encoded.size());
+        offset = src - (const uint8_t*)encoded.data();
+        result.insert(result.end(), dst_buffer.data(), dst);
+    }
+    EXPECT_EQ(SAFE16_STATUS_OK, status);
+    return result;
+}
+
+TEST(Transcode, codecs)
+{
+    for(int length: {0, 1, g_bytes_per_group * 7 + 1, 5000, 20000})
+    {
+        std::vector<uint8_t> data = make_bytes(length, length);
+        std::string encoded = encode_to_string(data);
+        std::string spaced = add_whitespace(encoded);
+        std::vector<uint8_t> buffer(safe16_get_encoded_length(length, false) + 1);
+
+        g_copy_encode_saw_partial_group = false;
+        ASSERT_EQ(length, safe16_transcode(copy_encode, (const uint8_t*)spaced.data(), spaced.size(), buffer.data(), buffer.size()));
+        ASSERT_EQ(data, std::vector<uint8_t>(buffer.begin(), buffer.begin() + length));
+
+        int64_t transcoded_length = safe16_transcode(safe16_encode, (const uint8_t*)spaced.data(), spaced.size(), buffer.data(), buffer.size());
+        ASSERT_EQ(encoded, std::string(buffer.begin(), buffer.begin() + transcoded_length));
+
+        ASSERT_EQ(data, transcode_in_pieces(copy_encode, spaced, 100, 200));
+        ASSERT_EQ(data, transcode_in_pieces(copy_encode, encoded, 10000, 60));
+        std::vector<uint8_t> pieces = transcode_in_pieces(safe16_encode, spaced, 37, 1000);
+        ASSERT_EQ(encoded, std::string(pieces.begin(), pieces.end()));
+    }
+}
+
+TEST(Transcode, codec_errors)
+{
+    std::string encoded = encode_to_string(make_bytes(100, 0));
+    std::vector<uint8_t> buffer(encoded.size());
+    ASSERT_EQ(SAFE16_ERROR_NOT_ENOUGH_ROOM, safe16_transcode(safe16_encode, (const uint8_t*)encoded.data(), encoded.size(), buffer.data(), buffer.size() - 1));
+    std::string invalid = encoded.substr(0, 10) + "\"" + encoded.substr(10);
+    ASSERT_EQ(SAFE16_ERROR_INVALID_SOURCE_DATA, safe16_transcode(safe16_encode, (const uint8_t*)invalid.data(), invalid.size(), buffer.data(), buffer.size()));
+    ASSERT_EQ(SAFE16_ERROR_INVALID_LENGTH, safe16_transcode(safe16_encode, (const uint8_t*)encoded.data(), -1, buffer.data(), buffer.size()));
+}
+
+static std::string lay_out(const std::string& encoded, const safe16_layout& layout)
+{
+    std::string separator = std::string(layout.use_crlf ? "\r\n" : "\n") + std::string(layout.indent_length, ' ');
+    std::string result(layout.indent_length, ' ');
+    for(size_t i = 0; i < encoded.size(); i++)
+    {
+        result += encoded[i];
+        if(layout.line_length > 0 && (i + 1) % layout.line_length == 0)
+        {
+            result += separator;
+        }
+    }
+    return result;
+}
+
+static const safe16_layout g_test_layouts[] =
+{
+    {0, 0, false},
+    {0, 2, false},
+    {1, 0, false},
+    {3, 1, true},
+    {7, 2, true},
+    {76, 4, false},
+};
+
+static std::string encode_with_layout_in_pieces(const std::vector<uint8_t>& data, const safe16_layout& layout, bool use_length_field, size_t dst_window = 40)
+{
+    std::string result;
+    safe16_layout_encoder encoder;
+    if(use_length_field)
+    {
+        EXPECT_EQ(SAFE16_STATUS_OK, safe16l_layout_encoder_init(&encoder, &layout, data.size()));
+    }
+    else
+    {
+        EXPECT_EQ(SAFE16_STATUS_OK, safe16_layout_encoder_init(&encoder, &layout));
+    }
+    // Small enough destination windows to split lines and groups
+    std::vector<uint8_t> dst_buffer(dst_window);
+    size_t offset = 0;
+    size_t packet_end = 0;
+    safe16_status status = SAFE16_STATUS_PARTIALLY_COMPLETE;
+    for(int i = 0; i < 100000 && (status == SAFE16_STATUS_PARTIALLY_COMPLETE || offset < data.size()); i++)
+    {
+        packet_end = std::min(std::max(packet_end, offset) + 5, data.size());
+        const uint8_t* src = data.data() + offset;
+        uint8_t* dst = dst_buffer.data();
+        status = safe16_layout_encoder_feed(&encoder, &src, packet_end - offset, &dst, dst_buffer.size(), packet_end == data.size());
+        EXPECT_TRUE(status == SAFE16_STATUS_OK || status == SAFE16_STATUS_PARTIALLY_COMPLETE);
+        offset = src - data.data();
+        result.append(dst_buffer.data(), dst);
+    }
+    EXPECT_EQ(SAFE16_STATUS_OK, status);
+    return result;
+}
+
+TEST(Layout, encode)
+{
+    for(const safe16_layout& layout: g_test_layouts)
+    {
+        for(int length = 0; length < g_bytes_per_group * 12; length++)
+        {
+            std::vector<uint8_t> data = make_bytes(length, length);
+            std::string expected = lay_out(encode_to_string(data), layout);
+            ASSERT_EQ((int64_t)expected.size(), safe16_get_encoded_length_with_layout(length, false, &layout));
+            std::vector<uint8_t> buffer(expected.size());
+            ASSERT_EQ((int64_t)expected.size(), safe16_encode_with_layout(data.data(), data.size(), buffer.data(), buffer.size(), &layout));
+            ASSERT_EQ(expected, std::string(buffer.begin(), buffer.end()));
+            if(!expected.empty())
+            {
+                ASSERT_EQ(SAFE16_ERROR_NOT_ENOUGH_ROOM, safe16_encode_with_layout(data.data(), data.size(), buffer.data(), buffer.size() - 1, &layout));
+            }
+
+            std::vector<uint8_t> decoded(length + 1);
+            ASSERT_EQ(length, safe16_decode(buffer.data(), buffer.size(), decoded.data(), decoded.size()));
+            ASSERT_EQ(data, std::vector<uint8_t>(decoded.begin(), decoded.begin() + length));
+        }
+    }
+}
+
+TEST(Layout, feed)
+{
+    for(const safe16_layout& layout: g_test_layouts)
+    {
+        for(int length: {0, 1, g_bytes_per_group * 9 + 1, 500})
+        {
+            std::vector<uint8_t> data = make_bytes(length, length);
+            ASSERT_EQ(lay_out(encode_to_string(data), layout), encode_with_layout_in_pieces(data, layout, false));
+
+            std::vector<uint8_t> encoded(safe16_get_encoded_length(length, true));
+            int64_t encoded_length = safe16l_encode(data.data(), data.size(), encoded.data(), encoded.size());
+            ASSERT_EQ((int64_t)encoded.size(), encoded_length);
+            std::string expected = lay_out(std::string(encoded.begin(), encoded.end()), layout);
+            ASSERT_EQ((int64_t)expected.size(), safe16_get_encoded_length_with_layout(length, true, &layout));
+            ASSERT_EQ(expected, encode_with_layout_in_pieces(data, layout, true));
+        }
+    }
+}
+
+TEST(Layout, feed_small_destination)
+{
+    std::vector<safe16_layout> layouts(std::begin(g_test_layouts), std::end(g_test_layouts));
+    layouts.push_back({2, 1, true});
+    layouts.push_back({1, 10, false});
+    for(const safe16_layout& layout: layouts)
+    {
+        for(size_t dst_window: {1, 2, 3})
+        {
+            std::vector<uint8_t> data = make_bytes(g_bytes_per_group * 5 + 1, 3);
+            ASSERT_EQ(lay_out(encode_to_string(data), layout), encode_with_layout_in_pieces(data, layout, false, dst_window));
+
+            std::vector<uint8_t> encoded(safe16_get_encoded_length(data.size(), true));
+            ASSERT_EQ((int64_t)encoded.size(), safe16l_encode(data.data(), data.size(), encoded.data(), encoded.size()));
+            std::string expected = lay_out(std::string(encoded.begin(), encoded.end()), layout);
+            ASSERT_EQ(expected, encode_with_layout_in_pieces(data, layout, true, dst_window));
+        }
+    }
+}
+
+TEST(Layout, encode_empty)
+{
+    const safe16_layout layout = {10, 0, false};
+    ASSERT_EQ(0, safe16_encode_with_layout(NULL, 0, NULL, 0, &layout));
+}
+
+TEST(Layout, errors)
+{
+    const safe16_layout bad_line = {-1, 0, false};
+    const safe16_layout bad_indent = {10, -1, false};
+    const safe16_layout layout = {10, 2, false};
+    safe16_layout_encoder encoder;
+    ASSERT_EQ(SAFE16_ERROR_INVALID_LENGTH, safe16_get_encoded_length_with_layout(10, false, &bad_line));
+    ASSERT_EQ(SAFE16_ERROR_INVALID_LENGTH, safe16_get_encoded_length_with_layout(-1, false, &layout));
+    ASSERT_EQ(SAFE16_ERROR_INVALID_LENGTH, safe16_layout_encoder_init(&encoder, &bad_indent));
+    ASSERT_EQ(SAFE16_ERROR_INVALID_LENGTH, safe16l_layout_encoder_init(&encoder, &layout, -1));
+
+    std::vector<uint8_t> data = make_bytes(10, 0);
+    uint8_t buffer[100];
+    const uint8_t* src = data.data();
+    uint8_t* dst = buffer;
+    ASSERT_EQ(SAFE16_STATUS_OK, safe16l_layout_encoder_init(&encoder, &layout, 5));
+    ASSERT_EQ(SAFE16_ERROR_TOO_MUCH_DATA, safe16_layout_encoder_feed(&encoder, &src, data.size(), &dst, sizeof(buffer), true));
+    ASSERT_EQ(SAFE16_ERROR_TRUNCATED_DATA, safe16_layout_encoder_feed(&encoder, &src, 4, &dst, sizeof(buffer), true));
+
+    safe16_layout detected;
+    ASSERT_EQ(SAFE16_ERROR_INVALID_LENGTH, safe16_detect_layout(buffer, -1, &detected));
+    ASSERT_EQ(SAFE16_ERROR_INVALID_LENGTH, safe16_decode_with_layout(buffer, 10, buffer, -1, &layout));
+    ASSERT_EQ(SAFE16_ERROR_INVALID_LENGTH, safe16_decode_with_layout(buffer, 10, buffer, 10, &bad_line));
+    ASSERT_EQ(SAFE16_ERROR_INVALID_LENGTH, safe16_decode_with_layout(buffer, 10, buffer, 10, &bad_indent));
+    const uint8_t* feed_src = buffer;
+    uint8_t* feed_dst = buffer;
+    ASSERT_EQ(SAFE16_ERROR_INVALID_LENGTH, safe16_decode_with_layout_feed(&layout, &feed_src, -1, &feed_dst, 10, SAFE16_STREAM_STATE_NONE));
+    ASSERT_EQ(SAFE16_ERROR_INVALID_LENGTH, safe16_decode_with_layout_feed(&bad_line, &feed_src, 10, &feed_dst, 10, SAFE16_STREAM_STATE_NONE));
+}
+
+// Decodes the way a buffered reader would: each feed sees at most
+// feed_length new characters after whatever the last feed left behind.
+static std::vector<uint8_t> decode_with_layout_in_pieces(const std::string& text, const safe16_layout* layout, size_t feed_length)
+{
+    std::vector<uint8_t> result;
+    std::string pending;
+    size_t offset = 0;
+    safe16_status status = SAFE16_STATUS_PARTIALLY_COMPLETE;
+    bool is_at_end = false;
+    while(!is_at_end)
+    {
+        const size_t next_length = std::min(feed_length, text.size() - offset);
+        pending += text.substr(offset, next_length);
+        offset += next_length;
+        is_at_end = offset == text.size();
+
+        std::vector<uint8_t> decoded(pending.size() + 1);
+        const uint8_t* src = (const uint8_t*)pending.data();
+        uint8_t* dst = decoded.data();
+        status = safe16_decode_with_layout_feed(layout, &src, pending.size(), &dst, decoded.size(),
+                                                is_at_end ? SAFE16_SRC_IS_AT_END_OF_STREAM : SAFE16_STREAM_STATE_NONE);
+        EXPECT_TRUE(status == SAFE16_STATUS_OK || status == SAFE16_STATUS_PARTIALLY_COMPLETE) << status;
+        result.insert(result.end(), decoded.data(), dst);
+        pending = pending.substr(src - (const uint8_t*)pending.data());
+    }
+    EXPECT_EQ(SAFE16_STATUS_OK, status);
+    return result;
+}
+
+static void assert_decodes_like_decode(const std::string& text, const safe16_layout* layout)
+{
+    for(size_t extra: {0, 1})
+    {
+        std::vector<uint8_t> expected(safe16_get_decoded_length(text.size()) + extra);
+        std::vector<uint8_t> actual(expected.size());
+        const int64_t expected_length = safe16_decode((const uint8_t*)text.data(), text.size(), expected.data(), expected.size());
+        ASSERT_EQ(expected_length, safe16_decode_with_layout((const uint8_t*)text.data(), text.size(), actual.data(), actual.size(), layout));
+        if(expected_length > 0)
+        {
+            ASSERT_EQ(expected, actual);
+        }
+    }
+    std::vector<uint8_t> expected(safe16_get_decoded_length(text.size()) + 1);
+    const int64_t expected_length = safe16_decode((const uint8_t*)text.data(), text.size(), expected.data(), expected.size());
+    if(expected_length >= 0)
+    {
+        expected.resize(expected_length);
+        for(size_t feed_length: {1, 7, 50, 200})
+        {
+            ASSERT_EQ(expected, decode_with_layout_in_pieces(text, layout, feed_length)) << feed_length;
+        }
+    }
+}
+
+TEST(Layout, decode)
+{
+    for(const safe16_layout& layout: g_test_layouts)
+    {
+        for(int length = 0; length < g_bytes_per_group * 12; length++)
+        {
+            std::vector<uint8_t> data = make_bytes(length, length);
+            std::string text = lay_out(encode_to_string(data), layout);
+            std::vector<uint8_t> decoded(length + 1);
+            ASSERT_EQ(length, safe16_decode_with_layout((const uint8_t*)text.data(), text.size(), decoded.data(), decoded.size(), &layout));
+            ASSERT_EQ(data, std::vector<uint8_t>(decoded.begin(), decoded.begin() + length));
+            assert_decodes_like_decode(text, &layout);
+            assert_decodes_like_decode(text, NULL);
+
+            std::vector<uint8_t> in_place(text.begin(), text.end());
+            ASSERT_EQ(length, safe16_decode_with_layout(in_place.data(), in_place.size(), in_place.data(), in_place.size(), NULL));
+            ASSERT_EQ(data, std::vector<uint8_t>(in_place.begin(), in_place.begin() + length));
+        }
+    }
+}
+
+TEST(Layout, decode_deviations)
+{
+    const safe16_layout layout = {10, 2, true};
+    std::string text = lay_out(encode_to_string(make_bytes(200, 0)), layout);
+    std::vector<std::string> variants =
+    {
+        text.substr(0, 30) + " " + text.substr(30),
+        text.substr(0, 50) + "\n" + text.substr(50),
+        text.substr(1),
+        text.substr(0, 14) + text.substr(15),
+        text + "\n\n",
+        text.substr(0, 40) + "\"" + text.substr(40),
+        text.substr(0, 100) + "\"",
+    };
+    for(size_t i = 0; i < variants.size(); i++)
+    {
+        SCOPED_TRACE(i);
+        assert_decodes_like_decode(variants[i], &layout);
+        assert_decodes_like_decode(variants[i], NULL);
+    }
+}
+
+TEST(Layout, detect)
+{
+    const std::vector<std::pair<std::string, safe16_layout>> texts =
+    {
+        {"", {0, 0, false}},
+        {"  abc", {0, 2, false}},
+        {"abcd\nabcd\nab", {4, 0, false}},
+        {"   abcdef\r\n   abc", {6, 3, true}},
+        {" abc\n", {3, 1, false}},
+    };
+    for(const auto& text: texts)
+    {
+        safe16_layout layout;
+        ASSERT_EQ(SAFE16_STATUS_OK, safe16_detect_layout((const uint8_t*)text.first.data(), text.first.size(), &layout));
+        ASSERT_EQ(text.second.line_length, layout.line_length);
+        ASSERT_EQ(text.second.indent_length, layout.indent_length);
+        ASSERT_EQ(text.second.use_crlf, layout.use_crlf);
+    }
+    for(const std::string text: {"\nabc", "ab cd\nab cd", "ab\rcd", "  abc\nabc", "abc\"def"})
+    {
+        safe16_layout layout;
+        ASSERT_EQ(SAFE16_ERROR_INVALID_SOURCE_DATA, safe16_detect_layout((const uint8_t*)text.data(), text.size(), &layout));
+    }
+}
 
 
 // Specification Examples:
@@ -0,0 +1 @@
+../../../common/tools/build_tables.py
\ No newline at end of file
@@ -101,6 +101,85 @@ static void write_to_file(FILE* const file,
     }
 }
 
+static void write_all_to_file(FILE* const file,
+                              const uint8_t* data,
+                              int64_t length)
+{
+    while(length > 0)
+    {
+        const int chunk_length = length < BUFFER_SIZE ? (int)length : BUFFER_SIZE;
+        write_to_file(file, (const char*)data, chunk_length);
+        data += chunk_length;
+        length -= chunk_length;
+    }
+}
+
+static void* allocate_or_exit(const int64_t length)
+{
+    void* const buffer = malloc(length > 0 ? length : 1);
+    if(buffer == NULL)
+    {
+        error_exit("Could not allocate %lld bytes\n", (long long)length);
+    }
+    return buffer;
+}
+
+// Opens a file for random access. Anything that can't seek (such as a pipe)
+// is copied to a temporary file first.
+static FILE* open_seekable_file(const char* const filename, int64_t* const length)
+{
+    FILE* file = open_file(filename);
+    if(fseek(file, 0, SEEK_END) != 0)
+    {
+        FILE* const temp_file = tmpfile();
+        if(temp_file == NULL)
+        {
+            perror_exit("Could not create a temporary file");
+        }
+        uint8_t buffer[BUFFER_SIZE];
+        bool is_at_end = false;
+        while(!is_at_end)
+        {
+            const int bytes_read = read_from_file(file, buffer, sizeof(buffer), &is_at_end);
+            write_to_file(temp_file, (const char*)buffer, bytes_read);
+        }
+        close_file(file);
+        file = temp_file;
+        if(fseek(file, 0, SEEK_END) != 0)
+        {
+            perror_exit("Could not seek in temporary file");
+        }
+    }
+    const long end = ftell(file);
+    if(end < 0)
+    {
+        perror_exit("Could not get the length of %s", filename);
+    }
+    *length = end;
+    return file;
+}
+
+static uint8_t* read_file_range(FILE* const file, const int64_t offset, const int64_t length)
+{
+    if(fseek(file, (long)offset, SEEK_SET) != 0)
+    {
+        perror_exit("Could not seek to offset %lld", (long long)offset);
+    }
+    uint8_t* const buffer = allocate_or_exit(length);
+    int64_t used = 0;
+    bool is_at_end = false;
+    while(used < length && !is_at_end)
+    {
+        const int64_t bytes_to_read = length - used < (1 << 30) ? length - used : (1 << 30);
+        used += read_from_file(file, buffer + used, bytes_to_read, &is_at_end);
+    }
+    if(used < length)
+    {
+        error_exit("Unexpected end of file at offset %lld\n", (long long)(offset + used));
+    }
+    return buffer;
+}
+
 static void error_unexpected_status_exit(const safe32_status status)
 {
     const char* name = "Unknown";
@@ -117,6 +196,9 @@ static void error_unexpected_status_exit(const safe32_status status)
         HANDLE_CASE(SAFE32_ERROR_TRUNCATED_DATA);
         HANDLE_CASE(SAFE32_ERROR_INVALID_LENGTH);
         HANDLE_CASE(SAFE32_ERROR_NOT_ENOUGH_ROOM);
+        HANDLE_CASE(SAFE32_ERROR_ALLOCATION_FAILED);
+        HANDLE_CASE(SAFE32_ERROR_TOO_MUCH_DATA);
+        HANDLE_CASE(SAFE32_ERROR_INVALID_ALPHABET);
 
         // This should not happen
         HANDLE_CASE(SAFE32_STATUS_OK);
@@ -129,58 +211,6 @@ static void error_unexpected_status_exit(const safe32_status status)
 // Encoding & Decoding
 // -------------------
 
-static void insert_indentation(FILE* const file, const int indent_count)
-{
-    if(indent_count <= 0)
-    {
-        return;
-    }
-    char buffer[indent_count];
-    memset(buffer, ' ', sizeof(buffer));
-    write_to_file(file, buffer, sizeof(buffer));
-}
-
-static void insert_line_break(FILE* const file)
-{
-    write_to_file(file, "\n", 1);
-}
-
-static int64_t output_encoded(FILE* const file,
-                              const char* const data,
-                              const int length,
-                              const int64_t current_offset,
-                              const int line_break_at,
-                              const int indent_count)
-{
-    const int64_t end_offset = current_offset + length;
-    const char* const data_end = data + length;
-    if(line_break_at <= 0)
-    {
-        write_to_file(file, data, length);
-        return end_offset;
-    }
-
-    int64_t chars_until_line_break = line_break_at - (current_offset % line_break_at);
-    const char* data_current = data;
-    while(data_current < data_end)
-    {
-        int chars_to_write = chars_until_line_break;
-        if(data_current + chars_to_write > data_end)
-        {
-            chars_to_write = data_end - data_current;
-        }
-        write_to_file(file, data_current, chars_to_write);
-        if(chars_to_write == chars_until_line_break)
-        {
-            insert_line_break(file);
-            insert_indentation(file, indent_count);
-        }
-        data_current += chars_to_write;
-        chars_until_line_break = line_break_at;
-    }
-    return end_offset;
-}
-
 static void encode(const char* const filename,
                    const bool use_length_fields,
                    const int line_break_at,
@@ -189,13 +219,21 @@ static void encode(const char* const filename,
     FILE* const src_file = open_file(filename);
     FILE* const dst_file = stdout;
 
+    const safe32_layout layout = {line_break_at, indent_count, false};
     uint8_t decoded_buffer[BUFFER_SIZE];
-    uint8_t encoded_buffer[safe32_get_encoded_length(sizeof(decoded_buffer), false)];
+    const int64_t laid_out_length = safe32_get_encoded_length_with_layout(sizeof(decoded_buffer), true, &layout);
+    if(laid_out_length < 0)
+    {
+        error_unexpected_status_exit(laid_out_length);
+    }
+    // Leave room for the line break that the previous buffer's last line
+    // may have left pending.
+    const int64_t encoded_buffer_length = laid_out_length + 2 + indent_count;
+    uint8_t* const encoded_buffer = allocate_or_exit(encoded_buffer_length);
     int decoded_buffer_offset = 0;
-    int64_t current_offset = 0;
     bool is_at_end = false;
-
-    insert_indentation(dst_file, indent_count);
+    safe32_layout_encoder encoder;
+    safe32_status status;
 
     if(use_length_fields)
     {
@@ -216,14 +254,15 @@ static void encode(const char* const filename,
         {
             perror_exit("Error seeking to beginning of source file");
         }
-        int64_t bytes_to_write = safe32_write_length_field(file_size, encoded_buffer, sizeof(encoded_buffer));
-
-        current_offset = output_encoded(dst_file,
-                                        (char*)encoded_buffer,
-                                        bytes_to_write,
-                                        current_offset,
-                                        line_break_at,
-                                        indent_count);
+        status = safe32l_layout_encoder_init(&encoder, &layout, file_size);
+    }
+    else
+    {
+        status = safe32_layout_encoder_init(&encoder, &layout);
+    }
+    if(status != SAFE32_STATUS_OK)
+    {
+        error_unexpected_status_exit(status);
     }
 
     while(!is_at_end)
@@ -236,82 +275,78 @@ static void encode(const char* const filename,
         const int bytes_to_process = decoded_buffer_offset + bytes_read;
         const uint8_t* src = decoded_buffer;
         uint8_t* dst = encoded_buffer;
-        const safe32_status status = safe32_encode_feed(&src,
-                                                        bytes_to_process,
-                                                        &dst,
-                                                        sizeof(encoded_buffer),
-                                                        is_at_end);
+        status = safe32_layout_encoder_feed(&encoder,
+                                            &src,
+                                            bytes_to_process,
+                                            &dst,
+                                            encoded_buffer_length,
+                                            is_at_end);
         if(status != SAFE32_STATUS_OK && status != SAFE32_STATUS_PARTIALLY_COMPLETE)
         {
             error_unexpected_status_exit(status);
         }
         const int bytes_processed = src - decoded_buffer;
-        const int bytes_to_write = dst - encoded_buffer;
 
-        current_offset = output_encoded(dst_file,
-                                        (char*)encoded_buffer,
-                                        bytes_to_write,
-                                        current_offset,
-                                        line_break_at,
-                                        indent_count);
+        write_all_to_file(dst_file, encoded_buffer, dst - encoded_buffer);
 
         decoded_buffer_offset = bytes_to_process - bytes_processed;
         memmove(decoded_buffer, src, decoded_buffer_offset);
     }
 
+    free(encoded_buffer);
     close_file(src_file);
     close_file(dst_file);
 }
 
-static void decode(const char* const filename, const bool use_length_field)
+static void decode(const char* const filename,
+                   const bool use_length_field,
+                   const int line_break_at,
+                   const int indent_count)
 {
     FILE* const src_file = open_file(filename);
     FILE* const dst_file = stdout;
+    const safe32_layout layout = {line_break_at, indent_count, false};
+    const bool has_layout = line_break_at > 0 || indent_count > 0;
 
     uint8_t decoded_buffer[BUFFER_SIZE];
     uint8_t encoded_buffer[safe32_get_encoded_length(sizeof(decoded_buffer), false)];
     int encoded_buffer_offset = 0;
     bool is_at_end = false;
-    safe32_stream_state stream_state = SAFE32_STREAM_STATE_NONE;
-    int64_t expected_bytes_decoded = -1;
-    int64_t total_bytes_decoded = 0;
+    bool is_complete = false;
+    safe32l_decoder decoder;
+    safe32l_decoder_init(&decoder);
 
-    if(use_length_field)
-    {
-        const int bytes_to_read = 100;
-        const int bytes_read = read_from_file(src_file,
-                                              encoded_buffer,
-                                              bytes_to_read,
-                                              &is_at_end);
-        int64_t bytes_processed = safe32_read_length_field(encoded_buffer, bytes_read, &expected_bytes_decoded);
-        if(bytes_processed < 0)
-        {
-            error_unexpected_status_exit(bytes_processed);
-        }
-        encoded_buffer_offset = bytes_read - bytes_processed;
-        memmove(encoded_buffer, encoded_buffer + bytes_processed, encoded_buffer_offset);
-    }
-
-    while(!is_at_end)
+    while(!is_at_end && !is_complete)
     {
         const int bytes_to_read = sizeof(encoded_buffer) - encoded_buffer_offset;
         const int bytes_read = read_from_file(src_file,
                                               encoded_buffer + encoded_buffer_offset,
                                               bytes_to_read,
                                               &is_at_end);
-        if(is_at_end)
-        {
-            stream_state = SAFE32_SRC_IS_AT_END_OF_STREAM;
-        }
 
         const int bytes_to_process = encoded_buffer_offset + bytes_read;
         const uint8_t* src = encoded_buffer;
         uint8_t* dst = decoded_buffer;
-        safe32_status status = safe32_decode_feed(&src,
-                                                  bytes_to_process,
-                                                  &dst,
-                                                  sizeof(decoded_buffer),
-                                                  stream_state);
+        safe32_status status;
+        if(use_length_field)
+        {
+            status = safe32l_decode_feed(&decoder,
+                                         &src,
+                                         bytes_to_process,
+                                         &dst,
+                                         sizeof(decoded_buffer),
+                                         is_at_end);
+            is_complete = status == SAFE32_STATUS_OK;
+        }
+        else
+        {
+            status = safe32_decode_with_layout_feed(has_layout ? &layout : NULL,
+                                                    &src,
+                                                    bytes_to_process,
+                                                    &dst,
+                                                    sizeof(decoded_buffer),
+                                                    is_at_end ? SAFE32_SRC_IS_AT_END_OF_STREAM : SAFE32_STREAM_STATE_NONE);
+        }
         if(status != SAFE32_STATUS_OK && status != SAFE32_STATUS_PARTIALLY_COMPLETE)
         {
             error_unexpected_status_exit(status);
@@ -320,7 +355,6 @@ static void decode(const char* const filename, const bool use_length_field)
         const int bytes_to_write = dst - decoded_buffer;
 
         write_to_file(dst_file, (const char*)decoded_buffer, bytes_to_write);
-        total_bytes_decoded += bytes_to_write;
 
         encoded_buffer_offset = bytes_to_process - bytes_processed;
         memmove(encoded_buffer, src, encoded_buffer_offset);
@@ -330,6 +364,308 @@ static void decode(const char* const filename, const bool use_length_field)
     close_file(dst_file);
 }
 
+static void encode_container(const char* const filename,
+                             const int64_t segment_length,
+                             const int line_break_at,
+                             const int indent_count)
+{
+    FILE* const src_file = open_file(filename);
+    FILE* const dst_file = stdout;
+
+    const safe32_layout layout = {line_break_at, indent_count, false};
+    safe32_container_writer writer;
+    safe32_status status = safe32_container_writer_init(&writer, segment_length, &layout);
+    if(status != SAFE32_STATUS_OK)
+    {
+        error_unexpected_status_exit(status);
+    }
+
+    // The writer only starts a segment once all of its data is in the buffer.
+    const int64_t decoded_buffer_length = segment_length > BUFFER_SIZE ? segment_length : BUFFER_SIZE;
+    uint8_t* const decoded_buffer = allocate_or_exit(decoded_buffer_length);
+    uint8_t encoded_buffer[BUFFER_SIZE];
+    int64_t decoded_begin = 0;
+    int64_t decoded_end = 0;
+    bool is_at_end = false;
+
+    do
+    {
+        if(!is_at_end && decoded_end - decoded_begin < segment_length)
+        {
+            memmove(decoded_buffer, decoded_buffer + decoded_begin, decoded_end - decoded_begin);
+            decoded_end -= decoded_begin;
+            decoded_begin = 0;
+            while(!is_at_end && decoded_end < decoded_buffer_length)
+            {
+                const int64_t bytes_to_read = decoded_buffer_length - decoded_end;
+                decoded_end += read_from_file(src_file,
+                                              decoded_buffer + decoded_end,
+                                              bytes_to_read < BUFFER_SIZE ? (int)bytes_to_read : BUFFER_SIZE,
+                                              &is_at_end);
+            }
+        }
+
+        const uint8_t* src = decoded_buffer + decoded_begin;
+        uint8_t* dst = encoded_buffer;
+        status = safe32_container_writer_feed(&writer,
+                                              &src,
+                                              decoded_end - decoded_begin,
+                                              &dst,
+                                              sizeof(encoded_buffer),
+                                              is_at_end);
+        if(status != SAFE32_STATUS_OK && status != SAFE32_STATUS_PARTIALLY_COMPLETE)
+        {
+            error_unexpected_status_exit(status);
+        }
+        write_to_file(dst_file, (const char*)encoded_buffer, dst - encoded_buffer);
+        decoded_begin = src - decoded_buffer;
+    } while(status != SAFE32_STATUS_OK);
+
+    free(decoded_buffer);
+    close_file(src_file);
+    close_file(dst_file);
+}
+
+static void decode_container(const char* const filename,
+                             int64_t range_offset,
+                             int64_t range_length)
+{
+    int64_t file_length = 0;
+    FILE* const src_file = open_seekable_file(filename, &file_length);
+    FILE* const dst_file = stdout;
+
+    // Only the trailer, the index, and the segments that are needed get read.
+    // The amount of whitespace after the trailer isn't known, so more of the
+    // end is read until the whole trailer has been found.
+    int64_t trailer_offset = 0;
+    int64_t index_offset = SAFE32_ERROR_TRUNCATED_DATA;
+    for(int64_t end_length = 256; index_offset == SAFE32_ERROR_TRUNCATED_DATA; end_length *= 2)
+    {
+        if(end_length > file_length)
+        {
+            end_length = file_length;
+        }
+        uint8_t* const end_buffer = read_file_range(src_file, file_length - end_length, end_length);
+        index_offset = safe32_container_find_index(end_buffer, end_length, file_length, &trailer_offset);
+        free(end_buffer);
+        if(end_length == file_length)
+        {
+            break;
+        }
+    }
+    if(index_offset < 0)
+    {
+        error_unexpected_status_exit(index_offset);
+    }
+    const int64_t index_length = trailer_offset - index_offset;
+    uint8_t* const index_buffer = read_file_range(src_file, index_offset, index_length);
+    safe32_container container;
+    safe32_status status = safe32_container_open_index(index_buffer, index_length, index_offset, &container);
+    if(status != SAFE32_STATUS_OK)
+    {
+        error_unexpected_status_exit(status);
+    }
+
+    if(range_length < 0)
+    {
+        range_offset = 0;
+        range_length = container.data_length;
+    }
+    if(range_offset > container.data_length)
+    {
+        range_offset = container.data_length;
+    }
+    if(range_length > container.data_length - range_offset)
+    {
+        range_length = container.data_length - range_offset;
+    }
+    const int64_t first_segment = range_offset / container.segment_length;
+    const int64_t end_segment = (range_offset + range_length + container.segment_length - 1) / container.segment_length;
+    int64_t skip_count = range_offset - first_segment * container.segment_length;
+
+    uint8_t* const decoded_buffer = allocate_or_exit(container.segment_length);
+    for(int64_t i = first_segment; i < end_segment && range_length > 0; i++)
+    {
+        int64_t segment_offset = 0;
+        int64_t segment_encoded_length = 0;
+        status = safe32_container_locate_segment(index_buffer,
+                                                 index_length,
+                                                 &container,
+                                                 i,
+                                                 &segment_offset,
+                                                 &segment_encoded_length);
+        if(status != SAFE32_STATUS_OK)
+        {
+            error_unexpected_status_exit(status);
+        }
+        uint8_t* const encoded_buffer = read_file_range(src_file, segment_offset, segment_encoded_length);
+        const int64_t result = safe32l_decode(encoded_buffer,
+                                              segment_encoded_length,
+                                              decoded_buffer,
+                                              container.segment_length);
+        free(encoded_buffer);
+        if(result < 0)
+        {
+            error_unexpected_status_exit(result);
+        }
+        const int64_t remaining_length = container.data_length - i * container.segment_length;
+        if(result != (remaining_length < container.segment_length ? remaining_length : container.segment_length))
+        {
+            error_unexpected_status_exit(SAFE32_ERROR_INVALID_SOURCE_DATA);
+        }
+        const int64_t write_length = result - skip_count < range_length ? result - skip_count : range_length;
+        write_all_to_file(dst_file, decoded_buffer + skip_count, write_length);
+        range_length -= write_length;
+        skip_count = 0;
+    }
+
+    free(decoded_buffer);
+    free(index_buffer);
+    close_file(src_file);
+    close_file(dst_file);
+}
+
+static void decode_range(const char* const filename,
+                         const int line_break_at,
+                         const int indent_count,
+                         const int64_t range_offset,
+                         int64_t range_length)
+{
+    int64_t file_length = 0;
+    FILE* const src_file = open_seekable_file(filename, &file_length);
+    FILE* const dst_file = stdout;
+
+    // Encoded data is never shorter than its decoded form.
+    if(range_length > file_length)
+    {
+        range_length = file_length;
+    }
+
+    // Only the part of the file that the range is encoded in gets read.
+    const safe32_layout layout = {line_break_at, indent_count, false};
+    int64_t src_offset = 0;
+    int64_t src_length = 0;
+    int64_t skip_count = 0;
+    const safe32_status status = safe32_locate_range(range_offset,
+                                                     range_length,
+                                                     &layout,
+                                                     &src_offset,
+                                                     &src_length,
+                                                     &skip_count);
+    if(status != SAFE32_STATUS_OK)
+    {
+        error_unexpected_status_exit(status);
+    }
+    if(src_offset > file_length)
+    {
+        src_offset = file_length;
+    }
+    if(src_length > file_length - src_offset)
+    {
+        src_length = file_length - src_offset;
+    }
+
+    uint8_t* const encoded_buffer = read_file_range(src_file, src_offset, src_length);
+    const int64_t decoded_length = safe32_get_decoded_length(src_length);
+    uint8_t* const decoded_buffer = allocate_or_exit(decoded_length);
+    const int64_t result = safe32_decode(encoded_buffer, src_length, decoded_buffer, decoded_length);
+    if(result < 0)
+    {
+        error_unexpected_status_exit(result);
+    }
+    if(result > skip_count)
+    {
+        write_all_to_file(dst_file,
+                          decoded_buffer + skip_count,
+                          result - skip_count < range_length ? result - skip_count : range_length);
+    }
+
+    free(decoded_buffer);
+    free(encoded_buffer);
+    close_file(src_file);
+    close_file(dst_file);
+}
+
+static void transcode(const char* const filename,
+                      const safe32_standard_format format,
+                      const bool is_encoding)
+{
+    FILE* const src_file = open_file(filename);
+    FILE* const dst_file = stdout;
+
+    safe32_standard_transcoder transcoder;
+    safe32_status status = is_encoding
+        ? safe32_standard_transcoder_init_from_standard(&transcoder, format)
+        : safe32_standard_transcoder_init_to_standard(&transcoder, format, true);
+    if(status != SAFE32_STATUS_OK)
+    {
+        error_unexpected_status_exit(status);
+    }
+
+    uint8_t src_buffer[BUFFER_SIZE];
+    uint8_t dst_buffer[BUFFER_SIZE];
+    int src_buffer_offset = 0;
+    bool is_at_end = false;
+
+    do
+    {
+        int bytes_read = 0;
+        if(!is_at_end)
+        {
+            bytes_read = read_from_file(src_file,
+                                        src_buffer + src_buffer_offset,
+                                        sizeof(src_buffer) - src_buffer_offset,
+                                        &is_at_end);
+        }
+
+        const int bytes_to_process = src_buffer_offset + bytes_read;
+        const uint8_t* src = src_buffer;
+        uint8_t* dst = dst_buffer;
+        status = safe32_standard_transcoder_feed(&transcoder,
+                                                 &src,
+                                                 bytes_to_process,
+                                                 &dst,
+                                                 sizeof(dst_buffer),
+                                                 is_at_end);
+        if(status != SAFE32_STATUS_OK && status != SAFE32_STATUS_PARTIALLY_COMPLETE)
+        {
+            error_unexpected_status_exit(status);
+        }
+        write_to_file(dst_file, (const char*)dst_buffer, dst - dst_buffer);
+
+        src_buffer_offset = bytes_to_process - (src - src_buffer);
+        memmove(src_buffer, src, src_buffer_offset);
+    } while(status != SAFE32_STATUS_OK);
+
+    close_file(src_file);
+    close_file(dst_file);
+}
+
+static bool parse_standard_format(const char* const name, safe32_standard_format* const format)
+{
+    static const struct
+    {
+        const char* name;
+        safe32_standard_format format;
+    } formats[] =
+    {
+        {"base64", SAFE32_FORMAT_BASE64},
+        {"base64url", SAFE32_FORMAT_BASE64URL},
+        {"base32", SAFE32_FORMAT_BASE32},
+        {"base16", SAFE32_FORMAT_BASE16},
+        {"hex", SAFE32_FORMAT_BASE16},
+    };
+    for(size_t i = 0; i < sizeof(formats) / sizeof(*formats); i++)
+    {
+        if(strcmp(name, formats[i].name) == 0)
+        {
+            *format = formats[i].format;
+            return true;
+        }
+    }
+    return false;
+}
+
 
 // ---------------------------
 // Startup & command line args
@@ -353,6 +689,12 @@ Options:\n\
   -l: Encode/decode safe64l (with a length field)\n\
   -n <count>: Insert a newline every <count> encoded characters\n\
   -i <count>: Insert <count> spaces indentation on each line\n\
+              (when decoding, -n and -i describe the source's layout)\n\
+  -c: Encode/decode a seekable container\n\
+  -s <size>: Use <size> byte segments in a seekable container (default 1048576)\n\
+  -r <offset>,<length>: Decode only <length> bytes starting at <offset>\n\
+  -t <format>: Transcode from <format> to safe32 (or from safe32 to <format> with -d),\n\
+               where <format> is base64, base64url, base32, or base16 (hex)\n\
 \n\
 File: If not specified, - (read from stdin) is assumed.\n\
 ", EXPAND_AND_QUOTE(PROJECT_VERSION), basename(g_argv_0));
@@ -375,10 +717,16 @@ int main(const int argc, char** const argv)
     int ch;
     bool is_encoding = true;
     bool use_length_fields = false;
+    bool use_container = false;
     int line_break_at = 0;
     int indent_count = 0;
+    long long segment_length = 1048576;
+    long long range_offset = 0;
+    long long range_length = -1;
+    bool use_standard_format = false;
+    safe32_standard_format standard_format = SAFE32_FORMAT_BASE64;
 
-    while((ch = getopt(argc, argv, "?hvdln:i:")) >= 0)
+    while((ch = getopt(argc, argv, "?hvdln:i:cs:r:t:")) >= 0)
     {
         switch(ch)
         {
@@ -401,6 +749,26 @@ int main(const int argc, char** const argv)
             case 'i':
                 sscanf(optarg, "%d", &indent_count);
                 break;
+            case 'c':
+                use_container = true;
+                break;
+            case 's':
+                sscanf(optarg, "%lld", &segment_length);
+                break;
+            case 'r':
+                if(sscanf(optarg, "%lld,%lld", &range_offset, &range_length) != 2 ||
+                   range_offset < 0 || range_length < 0)
+                {
+                    print_usage_error_exit();
+                }
+                break;
+            case 't':
+                if(!parse_standard_format(optarg, &standard_format))
+                {
+                    print_usage_error_exit();
+                }
+                use_standard_format = true;
+                break;
             default:
                 printf("Unknown option: %d %c\n", ch, ch);
                 print_usage_error_exit();
@@ -409,13 +777,51 @@ int main(const int argc, char** const argv)
 
     const char* const filename = (optind < argc) ? argv[optind] : "-";
 
+    if(use_container && use_length_fields)
+    {
+        error_exit("-c cannot be combined with -l\n");
+    }
+    if(range_length >= 0 && (is_encoding || use_length_fields))
+    {
+        error_exit("-r can only be used when decoding without -l\n");
+    }
+    if(use_standard_format && (use_length_fields || use_container || range_length >= 0 ||
+                               line_break_at > 0 || indent_count > 0))
+    {
+        error_exit("-t cannot be combined with -l, -c, -r, -n, or -i\n");
+    }
+
+    if(use_standard_format)
+    {
+        transcode(filename, standard_format, is_encoding);
+        return 0;
+    }
+
     if(is_encoding)
     {
-        encode(filename, use_length_fields, line_break_at, indent_count);
+        if(use_container)
+        {
+            encode_container(filename, segment_length, line_break_at, indent_count);
+        }
+        else
+        {
+            encode(filename, use_length_fields, line_break_at, indent_count);
+        }
     }
     else
     {
-        decode(filename, use_length_fields);
+        if(use_container)
+        {
+            decode_container(filename, range_offset, range_length);
+        }
+        else if(range_length >= 0)
+        {
+            decode_range(filename, line_break_at, indent_count, range_offset, range_length);
+        }
+        else
+        {
+            decode(filename, use_length_fields, line_break_at, indent_count);
+        }
     }
 
     return 0;
@@ -0,0 +1 @@
+../../../common/codec_engine.h
\ No newline at end of file
@@ -0,0 +1,4 @@
+// Compiles the library from the generated single header rather than from
+// src/library.c, so that the test suite exercises the amalgamated build.
+#define SAFE32_IMPLEMENTATION
+#include "safe32_amalgamated.h"
@@ -0,0 +1,4 @@
+// Compiles the library from the generated single header rather than from
+// src/library.c, so that the test suite exercises the amalgamated build.
+#define SAFE64_IMPLEMENTATION
+#include "safe64_amalgamated.h"
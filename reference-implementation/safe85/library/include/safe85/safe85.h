@@ -66,6 +66,22 @@ typedef enum
      * There wasn't enough room in the bufer to complete the operation.
      */
     SAFE85_ERROR_NOT_ENOUGH_ROOM = -6,
+
+    /**
+     * The allocator could not provide the memory required for the operation.
+     */
+    SAFE85_ERROR_ALLOCATION_FAILED = -7,
+
+    /**
+     * The source data is longer than the length field specifies.
+     */
+    SAFE85_ERROR_TOO_MUCH_DATA = -8,
+
+    /**
+     * A custom alphabet was invalid (see safe85_alphabet_init()), or a
+     * standard format was unknown.
+     */
+    SAFE85_ERROR_INVALID_ALPHABET = -9,
 } safe85_status;
 
 /**
@@ -97,6 +113,265 @@ typedef enum
     SAFE85_DST_IS_AT_END_OF_STREAM = 4,
 } safe85_stream_state;
 
+/**
+ * Allocates memory for the output of an operation.
+ *
+ * @param context The context pointer that was passed to the operation.
+ * @param size The number of bytes required.
+ * @return A pointer to the allocated memory, or NULL if it couldn't be allocated.
+ */
+typedef void* (*safe85_allocate_function)(void* context, int64_t size);
+
+/**
+ * Encodes binary data in another codec. safe16_encode(), safe32_encode(),
+ * safe64_encode(), safe80_encode() and safe85_encode() all have this
+ * signature.
+ */
+typedef int64_t (*safe85_encode_function)(const uint8_t* src_buffer,
+                                          int64_t src_buffer_length,
+                                          uint8_t* dst_buffer,
+                                          int64_t dst_buffer_length);
+
+/**
+ * A simple bump allocator over a caller-supplied buffer.
+ * Pass safe85_arena_allocate as the allocator and a pointer to the arena as
+ * the context. Set used to 0 to reuse the arena.
+ */
+typedef struct
+{
+    uint8_t* buffer;
+    int64_t length;
+    int64_t used;
+} safe85_arena;
+
+/**
+ * Describes how encoded text is laid out into lines, as produced by
+ * safe85_encode_with_layout() and the safe85 command line tool's -n and -i
+ * options: Every line (including the first) starts with indent_length spaces,
+ * followed by up to line_length encoded characters, followed by a line break.
+ */
+typedef struct
+{
+    /**
+     * The number of encoded characters per line, or 0 for no line breaks.
+     */
+    int64_t line_length;
+
+    /**
+     * The number of spaces at the start of each line.
+     */
+    int64_t indent_length;
+
+    /**
+     * If true, lines end with CR LF instead of LF.
+     */
+    bool use_crlf;
+} safe85_layout;
+
+/**
+ * The standard RFC 4648 encodings that safe85 can transcode to and from.
+ */
+typedef enum
+{
+    /**
+     * Base 64, using '+' and '/' (RFC 4648 section 4).
+     */
+    SAFE85_FORMAT_BASE64 = 0,
+
+    /**
+     * Base 64 with the URL and filename safe alphabet, using '-' and '_'
+     * (RFC 4648 section 5).
+     */
+    SAFE85_FORMAT_BASE64URL = 1,
+
+    /**
+     * Base 32 (RFC 4648 section 6).
+     */
+    SAFE85_FORMAT_BASE32 = 2,
+
+    /**
+     * Base 16 (hex) (RFC 4648 section 8). Lowercase is also accepted when
+     * transcoding from it.
+     */
+    SAFE85_FORMAT_BASE16 = 3,
+} safe85_standard_format;
+
+/**
+ * Information about a seekable safe85 container, as read by
+ * safe85_container_open() or safe85_container_open_index(). Treat the fields
+ * as read-only.
+ */
+typedef struct
+{
+    /**
+     * The total length of the data once decoded.
+     */
+    int64_t data_length;
+
+    /**
+     * The decoded length of each segment (the last one may be shorter).
+     */
+    int64_t segment_length;
+
+    /**
+     * The number of segments.
+     */
+    int64_t segment_count;
+
+    /**
+     * Offset of the index record.
+     */
+    int64_t index_offset;
+
+    /**
+     * Offset of the index record's encoded data (following its length field).
+     */
+    int64_t index_data_offset;
+
+    /**
+     * Offset of the trailer (the end of the index record).
+     */
+    int64_t trailer_offset;
+} safe85_container;
+
+/**
+ * A custom alphabet, as built by safe85_alphabet_init(). Treat the fields as
+ * read-only.
+ */
+typedef struct
+{
+    /**
+     * Maps each character to its chunk value when decoding.
+     */
+    uint8_t char_to_chunk[256];
+
+    /**
+     * Maps each chunk value to its character when encoding.
+     */
+    uint8_t chunk_to_char[85];
+} safe85_alphabet;
+
+/**
+ * State for transcoding safe85 into another codec in pieces.
+ * Initialize with safe85_transcoder_init() and treat the fields as opaque.
+ */
+typedef struct
+{
+    safe85_encode_function encode;
+    int64_t tile_length;
+    uint8_t tile[4096];
+} safe85_transcoder;
+
+/**
+ * State for transcoding between safe85 and a standard format in pieces.
+ * Initialize with safe85_standard_transcoder_init_from_standard() or
+ * safe85_standard_transcoder_init_to_standard() and treat the fields as opaque.
+ */
+typedef struct
+{
+    safe85_standard_format format;
+    bool is_to_standard;
+    bool use_padding;
+    bool is_padding_seen;
+    uint32_t bits;
+    int bit_count;
+    int64_t char_count;
+    int64_t tile_offset;
+    int64_t tile_length;
+    uint8_t tile[4096];
+    uint8_t char_to_value[256];
+} safe85_standard_transcoder;
+
+/**
+ * State for decoding a safe85L (safe85 + length) sequence in pieces.
+ * Initialize with safe85l_decoder_init() and treat the fields as read-only.
+ */
+typedef struct
+{
+    /**
+     * The length declared by the length field, or -1 if it hasn't been read yet.
+     */
+    int64_t declared_length;
+
+    /**
+     * The number of bytes decoded so far.
+     */
+    int64_t decoded_length;
+
+    int64_t length_field_value;
+} safe85l_decoder;
+
+/**
+ * The location of a safe85L record within a stream of back-to-back records.
+ */
+typedef struct
+{
+    /**
+     * Offset of the start of the record's length field.
+     */
+    int64_t offset;
+
+    /**
+     * Number of characters from the start of the length field to the end of
+     * the record (including any whitespace within).
+     */
+    int64_t encoded_length;
+
+    /**
+     * The length of the record's data once decoded.
+     */
+    int64_t decoded_length;
+} safe85l_record_span;
+
+/**
+ * State for encoding a safe85L (safe85 + length) sequence in pieces.
+ * Initialize with safe85l_encoder_init() and treat the fields as read-only.
+ */
+typedef struct
+{
+    /**
+     * The length of the data to encode, as written to the length field.
+     */
+    int64_t declared_length;
+
+    /**
+     * The number of source bytes encoded so far.
+     */
+    int64_t encoded_length;
+
+    bool has_written_length_field;
+} safe85l_encoder;
+
+/**
+ * State for encoding into a layout in pieces.
+ * Initialize with safe85_layout_encoder_init() or safe85l_layout_encoder_init()
+ * and treat the fields as opaque.
+ */
+typedef struct
+{
+    safe85_layout layout;
+    int64_t declared_length;
+    int64_t encoded_length;
+    int64_t column;
+    int64_t separator_offset;
+    uint8_t pending[32];
+    int pending_offset;
+    int pending_length;
+} safe85_layout_encoder;
+
+/**
+ * State for writing a seekable container in pieces.
+ * Initialize with safe85_container_writer_init() and treat the fields as opaque.
+ */
+typedef struct
+{
+    safe85_layout_encoder encoder;
+    int64_t segment_length;
+    int64_t data_length;
+    int64_t position;
+    int stage;
+} safe85_container_writer;
+
 
 
 // --------------
@@ -217,118 +492,1578 @@ SAFE85_PUBLIC int64_t safe85l_encode(const uint8_t* src_buffer,
                                      uint8_t* dst_buffer,
                                      int64_t dst_buffer_length);
 
-
-
-// -------------
-// Low Level API
-// -------------
-
 /**
- * Read a length field from a buffer.
+ * Encodes a batch of independent records in one call.
+ * The records are written back to back into dst_buffer, and the offset of
+ * each record is stored in dst_offsets.
+ *
+ * All lengths are validated and the required space is calculated before
+ * anything gets encoded, so the batch either completes in full or writes
+ * nothing.
  *
  * Can return the following status codes:
- *  * SAFE85_ERROR_INVALID_LENGTH: The buffer length was negative.
- *  * SAFE85_ERROR_UNTERMINATED_LENGTH_FIELD: The length field is truncated.
+ *  * SAFE85_ERROR_INVALID_LENGTH: A length or the record count was negative.
+ *  * SAFE85_ERROR_NOT_ENOUGH_ROOM: The destination buffer was not big enough.
  *
- * @param buffer Where to read the length field from.
- * @param buffer_length Length of the buffer.
- * @param length Pointer to where the length value should be stored.
- * @return the number of bytes processed to read the length, or an error code.
+ * @param src_buffers The binary data of each record.
+ * @param src_lengths The length in bytes of each record.
+ * @param record_count The number of records.
+ * @param dst_buffer A buffer to store the encoded records.
+ * @param dst_buffer_length The length of the destination buffer.
+ * @param dst_offsets Storage for record_count + 1 offsets. Record i will be
+ *                    stored from dst_offsets[i] to dst_offsets[i+1].
+ * @return the total number of bytes written, or a status code.
  */
-SAFE85_PUBLIC int64_t safe85_read_length_field(const uint8_t* buffer,
-                                               int64_t buffer_length,
-                                               int64_t* length);
+SAFE85_PUBLIC int64_t safe85_encode_batch(const uint8_t* const* src_buffers,
+                                          const int64_t* src_lengths,
+                                          int64_t record_count,
+                                          uint8_t* dst_buffer,
+                                          int64_t dst_buffer_length,
+                                          int64_t* dst_offsets);
 
 /**
- * Decode part of a safe85 sequence.
+ * Decodes a batch of independent safe85 records in one call.
+ * Each record is expected to be a COMPLETE sequence. The decoded records are
+ * written back to back into dst_buffer, and the offset of each record is
+ * stored in dst_offsets.
  *
- * This is a lower level function for buffered I/O.
+ * If any record fails to decode, processing stops and the status code is
+ * returned. The contents of dst_buffer and dst_offsets are then undefined.
  *
- * Attempts to decode and write as much as it can based on the input data.
- * This function will not attempt to write a trailing partial group unless
- * stream_state contains SAFE85_SRC_IS_AT_END_OF_STREAM or SAFE85_DST_IS_AT_END_OF_STREAM.
+ * Can return the following status codes:
+ *  * SAFE85_ERROR_INVALID_LENGTH: A length or the record count was negative.
+ *  * SAFE85_ERROR_INVALID_SOURCE_DATA: A record contained invalid data.
+ *  * SAFE85_ERROR_NOT_ENOUGH_ROOM: The destination buffer was not big enough.
  *
- * Upon return:
+ * @param src_buffers The encoded data of each record.
+ * @param src_lengths The length in bytes of each record.
+ * @param record_count The number of records.
+ * @param dst_buffer A buffer to store the decoded records.
+ * @param dst_buffer_length The length of the destination buffer.
+ * @param dst_offsets Storage for record_count + 1 offsets. Record i will be
+ *                    stored from dst_offsets[i] to dst_offsets[i+1].
+ * @return the total number of bytes written, or a status code.
+ */
+SAFE85_PUBLIC int64_t safe85_decode_batch(const uint8_t* const* src_buffers,
+                                          const int64_t* src_lengths,
+                                          int64_t record_count,
+                                          uint8_t* dst_buffer,
+                                          int64_t dst_buffer_length,
+                                          int64_t* dst_offsets);
+
+/**
+ * Compares two safe85 sequences by the binary data they represent, without
+ * decoding them. The result is the same as comparing the decoded data
+ * byte-by-byte, with a shorter sequence ordering before a longer one that it
+ * is a prefix of.
  *
- *   src_buffer_ptr will point to the next character it will read.
- *   If it's not pointing to the end of the input buffer, the remaining
- *   characters need to be moved to the beginning of the buffer, and then more
- *   input data added.
+ * Whitespace is ignored, and trailing partial groups are handled correctly.
  *
- *   dst_buffer_ptr will point to one past the last byte written.
+ * Can return the following status codes:
+ *  * SAFE85_ERROR_INVALID_LENGTH: A length was negative.
+ *  * SAFE85_ERROR_INVALID_SOURCE_DATA: One of the sequences was invalid.
+ *
+ * @param a_buffer The first safe85 sequence.
+ * @param a_length The length in bytes of the first sequence.
+ * @param b_buffer The second safe85 sequence.
+ * @param b_length The length in bytes of the second sequence.
+ * @param result Where to store the result: negative if a sorts before b,
+ *               positive if a sorts after b, 0 if they are equal.
+ * @return Status code indicating the result of the operation.
+ */
+SAFE85_PUBLIC safe85_status safe85_compare_encoded(const uint8_t* a_buffer,
+                                                   int64_t a_length,
+                                                   const uint8_t* b_buffer,
+                                                   int64_t b_length,
+                                                   int* result);
+
+/**
+ * Compares a safe85 sequence to some binary data, as if the sequence had
+ * been decoded first.
+ *
+ * Whitespace is ignored, and trailing partial groups are handled correctly.
  *
  * Can return the following status codes:
- *  * SAFE85_STATUS_OK: The process completed successfully.
- *  * SAFE85_STATUS_PARTIALLY_COMPLETE: The process completed, but not all data was written.
  *  * SAFE85_ERROR_INVALID_LENGTH: A length was negative.
- *  * SAFE85_ERROR_INVALID_SOURCE_DATA: The data was invalid.
- *  * SAFE85_ERROR_NOT_ENOUGH_ROOM: The destination buffer was not big enough.
- *  * SAFE85_ERROR_TRUNCATED_DATA: The source data was truncated.
+ *  * SAFE85_ERROR_INVALID_SOURCE_DATA: The sequence was invalid.
  *
- * @param src_buffer_ptr Pointer to your source buffer pointer (input/output).
- * @param src_length Length of the source buffer.
- * @param dst_buffer_ptr Pointer to your destination buffer pointer (input/output).
- * @param dst_length Length of the destination buffer.
- * @param is_end_of_data If true, this is the last packet of data to decode.
+ * @param encoded_buffer The safe85 sequence.
+ * @param encoded_length The length in bytes of the sequence.
+ * @param binary_buffer The binary data.
+ * @param binary_length The length in bytes of the binary data.
+ * @param result Where to store the result: negative if the sequence sorts
+ *               before the binary data, positive if it sorts after, 0 if
+ *               they are equal.
  * @return Status code indicating the result of the operation.
  */
-SAFE85_PUBLIC safe85_status safe85_decode_feed(const uint8_t** src_buffer_ptr,
-                                               int64_t src_length,
-                                               uint8_t** dst_buffer_ptr,
-                                               int64_t dst_length,
-                                               safe85_stream_state stream_state);
+SAFE85_PUBLIC safe85_status safe85_compare_encoded_to_binary(const uint8_t* encoded_buffer,
+                                                             int64_t encoded_length,
+                                                             const uint8_t* binary_buffer,
+                                                             int64_t binary_length,
+                                                             int* result);
 
 /**
- * Write a length field to a buffer.
+ * Calculates the tightest range of safe85 sequences that contains the
+ * encoding of every piece of binary data starting with the specified prefix.
+ * This allows prefix queries over binary keys to be pushed down to stores
+ * that are sorted by their safe85 encoded form.
+ *
+ * The encoding s of every matching key satisfies lo <= s < hi in plain
+ * byte-wise (strcmp) order. When the prefix doesn't end on a group boundary,
+ * some keys that don't match can also fall inside the range, so candidates
+ * must still be checked (e.g. using safe85_compare_encoded_to_binary()).
+ *
+ * Only canonical sequences (as written by the encoder, with no whitespace)
+ * are covered.
+ *
+ * To search a binary range [lo, hi), use the longest common prefix of lo and
+ * hi as the prefix.
+ *
+ * Each buffer needs room for the encoded prefix plus one extra group, which
+ * is at most safe85_get_encoded_length(prefix_length, false) + 5 bytes.
  *
  * Can return the following status codes:
  *  * SAFE85_ERROR_INVALID_LENGTH: A length was negative.
- *  * SAFE85_STATUS_NOT_ENOUGH_ROOM: The destination buffer was not big enough.
+ *  * SAFE85_ERROR_NOT_ENOUGH_ROOM: One of the buffers was not big enough.
  *
- * @param length The length value to write.
- * @param dst_buffer Where to write the length field.
- * @param dst_buffer_length Length of the destination buffer.
- * @return The number of bytes written, or an error code.
+ * @param prefix_buffer The binary prefix.
+ * @param prefix_length The length in bytes of the prefix.
+ * @param lo_buffer A buffer to store the inclusive lower bound.
+ * @param lo_length The length of lo_buffer (input), and the length of the
+ *                  lower bound (output).
+ * @param hi_buffer A buffer to store the exclusive upper bound.
+ * @param hi_length The length of hi_buffer (input), and the length of the
+ *                  upper bound (output). 0 means that there is no upper bound.
+ * @return Status code indicating the result of the operation.
  */
-SAFE85_PUBLIC int64_t safe85_write_length_field(int64_t length,
-                                                uint8_t* dst_buffer,
-                                                int64_t dst_buffer_length);
+SAFE85_PUBLIC safe85_status safe85_encoded_range_for_prefix(const uint8_t* prefix_buffer,
+                                                            int64_t prefix_length,
+                                                            uint8_t* lo_buffer,
+                                                            int64_t* lo_length,
+                                                            uint8_t* hi_buffer,
+                                                            int64_t* hi_length);
 
 /**
- * Encode a partial sequence of binary data.
+ * Allocates memory from a safe85_arena. Can be used as a
+ * safe85_allocate_function, with a pointer to the arena as the context.
  *
- * This is a lower level function for buffered I/O.
+ * @param arena The arena to allocate from.
+ * @param size The number of bytes required.
+ * @return A pointer to the allocated memory, or NULL if the arena is full.
+ */
+SAFE85_PUBLIC void* safe85_arena_allocate(void* arena, int64_t size);
+
+/**
+ * Get the exact number of bytes that a complete safe85 sequence will decode
+ * to. Unlike safe85_get_decoded_length(), whitespace is taken into account.
  *
- * Attempts to encode and write as much as it can based on the input data.
- * This function will not attempt to write a trailing partial group unless
- * is_end_of_data is set.
+ * Can return the following status codes:
+ *  * SAFE85_ERROR_INVALID_LENGTH: The length was negative.
+ *  * SAFE85_ERROR_INVALID_SOURCE_DATA: The data was invalid.
  *
- * Upon return:
+ * @param src_buffer The buffer containing the complete safe85 sequence.
+ * @param src_buffer_length The length in bytes of the sequence.
+ * @return The length of the decoded data, or a status code.
+ */
+SAFE85_PUBLIC int64_t safe85_get_decoded_length_exact(const uint8_t* src_buffer,
+                                                      int64_t src_buffer_length);
+
+/**
+ * Completely encodes some binary data into memory obtained from an allocator.
+ * Exactly as many bytes as are needed get allocated, in a single allocation.
  *
- *   src_buffer_ptr will point to the next character it will read.
- *   If it's not pointing to the end of the input buffer, the remaining
- *   characters need to be moved to the beginning of the buffer, and then more
- *   input data added.
+ * Can return the following status codes:
+ *  * SAFE85_ERROR_INVALID_LENGTH: A length was negative.
+ *  * SAFE85_ERROR_ALLOCATION_FAILED: The allocator returned NULL.
  *
- *   dst_buffer_ptr will point to one past the last byte written.
+ * @param src_buffer The buffer containing the complete binary data.
+ * @param src_buffer_length The length in bytes of the data.
+ * @param allocate The allocator to get the destination memory from.
+ * @param context The context to pass to the allocator.
+ * @param dst_buffer Where to store a pointer to the encoded data. If the
+ *                   result is empty, nothing is allocated and this is set to NULL.
+ * @return the number of bytes written, or a status code.
+ */
+SAFE85_PUBLIC int64_t safe85_encode_alloc(const uint8_t* src_buffer,
+                                          int64_t src_buffer_length,
+                                          safe85_allocate_function allocate,
+                                          void* context,
+                                          uint8_t** dst_buffer);
+
+/**
+ * Completely encodes a length field & some binary data into memory obtained
+ * from an allocator.
+ * Exactly as many bytes as are needed get allocated, in a single allocation.
  *
  * Can return the following status codes:
- *  * SAFE85_STATUS_OK: The process completed successfully.
- *  * SAFE85_STATUS_PARTIALLY_COMPLETE: The process completed, but not all data was written.
  *  * SAFE85_ERROR_INVALID_LENGTH: A length was negative.
+ *  * SAFE85_ERROR_ALLOCATION_FAILED: The allocator returned NULL.
  *
- * @param src_buffer_ptr Pointer to your source buffer pointer (input/output).
- * @param src_length Length of the source buffer.
- * @param dst_buffer_ptr Pointer to your destination buffer pointer (input/output).
- * @param dst_length Length of the destination buffer.
- * @param is_end_of_data If true, this is the last packet of data to encode.
- * @return Status code indicating the result of the operation.
+ * @param src_buffer The buffer containing the complete binary data.
+ * @param src_buffer_length The length in bytes of the data.
+ * @param allocate The allocator to get the destination memory from.
+ * @param context The context to pass to the allocator.
+ * @param dst_buffer Where to store a pointer to the encoded data. If the
+ *                   result is empty, nothing is allocated and this is set to NULL.
+ * @return the number of bytes written, or a status code.
  */
-SAFE85_PUBLIC safe85_status safe85_encode_feed(const uint8_t** src_buffer_ptr,
-                                               int64_t src_length,
-                                               uint8_t** dst_buffer_ptr,
-                                               int64_t dst_length,
-                                               bool is_end_of_data);
+SAFE85_PUBLIC int64_t safe85l_encode_alloc(const uint8_t* src_buffer,
+                                           int64_t src_buffer_length,
+                                           safe85_allocate_function allocate,
+                                           void* context,
+                                           uint8_t** dst_buffer);
+
+/**
+ * Completely decodes a safe85 sequence into memory obtained from an allocator.
+ * The source is validated before allocating, and exactly as many bytes as are
+ * needed get allocated (taking whitespace into account), in a single
+ * allocation. Nothing is allocated if an error occurs.
+ *
+ * Can return the following status codes:
+ *  * SAFE85_ERROR_INVALID_LENGTH: A length was negative.
+ *  * SAFE85_ERROR_INVALID_SOURCE_DATA: The data was invalid.
+ *  * SAFE85_ERROR_ALLOCATION_FAILED: The allocator returned NULL.
+ *
+ * @param src_buffer The buffer containing the complete safe85 sequence.
+ * @param src_buffer_length The length in bytes of the sequence.
+ * @param allocate The allocator to get the destination memory from.
+ * @param context The context to pass to the allocator.
+ * @param dst_buffer Where to store a pointer to the decoded data. If the
+ *                   result is empty, nothing is allocated and this is set to NULL.
+ * @return the number of bytes written, or a status code.
+ */
+SAFE85_PUBLIC int64_t safe85_decode_alloc(const uint8_t* src_buffer,
+                                          int64_t src_buffer_length,
+                                          safe85_allocate_function allocate,
+                                          void* context,
+                                          uint8_t** dst_buffer);
+
+/**
+ * Completely decodes a safe85L (safe85 + length) sequence into memory
+ * obtained from an allocator.
+ * The source is validated before allocating, and exactly as many bytes as
+ * the length field specifies get allocated, in a single allocation. Nothing
+ * is allocated if an error occurs.
+ *
+ * Can return the following status codes:
+ *  * SAFE85_ERROR_INVALID_LENGTH: A length was negative.
+ *  * SAFE85_ERROR_INVALID_SOURCE_DATA: The data was invalid.
+ *  * SAFE85_ERROR_UNTERMINATED_LENGTH_FIELD: The length field is truncated.
+ *  * SAFE85_ERROR_TRUNCATED_DATA: The source data is truncated.
+ *  * SAFE85_ERROR_ALLOCATION_FAILED: The allocator returned NULL.
+ *
+ * @param src_buffer The buffer containing the complete safe85L sequence.
+ * @param src_buffer_length The length in bytes of the sequence.
+ * @param allocate The allocator to get the destination memory from.
+ * @param context The context to pass to the allocator.
+ * @param dst_buffer Where to store a pointer to the decoded data. If the
+ *                   result is empty, nothing is allocated and this is set to NULL.
+ * @return the number of bytes written, or a status code.
+ */
+SAFE85_PUBLIC int64_t safe85l_decode_alloc(const uint8_t* src_buffer,
+                                           int64_t src_buffer_length,
+                                           safe85_allocate_function allocate,
+                                           void* context,
+                                           uint8_t** dst_buffer);
+
+/**
+ * Locate the first safe85L record in a buffer without decoding it.
+ *
+ * The record's end is calculated from its length field. If
+ * may_contain_whitespace is false, the record is assumed to contain no
+ * whitespace, so the end is found without reading the record's data at all,
+ * and the data is not validated. Otherwise, the record's characters are
+ * counted (skipping and validating as it goes), and any whitespace before
+ * the record is skipped.
+ *
+ * Can return the following status codes:
+ *  * SAFE85_ERROR_INVALID_LENGTH: The length was negative.
+ *  * SAFE85_ERROR_INVALID_SOURCE_DATA: The data was invalid.
+ *  * SAFE85_ERROR_UNTERMINATED_LENGTH_FIELD: The length field is truncated.
+ *  * SAFE85_ERROR_TRUNCATED_DATA: The record extends past the end of the buffer.
+ *
+ * @param src_buffer The buffer containing the records.
+ * @param src_buffer_length The length in bytes of the buffer.
+ * @param may_contain_whitespace If true, allow for whitespace.
+ * @param span Where to store the location of the record.
+ * @return The offset where the next record begins, or a status code.
+ */
+SAFE85_PUBLIC int64_t safe85l_scan_record(const uint8_t* src_buffer,
+                                          int64_t src_buffer_length,
+                                          bool may_contain_whitespace,
+                                          safe85l_record_span* span);
+
+/**
+ * Build an index of all safe85L records in a buffer of back-to-back records,
+ * without decoding them. See safe85l_scan_record() for how records are found.
+ *
+ * Pass NULL as spans to count the records without storing their locations.
+ *
+ * Can return the following status codes:
+ *  * SAFE85_ERROR_INVALID_LENGTH: A length was negative.
+ *  * SAFE85_ERROR_INVALID_SOURCE_DATA: The data was invalid.
+ *  * SAFE85_ERROR_UNTERMINATED_LENGTH_FIELD: A length field is truncated.
+ *  * SAFE85_ERROR_TRUNCATED_DATA: The last record extends past the end of the buffer.
+ *  * SAFE85_ERROR_NOT_ENOUGH_ROOM: There are more than span_count records.
+ *
+ * @param src_buffer The buffer containing the records.
+ * @param src_buffer_length The length in bytes of the buffer.
+ * @param may_contain_whitespace If true, allow for whitespace.
+ * @param spans Where to store the location of each record (can be NULL).
+ * @param span_count The number of entries spans can hold.
+ * @return The number of records, or a status code.
+ */
+SAFE85_PUBLIC int64_t safe85l_index_records(const uint8_t* src_buffer,
+                                            int64_t src_buffer_length,
+                                            bool may_contain_whitespace,
+                                            safe85l_record_span* spans,
+                                            int64_t span_count);
+
+/**
+ * Decode a range of bytes from the middle of a safe85 sequence, without
+ * decoding anything before it.
+ *
+ * Since fixed size byte groups map to fixed size character groups, the
+ * characters covering the range can be located arithmetically, provided
+ * that the sequence contains no whitespace (pass NULL as layout), or that
+ * it is laid out exactly as described by layout.
+ *
+ * If the range extends past the end of the data, only the bytes up to the
+ * end are decoded.
+ *
+ * Can return the following status codes:
+ *  * SAFE85_ERROR_INVALID_LENGTH: A length or offset was negative.
+ *  * SAFE85_ERROR_INVALID_SOURCE_DATA: The data was invalid.
+ *  * SAFE85_ERROR_NOT_ENOUGH_ROOM: dst_buffer_length is less than byte_count.
+ *
+ * @param src_buffer The buffer containing the complete safe85 sequence.
+ * @param src_buffer_length The length in bytes of the sequence.
+ * @param byte_offset The offset of the first byte to decode.
+ * @param byte_count The number of bytes to decode.
+ * @param dst_buffer A buffer to store the decoded data.
+ * @param dst_buffer_length The length of the destination buffer.
+ * @param layout The layout of the sequence, or NULL if it contains no whitespace.
+ * @return The number of bytes written, or a status code.
+ */
+SAFE85_PUBLIC int64_t safe85_decode_range(const uint8_t* src_buffer,
+                                          int64_t src_buffer_length,
+                                          int64_t byte_offset,
+                                          int64_t byte_count,
+                                          uint8_t* dst_buffer,
+                                          int64_t dst_buffer_length,
+                                          const safe85_layout* layout);
+
+/**
+ * Find the part of a safe85 sequence that safe85_decode_range() would decode
+ * for a range of bytes, so that only that part needs to be read (for example
+ * from a file). Decoding those characters with safe85_decode() produces
+ * skip_count bytes to discard, followed by the range.
+ *
+ * The part may extend past the end of the sequence, in which case only what
+ * exists needs to be read.
+ *
+ * Can return the following status codes:
+ *  * SAFE85_ERROR_INVALID_LENGTH: A length or offset was negative.
+ *
+ * @param byte_offset The offset of the first byte to decode.
+ * @param byte_count The number of bytes to decode.
+ * @param layout The layout of the sequence, or NULL if it contains no whitespace.
+ * @param src_offset Where to store the offset of the part to read.
+ * @param src_length Where to store the length of the part to read.
+ * @param skip_count Where to store the number of decoded bytes that precede the range.
+ * @return The status.
+ */
+SAFE85_PUBLIC safe85_status safe85_locate_range(int64_t byte_offset,
+                                                int64_t byte_count,
+                                                const safe85_layout* layout,
+                                                int64_t* src_offset,
+                                                int64_t* src_length,
+                                                int64_t* skip_count);
+
+/**
+ * Get the length of binary data once encoded into a layout.
+ *
+ * Can return the following status codes:
+ *  * SAFE85_ERROR_INVALID_LENGTH: A length in the arguments was negative.
+ *
+ * @param decoded_length The length of the binary data.
+ * @param include_length_field If true, include a length field.
+ * @param layout The layout to encode into.
+ * @return The length of the laid out text, or a status code.
+ */
+SAFE85_PUBLIC int64_t safe85_get_encoded_length_with_layout(int64_t decoded_length,
+                                                            bool include_length_field,
+                                                            const safe85_layout* layout);
+
+/**
+ * Completely encodes some binary data, laid out into lines.
+ *
+ * The line breaks and indentation are written as the data is encoded, so
+ * there's no separate pass over the output. Every full line is followed by a
+ * line break and the next line's indentation, including the last one.
+ *
+ * Can return the following status codes:
+ *  * SAFE85_ERROR_INVALID_LENGTH: A length in the arguments was negative.
+ *  * SAFE85_ERROR_NOT_ENOUGH_ROOM: The destination buffer was not big enough.
+ *
+ * @param src_buffer The buffer containing the complete binary data.
+ * @param src_buffer_length The length in bytes of the data.
+ * @param dst_buffer A buffer to store the encoded text.
+ * @param dst_buffer_length The length of the destination buffer.
+ * @param layout The layout to encode into.
+ * @return The number of bytes written, or a status code.
+ */
+SAFE85_PUBLIC int64_t safe85_encode_with_layout(const uint8_t* src_buffer,
+                                                int64_t src_buffer_length,
+                                                uint8_t* dst_buffer,
+                                                int64_t dst_buffer_length,
+                                                const safe85_layout* layout);
+
+/**
+ * Works out the layout of some encoded text from its first lines: the
+ * indentation is the number of spaces it starts with, and the line length is
+ * the number of characters up to the first line break. Text that has no line
+ * break is a single line (line_length 0).
+ *
+ * Can return the following status codes:
+ *  * SAFE85_ERROR_INVALID_LENGTH: src_buffer_length was negative.
+ *  * SAFE85_ERROR_INVALID_SOURCE_DATA: The text doesn't start with regular lines.
+ *
+ * @param src_buffer The buffer containing the encoded text.
+ * @param src_buffer_length The length of the encoded text.
+ * @param layout The detected layout (set on success).
+ * @return The status.
+ */
+SAFE85_PUBLIC safe85_status safe85_detect_layout(const uint8_t* src_buffer,
+                                                 int64_t src_buffer_length,
+                                                 safe85_layout* layout);
+
+/**
+ * Completely decodes a safe85 sequence that's laid out into lines (such as by
+ * safe85_encode_with_layout()).
+ *
+ * For as long as the text follows the layout exactly, each line is decoded a
+ * whole group at a time, and the line breaks and indentation are skipped
+ * without examining them. From the first place where it doesn't (normally
+ * the last line), decoding carries on as safe85_decode() would. The result is
+ * always the same as safe85_decode()'s; the layout only affects speed.
+ *
+ * Pass NULL as the layout to detect it with safe85_detect_layout() (falling
+ * back to safe85_decode() if that fails). src_buffer and dst_buffer may be
+ * the same buffer.
+ *
+ * Can return the following status codes:
+ *  * SAFE85_ERROR_INVALID_LENGTH: A length in the arguments or layout was negative.
+ *  * SAFE85_ERROR_INVALID_SOURCE_DATA: The source buffer contained invalid data.
+ *  * SAFE85_ERROR_NOT_ENOUGH_ROOM: The destination buffer was not big enough.
+ *
+ * @param src_buffer The buffer containing the complete encoded text.
+ * @param src_buffer_length The length of the encoded text.
+ * @param dst_buffer A buffer to store the decoded data.
+ * @param dst_buffer_length The length of the destination buffer.
+ * @param layout The layout of the text, or NULL to detect it.
+ * @return The number of bytes written, or a status code.
+ */
+SAFE85_PUBLIC int64_t safe85_decode_with_layout(const uint8_t* src_buffer,
+                                                int64_t src_buffer_length,
+                                                uint8_t* dst_buffer,
+                                                int64_t dst_buffer_length,
+                                                const safe85_layout* layout);
+
+/**
+ * Decode part of a safe85 sequence that's laid out into lines.
+ * This works the same as safe85_decode_feed(), but takes the same fast path
+ * as safe85_decode_with_layout() for as long as the text follows the layout.
+ *
+ * The first feed must start at the beginning of the text. Unless stream_state
+ * marks the end of a stream, each feed stops after the last line break that
+ * falls on a group boundary, so that the next feed can keep following the
+ * layout. A NULL layout decodes exactly as safe85_decode_feed() does.
+ *
+ * Can return the same status codes as safe85_decode_feed().
+ *
+ * @param layout The layout of the text, or NULL.
+ * @param src_buffer_ptr Pointer to your source buffer pointer (input/output).
+ * @param src_length Length of the source buffer.
+ * @param dst_buffer_ptr Pointer to your destination buffer pointer (input/output).
+ * @param dst_length Length of the destination buffer.
+ * @param stream_state The current state of the source and destination streams.
+ * @return Status code indicating the result of the operation.
+ */
+SAFE85_PUBLIC safe85_status safe85_decode_with_layout_feed(const safe85_layout* layout,
+                                                          const uint8_t** src_buffer_ptr,
+                                                          int64_t src_length,
+                                                          uint8_t** dst_buffer_ptr,
+                                                          int64_t dst_length,
+                                                          safe85_stream_state stream_state);
+
+
+
+// -------------------
+// Seekable Containers
+// -------------------
+//
+// A seekable container splits the data into segments of a fixed decoded
+// length, each of which can be decoded independently (and in parallel), and
+// which are located using an index at the end. Everything is encoded in the
+// safe85 alphabet:
+//
+//   container = segment* index trailer
+//   segment   = safe85L sequence of up to segment_length bytes
+//   index     = safe85L sequence of 64-bit big endian values:
+//               segment_length, data_length, and the offset of each segment
+//   trailer   = safe85 sequence of the 64-bit big endian offset of the index
+//
+// Whitespace may appear anywhere (such as when the container is laid out into
+// lines), since the index records where each segment actually starts.
+
+/**
+ * Get the length of a seekable container holding the specified amount of data.
+ *
+ * Can return the following status codes:
+ *  * SAFE85_ERROR_INVALID_LENGTH: A length (including in the layout) was negative, or segment_length was 0.
+ *
+ * @param data_length The length of the data to store.
+ * @param segment_length The decoded length of each segment.
+ * @param layout The layout to encode into, or NULL for no whitespace.
+ * @return The encoded length of the container, or a status code.
+ */
+SAFE85_PUBLIC int64_t safe85_container_get_encoded_length(int64_t data_length,
+                                                          int64_t segment_length,
+                                                          const safe85_layout* layout);
+
+/**
+ * Encode some binary data into a seekable container.
+ *
+ * With a layout, the whole container is laid out into lines as
+ * safe85_encode_with_layout() would, and the index records each segment's
+ * offset within the laid out text.
+ *
+ * Can return the following status codes:
+ *  * SAFE85_ERROR_INVALID_LENGTH: A length (including in the layout) was negative, or segment_length was 0.
+ *  * SAFE85_ERROR_NOT_ENOUGH_ROOM: The destination buffer was not big enough.
+ *
+ * @param src_buffer The buffer containing the complete binary data.
+ * @param src_buffer_length The length in bytes of the data.
+ * @param segment_length The decoded length of each segment.
+ * @param dst_buffer A buffer to store the container.
+ * @param dst_buffer_length The length of the destination buffer.
+ * @param layout The layout to encode into, or NULL for no whitespace.
+ * @return The number of bytes written, or a status code.
+ */
+SAFE85_PUBLIC int64_t safe85_container_encode(const uint8_t* src_buffer,
+                                              int64_t src_buffer_length,
+                                              int64_t segment_length,
+                                              uint8_t* dst_buffer,
+                                              int64_t dst_buffer_length,
+                                              const safe85_layout* layout);
+
+/**
+ * Prepare a safe85_container_writer for writing a new seekable container in
+ * pieces, so that the data doesn't all have to be in memory at once.
+ *
+ * Can return the following status codes:
+ *  * SAFE85_ERROR_INVALID_LENGTH: A length (including in the layout) was negative, or segment_length was 0.
+ *
+ * @param writer The writer state.
+ * @param segment_length The decoded length of each segment.
+ * @param layout The layout to encode into, or NULL for no whitespace.
+ * @return Status code indicating the result of the operation.
+ */
+SAFE85_PUBLIC safe85_status safe85_container_writer_init(safe85_container_writer* writer,
+                                                         int64_t segment_length,
+                                                         const safe85_layout* layout);
+
+/**
+ * Write a seekable container in pieces.
+ * This is a lower level function for buffered I/O.
+ *
+ * Each segment is written as soon as its data arrives, and once the data has
+ * ended, the index and trailer follow. The output is the same as
+ * safe85_container_encode() would produce for all of the data.
+ *
+ * A segment only starts once all of its data is in the source buffer (or the
+ * data has ended), so the source buffer must have room for at least
+ * segment_length bytes. Any amount of destination room makes progress.
+ *
+ * Upon return:
+ *
+ *   src_buffer_ptr will point to the next byte it will read.
+ *   If it's not pointing to the end of the input buffer, the remaining
+ *   bytes need to be moved to the beginning of the buffer, and then more
+ *   input data added.
+ *
+ *   dst_buffer_ptr will point to one past the last byte written.
+ *
+ * Can return the following status codes:
+ *  * SAFE85_STATUS_OK: The whole container has been written.
+ *  * SAFE85_STATUS_PARTIALLY_COMPLETE: More data or destination room is needed.
+ *  * SAFE85_ERROR_INVALID_LENGTH: A length was negative.
+ *
+ * @param writer The writer state.
+ * @param src_buffer_ptr Pointer to your source buffer pointer (input/output).
+ * @param src_length Length of the source buffer.
+ * @param dst_buffer_ptr Pointer to your destination buffer pointer (input/output).
+ * @param dst_length Length of the destination buffer.
+ * @param is_end_of_data If true, this is the last packet of data to encode.
+ * @return Status code indicating the result of the operation.
+ */
+SAFE85_PUBLIC safe85_status safe85_container_writer_feed(safe85_container_writer* writer,
+                                                         const uint8_t** src_buffer_ptr,
+                                                         int64_t src_length,
+                                                         uint8_t** dst_buffer_ptr,
+                                                         int64_t dst_length,
+                                                         bool is_end_of_data);
+
+/**
+ * Read the index information of a seekable container.
+ *
+ * Can return the following status codes:
+ *  * SAFE85_ERROR_INVALID_LENGTH: The length was negative.
+ *  * SAFE85_ERROR_INVALID_SOURCE_DATA: The container structure was invalid.
+ *  * SAFE85_ERROR_TRUNCATED_DATA: The container was truncated.
+ *
+ * @param src_buffer The buffer containing the complete container.
+ * @param src_buffer_length The length in bytes of the container.
+ * @param container Where to store the container information.
+ * @return Status code indicating the result of the operation.
+ */
+SAFE85_PUBLIC safe85_status safe85_container_open(const uint8_t* src_buffer,
+                                                  int64_t src_buffer_length,
+                                                  safe85_container* container);
+
+/**
+ * Find the index of a seekable container from the end of the container, so
+ * that a container in a file can be opened without reading all of it:
+ * read the end of the file and pass it here, then read the index (which
+ * runs from the returned offset to trailer_offset) and pass it to
+ * safe85_container_open_index().
+ *
+ * Can return the following status codes:
+ *  * SAFE85_ERROR_INVALID_LENGTH: A length was negative, or end_buffer_length was greater than container_length.
+ *  * SAFE85_ERROR_INVALID_SOURCE_DATA: The trailer was invalid.
+ *  * SAFE85_ERROR_TRUNCATED_DATA: The end buffer didn't contain the whole trailer.
+ *
+ * @param end_buffer A buffer containing the end of the container.
+ * @param end_buffer_length The length in bytes of the end of the container.
+ * @param container_length The length in bytes of the whole container.
+ * @param trailer_offset Where to store the offset of the trailer.
+ * @return The offset of the index, or a status code.
+ */
+SAFE85_PUBLIC int64_t safe85_container_find_index(const uint8_t* end_buffer,
+                                                  int64_t end_buffer_length,
+                                                  int64_t container_length,
+                                                  int64_t* trailer_offset);
+
+/**
+ * Read the index information of a seekable container from just its index,
+ * as found by safe85_container_find_index().
+ *
+ * Can return the following status codes:
+ *  * SAFE85_ERROR_INVALID_LENGTH: A length or offset was negative.
+ *  * SAFE85_ERROR_INVALID_SOURCE_DATA: The index was invalid.
+ *
+ * @param index_buffer The buffer containing the index (up to the trailer).
+ * @param index_buffer_length The length in bytes of the index.
+ * @param index_offset The offset of the index within the container.
+ * @param container Where to store the container information.
+ * @return Status code indicating the result of the operation.
+ */
+SAFE85_PUBLIC safe85_status safe85_container_open_index(const uint8_t* index_buffer,
+                                                        int64_t index_buffer_length,
+                                                        int64_t index_offset,
+                                                        safe85_container* container);
+
+/**
+ * Find where a segment is in a seekable container, so that only that part
+ * needs to be read. The segment is a safe85l sequence (see safe85l_decode()),
+ * which may contain whitespace.
+ *
+ * Can return the following status codes:
+ *  * SAFE85_ERROR_INVALID_LENGTH: A length was negative, or the segment doesn't exist.
+ *  * SAFE85_ERROR_INVALID_SOURCE_DATA: The index was invalid.
+ *  * SAFE85_ERROR_TRUNCATED_DATA: The index was truncated.
+ *
+ * @param index_buffer The buffer containing the index (up to the trailer).
+ * @param index_buffer_length The length in bytes of the index.
+ * @param container The container information.
+ * @param segment_index The index of the segment to find.
+ * @param segment_offset Where to store the offset of the segment.
+ * @param segment_encoded_length Where to store the encoded length of the segment.
+ * @return Status code indicating the result of the operation.
+ */
+SAFE85_PUBLIC safe85_status safe85_container_locate_segment(const uint8_t* index_buffer,
+                                                            int64_t index_buffer_length,
+                                                            const safe85_container* container,
+                                                            int64_t segment_index,
+                                                            int64_t* segment_offset,
+                                                            int64_t* segment_encoded_length);
+
+/**
+ * Decode one segment of a seekable container.
+ * Segments can safely be decoded in parallel.
+ *
+ * Can return the following status codes:
+ *  * SAFE85_ERROR_INVALID_LENGTH: A length was negative, or the segment doesn't exist.
+ *  * SAFE85_ERROR_INVALID_SOURCE_DATA: The data was invalid.
+ *  * SAFE85_ERROR_TRUNCATED_DATA: The segment was truncated.
+ *  * SAFE85_ERROR_NOT_ENOUGH_ROOM: The destination buffer was not big enough.
+ *
+ * @param src_buffer The buffer containing the complete container.
+ * @param src_buffer_length The length in bytes of the container.
+ * @param container The container information from safe85_container_open().
+ * @param segment_index The index of the segment to decode.
+ * @param dst_buffer A buffer to store the decoded data.
+ * @param dst_buffer_length The length of the destination buffer.
+ * @return The number of bytes written, or a status code.
+ */
+SAFE85_PUBLIC int64_t safe85_container_decode_segment(const uint8_t* src_buffer,
+                                                      int64_t src_buffer_length,
+                                                      const safe85_container* container,
+                                                      int64_t segment_index,
+                                                      uint8_t* dst_buffer,
+                                                      int64_t dst_buffer_length);
+
+/**
+ * Decode a range of bytes from a seekable container. Only the segments that
+ * overlap the range get decoded.
+ *
+ * If the range extends past the end of the data, only the bytes up to the
+ * end are decoded.
+ *
+ * Can return the following status codes:
+ *  * SAFE85_ERROR_INVALID_LENGTH: A length or offset was negative.
+ *  * SAFE85_ERROR_INVALID_SOURCE_DATA: The data was invalid.
+ *  * SAFE85_ERROR_TRUNCATED_DATA: A segment was truncated.
+ *  * SAFE85_ERROR_NOT_ENOUGH_ROOM: dst_buffer_length is less than byte_count.
+ *
+ * @param src_buffer The buffer containing the complete container.
+ * @param src_buffer_length The length in bytes of the container.
+ * @param container The container information from safe85_container_open().
+ * @param byte_offset The offset of the first byte to decode.
+ * @param byte_count The number of bytes to decode.
+ * @param dst_buffer A buffer to store the decoded data.
+ * @param dst_buffer_length The length of the destination buffer.
+ * @return The number of bytes written, or a status code.
+ */
+SAFE85_PUBLIC int64_t safe85_container_decode_range(const uint8_t* src_buffer,
+                                                    int64_t src_buffer_length,
+                                                    const safe85_container* container,
+                                                    int64_t byte_offset,
+                                                    int64_t byte_count,
+                                                    uint8_t* dst_buffer,
+                                                    int64_t dst_buffer_length);
+
+
+
+// ----------------
+// Custom Alphabets
+// ----------------
+//
+// A custom alphabet encodes with a different set (or ordering) of 85
+// characters, for systems that need one. Everything else works the same as
+// with the safe85 alphabet, except that the sort order of the encoded data
+// follows the order of the custom characters.
+
+/**
+ * Build a custom alphabet. This computes the lookup tables once, so that
+ * encoding and decoding with the alphabet runs at the same speed as with the
+ * built-in one.
+ *
+ * Can return the following status codes:
+ *  * SAFE85_ERROR_INVALID_ALPHABET: chars does not contain exactly 85
+ *    distinct characters, or a whitespace or substitution character is
+ *    used more than once.
+ *
+ * @param alphabet The alphabet to initialize.
+ * @param chars The 85 characters to encode with, in order of value.
+ * @param whitespace The characters to ignore when decoding, or NULL for none.
+ * @param substitutions Pairs of characters, where the first character of
+ *                      each pair decodes the same as the second (which must
+ *                      be one of chars), or NULL for none.
+ * @return Status code indicating the result of the operation.
+ */
+SAFE85_PUBLIC safe85_status safe85_alphabet_init(safe85_alphabet* alphabet,
+                                                 const char* chars,
+                                                 const char* whitespace,
+                                                 const char* substitutions);
+
+/**
+ * Decode data encoded with a custom alphabet.
+ * This works the same as safe85_decode().
+ *
+ * @param alphabet The alphabet the data was encoded with.
+ * @param src_buffer The buffer containing the complete encoded data.
+ * @param src_buffer_length The length in bytes of the encoded data.
+ * @param dst_buffer A buffer to store the decoded data.
+ * @param dst_buffer_length The length of the destination buffer.
+ * @return The number of bytes written, or a status code.
+ */
+SAFE85_PUBLIC int64_t safe85_alphabet_decode(const safe85_alphabet* alphabet,
+                                             const uint8_t* src_buffer,
+                                             int64_t src_buffer_length,
+                                             uint8_t* dst_buffer,
+                                             int64_t dst_buffer_length);
+
+/**
+ * Encode data using a custom alphabet.
+ * This works the same as safe85_encode().
+ *
+ * @param alphabet The alphabet to encode with.
+ * @param src_buffer The buffer containing the complete binary data.
+ * @param src_buffer_length The length in bytes of the data.
+ * @param dst_buffer A buffer to store the encoded data.
+ * @param dst_buffer_length The length of the destination buffer.
+ * @return The number of bytes written, or a status code.
+ */
+SAFE85_PUBLIC int64_t safe85_alphabet_encode(const safe85_alphabet* alphabet,
+                                             const uint8_t* src_buffer,
+                                             int64_t src_buffer_length,
+                                             uint8_t* dst_buffer,
+                                             int64_t dst_buffer_length);
+
+/**
+ * Decode part of a stream of data encoded with a custom alphabet.
+ * This works the same as safe85_decode_feed().
+ *
+ * @param alphabet The alphabet the data was encoded with.
+ * @param src_buffer_ptr Pointer to your source buffer pointer (input/output).
+ * @param src_length Length of the source buffer.
+ * @param dst_buffer_ptr Pointer to your destination buffer pointer (input/output).
+ * @param dst_length Length of the destination buffer.
+ * @param stream_state The current state of the source and destination streams.
+ * @return Status code indicating the result of the operation.
+ */
+SAFE85_PUBLIC safe85_status safe85_alphabet_decode_feed(const safe85_alphabet* alphabet,
+                                                        const uint8_t** src_buffer_ptr,
+                                                        int64_t src_length,
+                                                        uint8_t** dst_buffer_ptr,
+                                                        int64_t dst_length,
+                                                        safe85_stream_state stream_state);
+
+/**
+ * Encode part of a stream of data using a custom alphabet.
+ * This works the same as safe85_encode_feed().
+ *
+ * @param alphabet The alphabet to encode with.
+ * @param src_buffer_ptr Pointer to your source buffer pointer (input/output).
+ * @param src_length Length of the source buffer.
+ * @param dst_buffer_ptr Pointer to your destination buffer pointer (input/output).
+ * @param dst_length Length of the destination buffer.
+ * @param is_end_of_data If true, this is the last packet of data to encode.
+ * @return Status code indicating the result of the operation.
+ */
+SAFE85_PUBLIC safe85_status safe85_alphabet_encode_feed(const safe85_alphabet* alphabet,
+                                                        const uint8_t** src_buffer_ptr,
+                                                        int64_t src_length,
+                                                        uint8_t** dst_buffer_ptr,
+                                                        int64_t dst_length,
+                                                        bool is_end_of_data);
+
+
+
+// ---------
+// Checksums
+// ---------
+
+// These functions calculate a CRC32C of the binary data while encoding or
+// decoding it, so that the data doesn't need to be read a second time to
+// verify it. The CRC32C is the same as calculated by safe85_crc32c(), and
+// uses the CPU's CRC instructions where available.
+
+/**
+ * Calculate a CRC32C (Castagnoli) of some data.
+ * To calculate the CRC32C of data that arrives in pieces, start with a crc of
+ * 0 and pass the result of each call to the next one.
+ *
+ * @param crc The CRC32C of the data so far (0 to start).
+ * @param buffer The data.
+ * @param length The length of the data.
+ * @return The CRC32C of the data so far, including this data.
+ */
+SAFE85_PUBLIC uint32_t safe85_crc32c(uint32_t crc, const uint8_t* buffer, int64_t length);
+
+/**
+ * Completely decodes a safe85 sequence, and calculates the CRC32C of the
+ * decoded data.
+ * This works the same as safe85_decode().
+ *
+ * @param src_buffer The buffer containing the complete encoded data.
+ * @param src_buffer_length The length in bytes of the encoded data.
+ * @param dst_buffer A buffer to store the decoded data.
+ * @param dst_buffer_length The length of the destination buffer.
+ * @param crc Where to store the CRC32C of the decoded data.
+ * @return The number of bytes written, or a status code.
+ */
+SAFE85_PUBLIC int64_t safe85_decode_crc32c(const uint8_t* src_buffer,
+                                           int64_t src_buffer_length,
+                                           uint8_t* dst_buffer,
+                                           int64_t dst_buffer_length,
+                                           uint32_t* crc);
+
+/**
+ * Completely encodes some binary data, and calculates its CRC32C.
+ * This works the same as safe85_encode().
+ *
+ * @param src_buffer The buffer containing the complete binary data.
+ * @param src_buffer_length The length in bytes of the data.
+ * @param dst_buffer A buffer to store the encoded data.
+ * @param dst_buffer_length The length of the destination buffer.
+ * @param crc Where to store the CRC32C of the binary data.
+ * @return The number of bytes written, or a status code.
+ */
+SAFE85_PUBLIC int64_t safe85_encode_crc32c(const uint8_t* src_buffer,
+                                           int64_t src_buffer_length,
+                                           uint8_t* dst_buffer,
+                                           int64_t dst_buffer_length,
+                                           uint32_t* crc);
+
+/**
+ * Decode part of a safe85 sequence, and add the decoded data to a CRC32C.
+ * This works the same as safe85_decode_feed().
+ *
+ * Set *crc to 0 before the first feed. Upon return, it contains the CRC32C
+ * of all of the data decoded so far.
+ *
+ * @param src_buffer_ptr Pointer to your source buffer pointer (input/output).
+ * @param src_length Length of the source buffer.
+ * @param dst_buffer_ptr Pointer to your destination buffer pointer (input/output).
+ * @param dst_length Length of the destination buffer.
+ * @param stream_state The current state of the source and destination streams.
+ * @param crc The CRC32C of the data so far (input/output).
+ * @return Status code indicating the result of the operation.
+ */
+SAFE85_PUBLIC safe85_status safe85_decode_feed_crc32c(const uint8_t** src_buffer_ptr,
+                                                      int64_t src_length,
+                                                      uint8_t** dst_buffer_ptr,
+                                                      int64_t dst_length,
+                                                      safe85_stream_state stream_state,
+                                                      uint32_t* crc);
+
+/**
+ * Encode part of a sequence of binary data, and add the data that was
+ * encoded to a CRC32C.
+ * This works the same as safe85_encode_feed().
+ *
+ * Set *crc to 0 before the first feed. Upon return, it contains the CRC32C
+ * of all of the data encoded so far.
+ *
+ * @param src_buffer_ptr Pointer to your source buffer pointer (input/output).
+ * @param src_length Length of the source buffer.
+ * @param dst_buffer_ptr Pointer to your destination buffer pointer (input/output).
+ * @param dst_length Length of the destination buffer.
+ * @param is_end_of_data If true, this is the last packet of data to encode.
+ * @param crc The CRC32C of the data so far (input/output).
+ * @return Status code indicating the result of the operation.
+ */
+SAFE85_PUBLIC safe85_status safe85_encode_feed_crc32c(const uint8_t** src_buffer_ptr,
+                                                      int64_t src_length,
+                                                      uint8_t** dst_buffer_ptr,
+                                                      int64_t dst_length,
+                                                      bool is_end_of_data,
+                                                      uint32_t* crc);
+
+
+
+// ------------
+// JSON Strings
+// ------------
+
+// None of the safe85 characters need escaping in JSON, so encoded data can be
+// written into and read out of JSON documents without an escaping pass.
+
+/**
+ * Get the length of binary data encoded as a JSON string (including the
+ * quotes).
+ *
+ * Can return the following status codes:
+ *  * SAFE85_ERROR_INVALID_LENGTH: The length was negative.
+ *
+ * @param decoded_length The length of the binary data.
+ * @return The length of the JSON string, or a status code.
+ */
+SAFE85_PUBLIC int64_t safe85_get_json_string_length(int64_t decoded_length);
+
+/**
+ * Completely encodes some binary data as a JSON string, including the
+ * surrounding quotes.
+ *
+ * Can return the following status codes:
+ *  * SAFE85_ERROR_INVALID_LENGTH: A length was negative.
+ *  * SAFE85_ERROR_NOT_ENOUGH_ROOM: The destination buffer was not big enough.
+ *
+ * @param src_buffer The buffer containing the complete binary data.
+ * @param src_buffer_length The length in bytes of the data.
+ * @param dst_buffer A buffer to store the JSON string.
+ * @param dst_buffer_length The length of the destination buffer.
+ * @return The number of bytes written, or a status code.
+ */
+SAFE85_PUBLIC int64_t safe85_encode_json_string(const uint8_t* src_buffer,
+                                                int64_t src_buffer_length,
+                                                uint8_t* dst_buffer,
+                                                int64_t dst_buffer_length);
+
+/**
+ * Decodes a JSON string value in place, directly in a JSON parser's input
+ * buffer. The buffer must start at the string's opening quote, and can
+ * contain more of the document after the string's closing quote.
+ *
+ * The decoded data is written over the start of the string, and the rest of
+ * the buffer is left alone. Escape sequences are not supported (they aren't
+ * needed for safe85 data).
+ *
+ * Can return the following status codes:
+ *  * SAFE85_ERROR_INVALID_LENGTH: The length was negative.
+ *  * SAFE85_ERROR_INVALID_SOURCE_DATA: The buffer didn't start with a quote,
+ *                                      or the string contained invalid data.
+ *  * SAFE85_ERROR_TRUNCATED_DATA: The string had no closing quote.
+ *
+ * @param buffer The buffer containing the JSON string (input/output).
+ * @param buffer_length The length of the buffer.
+ * @param string_length Where to store the length of the JSON string,
+ *                      including the quotes.
+ * @return The number of bytes decoded, or a status code.
+ */
+SAFE85_PUBLIC int64_t safe85_decode_json_string_in_place(uint8_t* buffer,
+                                                         int64_t buffer_length,
+                                                         int64_t* string_length);
+
+
+
+// ----------------
+// Standard Formats
+// ----------------
+
+// These functions convert directly between safe85 and the standard RFC 4648
+// encodings, without a separate buffer for the binary data in between (it
+// passes through a small tile on the stack instead).
+//
+// When transcoding from a standard format, whitespace is ignored and padding
+// is optional, but nothing other than padding and whitespace may follow the
+// first padding character.
+
+/**
+ * Get the maximum length of safe85 data transcoded from a standard format.
+ *
+ * Can return the following status codes:
+ *  * SAFE85_ERROR_INVALID_LENGTH: The length was negative.
+ *  * SAFE85_ERROR_INVALID_ALPHABET: The format was unknown.
+ *
+ * @param format The format to transcode from.
+ * @param src_length The length of the data in the standard format.
+ * @return The maximum length of the safe85 data, or a status code.
+ */
+SAFE85_PUBLIC int64_t safe85_get_transcoded_length_from_standard(safe85_standard_format format, int64_t src_length);
+
+/**
+ * Get the maximum length of standard format data transcoded from safe85.
+ *
+ * Can return the following status codes:
+ *  * SAFE85_ERROR_INVALID_LENGTH: The length was negative.
+ *  * SAFE85_ERROR_INVALID_ALPHABET: The format was unknown.
+ *
+ * @param format The format to transcode to.
+ * @param src_length The length of the safe85 data.
+ * @param use_padding If true, include padding characters.
+ * @return The maximum length of the data in the standard format, or a status code.
+ */
+SAFE85_PUBLIC int64_t safe85_get_transcoded_length_to_standard(safe85_standard_format format,
+                                                               int64_t src_length,
+                                                               bool use_padding);
+
+/**
+ * Completely transcodes data in a standard format to safe85.
+ *
+ * Can return the following status codes:
+ *  * SAFE85_ERROR_INVALID_LENGTH: A length was negative.
+ *  * SAFE85_ERROR_INVALID_ALPHABET: The format was unknown.
+ *  * SAFE85_ERROR_INVALID_SOURCE_DATA: The source contained invalid data.
+ *  * SAFE85_ERROR_TRUNCATED_DATA: The source ended partway through a byte.
+ *  * SAFE85_ERROR_NOT_ENOUGH_ROOM: The destination buffer was not big enough.
+ *
+ * @param format The format of the source data.
+ * @param src_buffer The buffer containing the data in the standard format.
+ * @param src_buffer_length The length in bytes of the data.
+ * @param dst_buffer A buffer to store the safe85 data.
+ * @param dst_buffer_length The length of the destination buffer.
+ * @return The number of bytes written, or a status code.
+ */
+SAFE85_PUBLIC int64_t safe85_transcode_from_standard(safe85_standard_format format,
+                                                     const uint8_t* src_buffer,
+                                                     int64_t src_buffer_length,
+                                                     uint8_t* dst_buffer,
+                                                     int64_t dst_buffer_length);
+
+/**
+ * Completely transcodes safe85 data to a standard format.
+ *
+ * Can return the following status codes:
+ *  * SAFE85_ERROR_INVALID_LENGTH: A length was negative.
+ *  * SAFE85_ERROR_INVALID_ALPHABET: The format was unknown.
+ *  * SAFE85_ERROR_INVALID_SOURCE_DATA: The source contained invalid data.
+ *  * SAFE85_ERROR_NOT_ENOUGH_ROOM: The destination buffer was not big enough.
+ *
+ * @param format The format to transcode to.
+ * @param use_padding If true, pad the output to a whole number of groups with '='.
+ * @param src_buffer The buffer containing the safe85 data.
+ * @param src_buffer_length The length in bytes of the data.
+ * @param dst_buffer A buffer to store the data in the standard format.
+ * @param dst_buffer_length The length of the destination buffer.
+ * @return The number of bytes written, or a status code.
+ */
+SAFE85_PUBLIC int64_t safe85_transcode_to_standard(safe85_standard_format format,
+                                                   bool use_padding,
+                                                   const uint8_t* src_buffer,
+                                                   int64_t src_buffer_length,
+                                                   uint8_t* dst_buffer,
+                                                   int64_t dst_buffer_length);
+
+/**
+ * Prepare a safe85_standard_transcoder for transcoding data in a standard
+ * format to safe85.
+ *
+ * Can return the following status codes:
+ *  * SAFE85_STATUS_OK: The transcoder is ready.
+ *  * SAFE85_ERROR_INVALID_ALPHABET: The format was unknown.
+ *
+ * @param transcoder The transcoder to initialize.
+ * @param format The format of the source data.
+ * @return Status code indicating the result of the operation.
+ */
+SAFE85_PUBLIC safe85_status safe85_standard_transcoder_init_from_standard(safe85_standard_transcoder* transcoder,
+                                                                          safe85_standard_format format);
+
+/**
+ * Prepare a safe85_standard_transcoder for transcoding safe85 data to a standard
+ * format.
+ *
+ * Can return the following status codes:
+ *  * SAFE85_STATUS_OK: The transcoder is ready.
+ *  * SAFE85_ERROR_INVALID_ALPHABET: The format was unknown.
+ *
+ * @param transcoder The transcoder to initialize.
+ * @param format The format to transcode to.
+ * @param use_padding If true, pad the output to a whole number of groups with '='.
+ * @return Status code indicating the result of the operation.
+ */
+SAFE85_PUBLIC safe85_status safe85_standard_transcoder_init_to_standard(safe85_standard_transcoder* transcoder,
+                                                                        safe85_standard_format format,
+                                                                        bool use_padding);
+
+/**
+ * Transcode part of a sequence between safe85 and a standard format, in the
+ * direction the transcoder was initialized for.
+ *
+ * This is a lower level function for buffered I/O.
+ *
+ * Binary data is held in the transcoder between calls, so there may be no
+ * output for small feeds. When transcoding to safe85, the destination buffer
+ * must have room for at least one safe85 group in order for progress to be
+ * made. When transcoding to a standard format, any room will do.
+ *
+ * Upon return:
+ *
+ *   src_buffer_ptr will point to the next character it will read.
+ *   If it's not pointing to the end of the input buffer, the remaining
+ *   characters need to be moved to the beginning of the buffer, and then more
+ *   input data added.
+ *
+ *   dst_buffer_ptr will point to one past the last byte written.
+ *
+ * Can return the following status codes:
+ *  * SAFE85_STATUS_OK: The entire sequence has been transcoded.
+ *  * SAFE85_STATUS_PARTIALLY_COMPLETE: More data or destination room is needed.
+ *  * SAFE85_ERROR_INVALID_LENGTH: A length was negative.
+ *  * SAFE85_ERROR_INVALID_SOURCE_DATA: The source contained invalid data.
+ *  * SAFE85_ERROR_TRUNCATED_DATA: The standard format data ended partway through a byte.
+ *
+ * @param transcoder The transcoder state.
+ * @param src_buffer_ptr Pointer to your source buffer pointer (input/output).
+ * @param src_length Length of the source buffer.
+ * @param dst_buffer_ptr Pointer to your destination buffer pointer (input/output).
+ * @param dst_length Length of the destination buffer.
+ * @param is_end_of_data If true, this is the last packet of data to transcode.
+ * @return Status code indicating the result of the operation.
+ */
+SAFE85_PUBLIC safe85_status safe85_standard_transcoder_feed(safe85_standard_transcoder* transcoder,
+                                                            const uint8_t** src_buffer_ptr,
+                                                            int64_t src_length,
+                                                            uint8_t** dst_buffer_ptr,
+                                                            int64_t dst_length,
+                                                            bool is_end_of_data);
+
+
+
+// -----------------
+// Codec Transcoding
+// -----------------
+
+// These functions transcode safe85 data directly into another of the safe
+// codecs, given that codec's encode function (for example safe64_encode).
+// The binary data passes through a small tile in multiples of every codec's
+// group size, so it never has to be held in full.
+//
+// To size the destination buffer, pass safe85_get_decoded_length() to the
+// other codec's get_encoded_length() (without a length field).
+
+/**
+ * Completely transcodes safe85 data into another codec.
+ *
+ * Can return the following status codes:
+ *  * SAFE85_ERROR_INVALID_LENGTH: A length was negative.
+ *  * SAFE85_ERROR_INVALID_SOURCE_DATA: The source contained invalid data.
+ *  * SAFE85_ERROR_NOT_ENOUGH_ROOM: The destination buffer was not big enough.
+ *
+ * @param encode The other codec's encode function.
+ * @param src_buffer The buffer containing the safe85 data.
+ * @param src_buffer_length The length in bytes of the data.
+ * @param dst_buffer A buffer to store the data in the other codec.
+ * @param dst_buffer_length The length of the destination buffer.
+ * @return The number of bytes written, or a status code.
+ */
+SAFE85_PUBLIC int64_t safe85_transcode(safe85_encode_function encode,
+                                       const uint8_t* src_buffer,
+                                       int64_t src_buffer_length,
+                                       uint8_t* dst_buffer,
+                                       int64_t dst_buffer_length);
+
+/**
+ * Prepare a safe85_transcoder for transcoding a new safe85 sequence.
+ *
+ * @param transcoder The transcoder to initialize.
+ * @param encode The other codec's encode function.
+ */
+SAFE85_PUBLIC void safe85_transcoder_init(safe85_transcoder* transcoder, safe85_encode_function encode);
+
+/**
+ * Transcode part of a safe85 sequence into another codec.
+ *
+ * This is a lower level function for buffered I/O.
+ *
+ * Decoded data is held in the transcoder until there's a tile's worth (or
+ * until the end of the data), so there may be no output for small feeds.
+ * The destination buffer must have room for at least 60 bytes of binary
+ * data encoded in the other codec in order for progress to be made.
+ *
+ * Upon return:
+ *
+ *   src_buffer_ptr will point to the next character it will read.
+ *   If it's not pointing to the end of the input buffer, the remaining
+ *   characters need to be moved to the beginning of the buffer, and then more
+ *   input data added.
+ *
+ *   dst_buffer_ptr will point to one past the last byte written.
+ *
+ * Can return the following status codes:
+ *  * SAFE85_STATUS_OK: The entire sequence has been transcoded.
+ *  * SAFE85_STATUS_PARTIALLY_COMPLETE: More data or destination room is needed.
+ *  * SAFE85_ERROR_INVALID_LENGTH: A length was negative.
+ *  * SAFE85_ERROR_INVALID_SOURCE_DATA: The data was invalid.
+ *
+ * @param transcoder The transcoder state.
+ * @param src_buffer_ptr Pointer to your source buffer pointer (input/output).
+ * @param src_length Length of the source buffer.
+ * @param dst_buffer_ptr Pointer to your destination buffer pointer (input/output).
+ * @param dst_length Length of the destination buffer.
+ * @param is_end_of_data If true, this is the last packet of data to transcode.
+ * @return Status code indicating the result of the operation.
+ */
+SAFE85_PUBLIC safe85_status safe85_transcoder_feed(safe85_transcoder* transcoder,
+                                                   const uint8_t** src_buffer_ptr,
+                                                   int64_t src_length,
+                                                   uint8_t** dst_buffer_ptr,
+                                                   int64_t dst_length,
+                                                   bool is_end_of_data);
+
+
+
+// -------------
+// Low Level API
+// -------------
+
+/**
+ * Read a length field from a buffer.
+ *
+ * Can return the following status codes:
+ *  * SAFE85_ERROR_INVALID_LENGTH: The buffer length was negative.
+ *  * SAFE85_ERROR_UNTERMINATED_LENGTH_FIELD: The length field is truncated.
+ *
+ * @param buffer Where to read the length field from.
+ * @param buffer_length Length of the buffer.
+ * @param length Pointer to where the length value should be stored.
+ * @return the number of bytes processed to read the length, or an error code.
+ */
+SAFE85_PUBLIC int64_t safe85_read_length_field(const uint8_t* buffer,
+                                               int64_t buffer_length,
+                                               int64_t* length);
+
+/**
+ * Decode part of a safe85 sequence.
+ *
+ * This is a lower level function for buffered I/O.
+ *
+ * Attempts to decode and write as much as it can based on the input data.
+ * This function will not attempt to write a trailing partial group unless
+ * stream_state contains SAFE85_SRC_IS_AT_END_OF_STREAM or SAFE85_DST_IS_AT_END_OF_STREAM.
+ *
+ * Upon return:
+ *
+ *   src_buffer_ptr will point to the next character it will read.
+ *   If it's not pointing to the end of the input buffer, the remaining
+ *   characters need to be moved to the beginning of the buffer, and then more
+ *   input data added.
+ *
+ *   dst_buffer_ptr will point to one past the last byte written.
+ *
+ * Can return the following status codes:
+ *  * SAFE85_STATUS_OK: The process completed successfully.
+ *  * SAFE85_STATUS_PARTIALLY_COMPLETE: The process completed, but not all data was written.
+ *  * SAFE85_ERROR_INVALID_LENGTH: A length was negative.
+ *  * SAFE85_ERROR_INVALID_SOURCE_DATA: The data was invalid.
+ *  * SAFE85_ERROR_NOT_ENOUGH_ROOM: The destination buffer was not big enough.
+ *  * SAFE85_ERROR_TRUNCATED_DATA: The source data was truncated.
+ *
+ * @param src_buffer_ptr Pointer to your source buffer pointer (input/output).
+ * @param src_length Length of the source buffer.
+ * @param dst_buffer_ptr Pointer to your destination buffer pointer (input/output).
+ * @param dst_length Length of the destination buffer.
+ * @param is_end_of_data If true, this is the last packet of data to decode.
+ * @return Status code indicating the result of the operation.
+ */
+SAFE85_PUBLIC safe85_status safe85_decode_feed(const uint8_t** src_buffer_ptr,
+                                               int64_t src_length,
+                                               uint8_t** dst_buffer_ptr,
+                                               int64_t dst_length,
+                                               safe85_stream_state stream_state);
+
+/**
+ * Prepare a safe85l_decoder for decoding a new safe85L sequence.
+ *
+ * @param decoder The decoder to initialize.
+ */
+SAFE85_PUBLIC void safe85l_decoder_init(safe85l_decoder* decoder);
+
+/**
+ * Decode part of a safe85L (safe85 + length) sequence.
+ *
+ * This is a lower level function for buffered I/O.
+ *
+ * The length field is parsed incrementally, so it may span multiple feeds.
+ * As soon as it has been read, decoder->declared_length holds the length of
+ * the decoded data. To find out the length before decoding any data (for
+ * example to preallocate), feed with a dst_length of 0.
+ *
+ * Decoding stops at the end of the sequence as specified by the length field.
+ * Any data following the sequence is left unconsumed.
+ *
+ * Upon return:
+ *
+ *   src_buffer_ptr will point to the next character it will read.
+ *   If it's not pointing to the end of the input buffer, the remaining
+ *   characters need to be moved to the beginning of the buffer, and then more
+ *   input data added.
+ *
+ *   dst_buffer_ptr will point to one past the last byte written.
+ *
+ * Can return the following status codes:
+ *  * SAFE85_STATUS_OK: The entire sequence has been decoded.
+ *  * SAFE85_STATUS_PARTIALLY_COMPLETE: More data is needed to complete the sequence.
+ *  * SAFE85_ERROR_INVALID_LENGTH: A length was negative.
+ *  * SAFE85_ERROR_INVALID_SOURCE_DATA: The data was invalid.
+ *  * SAFE85_ERROR_UNTERMINATED_LENGTH_FIELD: The source ended inside the length field.
+ *  * SAFE85_ERROR_TRUNCATED_DATA: The source ended before the declared length was decoded.
+ *
+ * @param decoder The decoder state.
+ * @param src_buffer_ptr Pointer to your source buffer pointer (input/output).
+ * @param src_length Length of the source buffer.
+ * @param dst_buffer_ptr Pointer to your destination buffer pointer (input/output).
+ * @param dst_length Length of the destination buffer.
+ * @param is_end_of_data If true, this is the last packet of data to decode.
+ * @return Status code indicating the result of the operation.
+ */
+SAFE85_PUBLIC safe85_status safe85l_decode_feed(safe85l_decoder* decoder,
+                                                const uint8_t** src_buffer_ptr,
+                                                int64_t src_length,
+                                                uint8_t** dst_buffer_ptr,
+                                                int64_t dst_length,
+                                                bool is_end_of_data);
+
+/**
+ * Write a length field to a buffer.
+ *
+ * Can return the following status codes:
+ *  * SAFE85_ERROR_INVALID_LENGTH: A length was negative.
+ *  * SAFE85_STATUS_NOT_ENOUGH_ROOM: The destination buffer was not big enough.
+ *
+ * @param length The length value to write.
+ * @param dst_buffer Where to write the length field.
+ * @param dst_buffer_length Length of the destination buffer.
+ * @return The number of bytes written, or an error code.
+ */
+SAFE85_PUBLIC int64_t safe85_write_length_field(int64_t length,
+                                                uint8_t* dst_buffer,
+                                                int64_t dst_buffer_length);
+
+/**
+ * Encode a partial sequence of binary data.
+ *
+ * This is a lower level function for buffered I/O.
+ *
+ * Attempts to encode and write as much as it can based on the input data.
+ * This function will not attempt to write a trailing partial group unless
+ * is_end_of_data is set.
+ *
+ * Upon return:
+ *
+ *   src_buffer_ptr will point to the next character it will read.
+ *   If it's not pointing to the end of the input buffer, the remaining
+ *   characters need to be moved to the beginning of the buffer, and then more
+ *   input data added.
+ *
+ *   dst_buffer_ptr will point to one past the last byte written.
+ *
+ * Can return the following status codes:
+ *  * SAFE85_STATUS_OK: The process completed successfully.
+ *  * SAFE85_STATUS_PARTIALLY_COMPLETE: The process completed, but not all data was written.
+ *  * SAFE85_ERROR_INVALID_LENGTH: A length was negative.
+ *
+ * @param src_buffer_ptr Pointer to your source buffer pointer (input/output).
+ * @param src_length Length of the source buffer.
+ * @param dst_buffer_ptr Pointer to your destination buffer pointer (input/output).
+ * @param dst_length Length of the destination buffer.
+ * @param is_end_of_data If true, this is the last packet of data to encode.
+ * @return Status code indicating the result of the operation.
+ */
+SAFE85_PUBLIC safe85_status safe85_encode_feed(const uint8_t** src_buffer_ptr,
+                                               int64_t src_length,
+                                               uint8_t** dst_buffer_ptr,
+                                               int64_t dst_length,
+                                               bool is_end_of_data);
+
+/**
+ * Prepare a safe85l_encoder for encoding a new safe85L sequence.
+ *
+ * Can return the following status codes:
+ *  * SAFE85_ERROR_INVALID_LENGTH: The length was negative.
+ *
+ * @param encoder The encoder to initialize.
+ * @param length The total length of the data that will be encoded.
+ * @return Status code indicating the result of the operation.
+ */
+SAFE85_PUBLIC safe85_status safe85l_encoder_init(safe85l_encoder* encoder, int64_t length);
+
+/**
+ * Encode part of a safe85L (safe85 + length) sequence.
+ *
+ * This is a lower level function for buffered I/O.
+ *
+ * The length field is written at the start of the first feed, after which
+ * the data can be fed in pieces of any size. Since the encoder knows where
+ * the data ends, the final partial group is written as soon as the last
+ * byte arrives.
+ *
+ * Upon return:
+ *
+ *   src_buffer_ptr will point to the next byte it will read.
+ *   If it's not pointing to the end of the input buffer, the remaining
+ *   bytes need to be moved to the beginning of the buffer, and then more
+ *   input data added.
+ *
+ *   dst_buffer_ptr will point to one past the last byte written.
+ *
+ * Can return the following status codes:
+ *  * SAFE85_STATUS_OK: The entire sequence has been encoded.
+ *  * SAFE85_STATUS_PARTIALLY_COMPLETE: More data is needed to complete the sequence.
+ *  * SAFE85_ERROR_INVALID_LENGTH: A length was negative.
+ *  * SAFE85_ERROR_NOT_ENOUGH_ROOM: The destination buffer can't hold the length field.
+ *  * SAFE85_ERROR_TOO_MUCH_DATA: More data was fed than the declared length.
+ *  * SAFE85_ERROR_TRUNCATED_DATA: The data ended before the declared length.
+ *
+ * @param encoder The encoder state.
+ * @param src_buffer_ptr Pointer to your source buffer pointer (input/output).
+ * @param src_length Length of the source buffer.
+ * @param dst_buffer_ptr Pointer to your destination buffer pointer (input/output).
+ * @param dst_length Length of the destination buffer.
+ * @param is_end_of_data If true, this is the last packet of data to encode.
+ * @return Status code indicating the result of the operation.
+ */
+SAFE85_PUBLIC safe85_status safe85l_encode_feed(safe85l_encoder* encoder,
+                                                const uint8_t** src_buffer_ptr,
+                                                int64_t src_length,
+                                                uint8_t** dst_buffer_ptr,
+                                                int64_t dst_length,
+                                                bool is_end_of_data);
+
+/**
+ * Prepare a safe85_layout_encoder for encoding a new safe85 sequence.
+ *
+ * Can return the following status codes:
+ *  * SAFE85_ERROR_INVALID_LENGTH: A length in the layout was negative.
+ *
+ * @param encoder The encoder to initialize.
+ * @param layout The layout to encode into.
+ * @return Status code indicating the result of the operation.
+ */
+SAFE85_PUBLIC safe85_status safe85_layout_encoder_init(safe85_layout_encoder* encoder, const safe85_layout* layout);
+
+/**
+ * Prepare a safe85_layout_encoder for encoding a new safe85L (safe85 +
+ * length) sequence.
+ *
+ * Can return the following status codes:
+ *  * SAFE85_ERROR_INVALID_LENGTH: The length or a length in the layout was negative.
+ *
+ * @param encoder The encoder to initialize.
+ * @param layout The layout to encode into.
+ * @param length The total length of the data that will be encoded.
+ * @return Status code indicating the result of the operation.
+ */
+SAFE85_PUBLIC safe85_status safe85l_layout_encoder_init(safe85_layout_encoder* encoder,
+                                                        const safe85_layout* layout,
+                                                        int64_t length);
+
+/**
+ * Encode part of a sequence, laid out into lines.
+ *
+ * This is a lower level function for buffered I/O.
+ *
+ * Works like safe85_encode_feed() (or safe85l_encode_feed() if the encoder
+ * was initialized with a length), except that the output is laid out as
+ * described by the encoder's layout. Line breaks, indentation and groups
+ * that don't fit are written in pieces, so a destination buffer of any size
+ * makes progress.
+ *
+ * Upon return:
+ *
+ *   src_buffer_ptr will point to the next byte it will read.
+ *   If it's not pointing to the end of the input buffer, the remaining
+ *   bytes need to be moved to the beginning of the buffer, and then more
+ *   input data added.
+ *
+ *   dst_buffer_ptr will point to one past the last byte written.
+ *
+ * Can return the following status codes:
+ *  * SAFE85_STATUS_OK: The process completed successfully.
+ *  * SAFE85_STATUS_PARTIALLY_COMPLETE: Not all data was written (or with a
+ *                                      length, more data is needed).
+ *  * SAFE85_ERROR_INVALID_LENGTH: A length was negative.
+ *  * SAFE85_ERROR_TOO_MUCH_DATA: More data was fed than the declared length.
+ *  * SAFE85_ERROR_TRUNCATED_DATA: The data ended before the declared length.
+ *
+ * @param encoder The encoder state.
+ * @param src_buffer_ptr Pointer to your source buffer pointer (input/output).
+ * @param src_length Length of the source buffer.
+ * @param dst_buffer_ptr Pointer to your destination buffer pointer (input/output).
+ * @param dst_length Length of the destination buffer.
+ * @param is_end_of_data If true, this is the last packet of data to encode.
+ * @return Status code indicating the result of the operation.
+ */
+SAFE85_PUBLIC safe85_status safe85_layout_encoder_feed(safe85_layout_encoder* encoder,
+                                                       const uint8_t** src_buffer_ptr,
+                                                       int64_t src_length,
+                                                       uint8_t** dst_buffer_ptr,
+                                                       int64_t dst_length,
+                                                       bool is_end_of_data);
 
 
 #ifdef __cplusplus 
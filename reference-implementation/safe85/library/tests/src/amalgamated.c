@@ -0,0 +1,4 @@
+// Compiles the library from the generated single header rather than from
+// src/library.c, so that the test suite exercises the amalgamated build.
+#define SAFE85_IMPLEMENTATION
+#include "safe85_amalgamated.h"
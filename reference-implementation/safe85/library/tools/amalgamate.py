@@ -0,0 +1 @@
+../../../common/tools/amalgamate.py
\ No newline at end of file